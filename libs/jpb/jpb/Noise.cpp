@@ -1,6 +1,14 @@
 #include <xmmintrin.h>
+#include <intrin.h>
 #include <string>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cfloat>
+#include <assert.h>
 #include "Noise.h"
 #include "SimpleParser.h"
 #include "Profiler.h"
@@ -248,12 +256,26 @@ Noise::perlinFast(const Vec2f points[], real32 frequency)
 real32
 Noise::sumPerlin(const Vec2f& point, const NoiseParams& noiseParams)
 {
+  real32 frequency = noiseParams.frequency;
+  real32 lacunarity = noiseParams.lacunarity;
+  real32 persistence = noiseParams.persistence;
+
+  // Common octave counts go to unrolled versions
+  switch(noiseParams.octaves)
+  {
+  case 1: return fractalPerlin<1>(point, frequency, lacunarity, persistence);
+  case 2: return fractalPerlin<2>(point, frequency, lacunarity, persistence);
+  case 3: return fractalPerlin<3>(point, frequency, lacunarity, persistence);
+  case 4: return fractalPerlin<4>(point, frequency, lacunarity, persistence);
+  case 5: return fractalPerlin<5>(point, frequency, lacunarity, persistence);
+  case 6: return fractalPerlin<6>(point, frequency, lacunarity, persistence);
+  case 7: return fractalPerlin<7>(point, frequency, lacunarity, persistence);
+  case 8: return fractalPerlin<8>(point, frequency, lacunarity, persistence);
+  }
 
   real32 amplitude = 1.0f;
   real32 range = 0;
 
-  real32 frequency = noiseParams.frequency;
-
   real32 sum = 0;
   for(int32 i = 0; i < noiseParams.octaves; i++)
   {
@@ -270,10 +292,41 @@ Noise::sumPerlin(const Vec2f& point, const NoiseParams& noiseParams)
   return sum/range;
 }
 
+template <FRACTAL_MODE fractalMode>
+static bool
+sumPerlinFastUnrolled(const Vec2f points[], const NoiseParams& noiseParams, Vec4f& result)
+{
+  real32 frequency = noiseParams.frequency;
+  real32 lacunarity = noiseParams.lacunarity;
+  real32 persistence = noiseParams.persistence;
+
+  switch(noiseParams.octaves)
+  {
+  case 1: result = Noise::fractalPerlinFast<1, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 2: result = Noise::fractalPerlinFast<2, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 3: result = Noise::fractalPerlinFast<3, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 4: result = Noise::fractalPerlinFast<4, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 5: result = Noise::fractalPerlinFast<5, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 6: result = Noise::fractalPerlinFast<6, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 7: result = Noise::fractalPerlinFast<7, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  case 8: result = Noise::fractalPerlinFast<8, fractalMode>(points, frequency, lacunarity, persistence); return true;
+  }
+
+  return false;
+}
+
 Vec4f
 Noise::sumPerlinFast(const Vec2f points[], const NoiseParams& noiseParams)
 {
   Vec4f result;
+
+  // Common octave counts go to unrolled versions, the loop handles the rest
+  if(noiseParams.extraParam == 0)
+  {
+    if(sumPerlinFastUnrolled<FM_FBM>(points, noiseParams, result)) return result;
+  }
+  else if(sumPerlinFastUnrolled<FM_RIDGED>(points, noiseParams, result)) return result;
+
   Vec4f sum;
 
   real32 amplitude = 1.0f;
@@ -294,10 +347,10 @@ Noise::sumPerlinFast(const Vec2f points[], const NoiseParams& noiseParams)
       sum += octaveResult * amplitude;
     else
     {
-      octaveResult.x = 1.0f - abs(octaveResult.x);
-      octaveResult.y = 1.0f - abs(octaveResult.y);
-      octaveResult.z = 1.0f - abs(octaveResult.z);
-      octaveResult.w = 1.0f - abs(octaveResult.w);
+      octaveResult.x = 1.0f - fabsf(octaveResult.x);
+      octaveResult.y = 1.0f - fabsf(octaveResult.y);
+      octaveResult.z = 1.0f - fabsf(octaveResult.z);
+      octaveResult.w = 1.0f - fabsf(octaveResult.w);
 
       sum += octaveResult * amplitude;
     }
@@ -337,32 +390,47 @@ Noise::worley(Vec2f point, real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TY
 {
   point *= frequency;
 
-  Vec2i currentChunkPosition = Vec2i(floor(point.x), floor(point.y));
+  const WorleyCell* worleyCells = getWorleyCells();
 
-  std::list<real32> distanceList;
-  for(auto it = chunksToCheck.begin(); it != chunksToCheck.end(); it++)
+  int32 cellX = (int32)floor(point.x);
+  int32 cellY = (int32)floor(point.y);
+
+  // Two smallest distances from 3x3 neighbourhood
+  real32 f1 = FLT_MAX;
+  real32 f2 = FLT_MAX;
+  int32 pointCount = 0;
+
+  for(int32 y = cellY - 1; y <= cellY + 1; y++)
   {
-    Vec2i& chunkOffset = *it;
-    std::vector<Vec2f> cubeMarksOffset = worleyGetPoints(currentChunkPosition + chunkOffset);
-    addDistances(point, cubeMarksOffset, distanceList, distanceType);
-  }
+    for(int32 x = cellX - 1; x <= cellX + 1; x++)
+    {
+      const WorleyCell& cell = worleyCells[getCellHash(x, y)];
+      pointCount += cell.pointCount;
 
-  distanceList.sort();
+      for(int32 i = 0; i < cell.pointCount; i++)
+      {
+	real32 deltaX = point.x - ((real32)x + cell.points[i].x);
+	real32 deltaY = point.y - ((real32)y + cell.points[i].y);
 
-  real32 f1 = 0;
-  real32 f2 = 1.0f;
+	real32 distance = getWorleyDistance(deltaX, deltaY, distanceType);
 
-  if(distanceList.size() > 1)
-  {
-    f1 = *distanceList.begin();
-    f2 = *(++distanceList.begin());
+	if(distance < f1)
+	{
+	  f2 = f1;
+	  f1 = distance;
+	}
+	else if(distance < f2) f2 = distance;
+      }
+    }
   }
-  else
+
+  if(pointCount < 2)
   {
-    std::cout << "we";
+    f1 = 0;
+    f2 = 1.0f;
   }
 
-  real32 worleyResult;
+  real32 worleyResult = 0;
 
   switch (worleyType)
   {
@@ -377,44 +445,187 @@ Noise::worley(Vec2f point, real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TY
   return worleyResult;
 }
 
-std::vector<Vec2f>
-Noise::worleyGetPoints(Vec2i cubePosition)
+Vec4f
+Noise::worleyFast(const Vec2f points[], real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TYPE distanceType)
 {
-  static real32 lambda = 2.0f;
-  static int32 numbOfFeaturePoints = 8;
+  static const __m128 maxDistance = _mm_set1_ps(FLT_MAX);
+  static const __m128 signMask = _mm_set1_ps(-0.0f);
 
-  static real32 probabilities[8] = {poisson(lambda, 0), poisson(lambda, 1), poisson(lambda, 2), poisson(lambda, 3),
-				    poisson(lambda, 4), poisson(lambda, 5), poisson(lambda, 6), poisson(lambda, 7)};
+  const WorleyCell* worleyCells = getWorleyCells();
 
-  // for(int i = 0; i < numbOfFeaturePoints; i++)
-  // {
-  //   std::cout << i << " " << probabilities[i] << std::endl;
-  // }
+  real32 pointX[4];
+  real32 pointY[4];
+  int32 cellX[4];
+  int32 cellY[4];
+  int32 pointCount[4] = {};
 
-  std::vector<Vec2f> result;
-  int32 cubeHash = hash[(hash[cubePosition.x & hashMask] + hash[cubePosition.y & hashMask]) & hashMask];
-  real32 normalizedHash = (real32)cubeHash / 255.0f;
+  for(int i = 0; i < 4; i++)
+  {
+    pointX[i] = points[i].x * frequency;
+    pointY[i] = points[i].y * frequency;
+    cellX[i] = (int32)floor(pointX[i]);
+    cellY[i] = (int32)floor(pointY[i]);
+  }
 
-  real32 currentSum = 0;
-  int32 numbOfPoints = 0;
-  for(int i = 0; i < numbOfFeaturePoints; i++)
+  __m128 pointsX = _mm_loadu_ps(pointX);
+  __m128 pointsY = _mm_loadu_ps(pointY);
+
+  __m128 f1 = maxDistance;
+  __m128 f2 = maxDistance;
+
+  for(int32 offsetY = -1; offsetY <= 1; offsetY++)
   {
-    currentSum += probabilities[i];
-    if(normalizedHash < currentSum)
+    for(int32 offsetX = -1; offsetX <= 1; offsetX++)
     {
-      numbOfPoints = i;
-      break;
+      const WorleyCell* cells[4];
+      int32 cellPointsMax = 0;
+
+      for(int i = 0; i < 4; i++)
+      {
+	cells[i] = &worleyCells[getCellHash(cellX[i] + offsetX, cellY[i] + offsetY)];
+	pointCount[i] += cells[i]->pointCount;
+	if(cells[i]->pointCount > cellPointsMax) cellPointsMax = cells[i]->pointCount;
+      }
+
+      __m128 cornerX = _mm_setr_ps((real32)(cellX[0] + offsetX), (real32)(cellX[1] + offsetX),
+				   (real32)(cellX[2] + offsetX), (real32)(cellX[3] + offsetX));
+      __m128 cornerY = _mm_setr_ps((real32)(cellY[0] + offsetY), (real32)(cellY[1] + offsetY),
+				   (real32)(cellY[2] + offsetY), (real32)(cellY[3] + offsetY));
+      __m128i cellPointCount = _mm_setr_epi32(cells[0]->pointCount, cells[1]->pointCount,
+					      cells[2]->pointCount, cells[3]->pointCount);
+
+      // Lanes run up to the longest point list, missing points are masked out
+      for(int32 j = 0; j < cellPointsMax; j++)
+      {
+	__m128 markX = _mm_add_ps(cornerX, _mm_setr_ps(cells[0]->points[j].x, cells[1]->points[j].x,
+						      cells[2]->points[j].x, cells[3]->points[j].x));
+	__m128 markY = _mm_add_ps(cornerY, _mm_setr_ps(cells[0]->points[j].y, cells[1]->points[j].y,
+						      cells[2]->points[j].y, cells[3]->points[j].y));
+
+	__m128 deltaX = _mm_sub_ps(pointsX, markX);
+	__m128 deltaY = _mm_sub_ps(pointsY, markY);
+	__m128 distance;
+
+	switch(distanceType)
+	{
+	case DT_EUCLDIAN_SQUARED :
+	case DT_MANHATTAN_SQUARED :
+	  distance = _mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY)); break;
+	case DT_MANHATTAN :
+	  distance = _mm_add_ps(_mm_andnot_ps(signMask, deltaX), _mm_andnot_ps(signMask, deltaY)); break;
+	case DT_EUCLIDIAN :
+	  distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY))); break;
+	case DT_CHEBYSHEV_MAX :
+	  distance = _mm_max_ps(_mm_andnot_ps(signMask, deltaX), _mm_andnot_ps(signMask, deltaY)); break;
+	case DT_CHEBYSHEV_MIN :
+	  distance = _mm_min_ps(_mm_andnot_ps(signMask, deltaX), _mm_andnot_ps(signMask, deltaY)); break;
+	default :
+	  distance = maxDistance;
+	}
+
+	__m128 validPoint = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_set1_epi32(j), cellPointCount));
+	distance = _mm_or_ps(_mm_and_ps(validPoint, distance), _mm_andnot_ps(validPoint, maxDistance));
+
+	// Same as the branches in worley
+	f2 = _mm_min_ps(f2, _mm_max_ps(f1, distance));
+	f1 = _mm_min_ps(f1, distance);
+      }
     }
   }
 
-  // std::cout << numbOfPoints << std::endl;
+  Vec4f f1Result = storeVec4f(f1);
+  Vec4f f2Result = storeVec4f(f2);
+
+  Vec4f result;
+  for(int i = 0; i < 4; i++)
+  {
+    if(pointCount[i] < 2)
+    {
+      f1Result[i] = 0;
+      f2Result[i] = 1.0f;
+    }
+
+    switch (worleyType)
+    {
+    case WT_F2SUBF1: result[i] = f2Result[i] - f1Result[i]; break;
+    case WT_F1: result[i] = f1Result[i]; break;
+    case WT_F2: result[i] = f2Result[i]; break;
+    case WT_F2ADDF1: result[i] = f2Result[i] + f1Result[i]; break;
+    case WT_F1MULF2: result[i] = f1Result[i] * f2Result[i]; break;
+    }
+  }
+
+  return result;
+}
+
+real32
+Noise::getWorleyDistance(real32 deltaX, real32 deltaY, DISTANCE_TYPE distanceType)
+{
+  real32 absX = fabsf(deltaX);
+  real32 absY = fabsf(deltaY);
+
+  switch(distanceType)
+  {
+  case DT_EUCLDIAN_SQUARED :
+  case DT_MANHATTAN_SQUARED : return (deltaX * deltaX) + (deltaY * deltaY);
+  case DT_MANHATTAN : return absX + absY;
+  case DT_EUCLIDIAN : return sqrtf((deltaX * deltaX) + (deltaY * deltaY));
+  case DT_CHEBYSHEV_MAX : return absX > absY ? absX : absY;
+  case DT_CHEBYSHEV_MIN : return absX < absY ? absX : absY;
+  }
+
+  return FLT_MAX;
+}
+
+const Noise::WorleyCell*
+Noise::getWorleyCells()
+{
+  // Built on first use, static initialization is thread safe
+  static std::vector<WorleyCell> worleyCells = buildWorleyCells();
+  return worleyCells.data();
+}
+
+std::vector<Noise::WorleyCell>
+Noise::buildWorleyCells()
+{
+  static const real32 lambda = 2.0f;
+  static const int32 numbOfFeaturePoints = 8;
+
+  real32 probabilities[numbOfFeaturePoints];
+  for(int i = 0; i < numbOfFeaturePoints; i++)
+  {
+    probabilities[i] = poisson(lambda, (real32)i);
+  }
 
-  result.resize(numbOfPoints);
-  srand(cubeHash);
+  std::vector<WorleyCell> result;
+  result.resize(hashMask + 1);
 
-  for(int i = 0; i < numbOfPoints ; i++ )
+  for(int32 cubeHash = 0; cubeHash <= hashMask; cubeHash++)
   {
-    result[i] = Vec2f(cubePosition.x + getRandNormalized(), cubePosition.y + getRandNormalized());
+    WorleyCell& cell = result[cubeHash];
+    real32 normalizedHash = (real32)cubeHash / 255.0f;
+
+    // Poisson distributed number of points
+    real32 currentSum = 0;
+    cell.pointCount = 0;
+    for(int i = 0; i < numbOfFeaturePoints; i++)
+    {
+      currentSum += probabilities[i];
+      if(normalizedHash < currentSum)
+      {
+	cell.pointCount = i;
+	break;
+      }
+    }
+
+    assert(cell.pointCount <= maxWorleyPoints);
+
+    // Seeding with cell hash keeps the points the same as they were when generated per cell
+    srand(cubeHash);
+    for(int i = 0; i < cell.pointCount ; i++ )
+    {
+      cell.points[i] = Vec2f(getRandNormalized(), getRandNormalized());
+    }
   }
 
   return result;
@@ -465,6 +676,95 @@ Noise::sumWorley(const Vec2f& point, const NoiseParams& noiseParams)
   return sum / range;
 }
 
+Vec4f
+Noise::sumWorleyFast(const Vec2f points[], const NoiseParams& noiseParams)
+{
+  real32 amplitude = 1.0f;
+  real32 range = 0;
+
+  real32 frequency = noiseParams.frequency;
+
+  Vec4f sum;
+  for(int32 i = 0; i < noiseParams.octaves; i++)
+  {
+    range += amplitude;
+    sum += worleyFast(points, frequency, (WORLEY_TYPE)noiseParams.extraParam, (DISTANCE_TYPE)noiseParams.extraParam2) * amplitude;
+
+    frequency *= noiseParams.lacunarity;
+    amplitude *= noiseParams.persistence;
+  }
+
+  return sum / range;
+}
+
+void
+Noise::sumPerlin8(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[])
+{
+  if(useAvx2())
+  {
+    sumPerlinAvx2(points, noiseParams, result);
+    return;
+  }
+
+  result[0] = sumPerlinFast(points, noiseParams);
+  result[1] = sumPerlinFast(points + 4, noiseParams);
+}
+
+void
+Noise::sumValue8(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[])
+{
+  if(useAvx2())
+  {
+    sumValueAvx2(points, noiseParams, result);
+    return;
+  }
+
+  for(int i = 0; i < 8; i++)
+  {
+    result[i / 4][i % 4] = sumValue(points[i], noiseParams);
+  }
+}
+
+void
+Noise::sumWorley8(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[])
+{
+  if(useAvx2())
+  {
+    sumWorleyAvx2(points, noiseParams, result);
+    return;
+  }
+
+  result[0] = sumWorleyFast(points, noiseParams);
+  result[1] = sumWorleyFast(points + 4, noiseParams);
+}
+
+static bool
+detectAvx2()
+{
+  int32 cpuInfo[4];
+  __cpuid(cpuInfo, 0);
+  if(cpuInfo[0] < 7) return false;
+
+  __cpuid(cpuInfo, 1);
+  bool hasOsxsave = (cpuInfo[2] & (1 << 27)) != 0;
+  bool hasAvx = (cpuInfo[2] & (1 << 28)) != 0;
+  if(!hasOsxsave || !hasAvx) return false;
+
+  // OS has to save YMM registers on context switch
+  unsigned long long xcrFeatureMask = _xgetbv(0);
+  if((xcrFeatureMask & 0x6) != 0x6) return false;
+
+  __cpuidex(cpuInfo, 7, 0);
+  return (cpuInfo[1] & (1 << 5)) != 0;
+}
+
+bool
+Noise::isAvx2Supported()
+{
+  static bool supported = detectAvx2();
+  return supported;
+}
+
 real32
 Noise::getClosest(const Vec2f& point, std::vector<Vec2f>& marks)
 {
@@ -499,33 +799,6 @@ Noise::getClosest(const Vec2f& point, std::vector<Vec2f>& marks)
   return distanceToClosest;
 }
 
-void
-Noise::addDistances(const Vec2f& point, std::vector<Vec2f>& marks, std::list<real32>& distanceList, DISTANCE_TYPE distanceType)
-{
-  Vec2i currentCubePosition = Vec2i(floor(point.x), floor(point.y));
-
-  for(auto it = marks.begin(); it != marks.end(); it++)
-  {
-    const Vec2f& mark = *it;
-
-    Vec2f deltaVector = (point - mark);
-
-    real32 distance;
-
-    switch(distanceType)
-    {
-    case DT_EUCLDIAN_SQUARED : distance = (deltaVector.x * deltaVector.x) + (deltaVector.y * deltaVector.y); break;
-    case DT_MANHATTAN : distance = abs(deltaVector.x) + abs(deltaVector.y); break;
-    case DT_EUCLIDIAN : distance = deltaVector.getLength(); break;
-    case DT_MANHATTAN_SQUARED : distance = abs(deltaVector.x * deltaVector.x) + abs(deltaVector.y * deltaVector.y); break;
-    case DT_CHEBYSHEV_MAX : distance = max(abs(deltaVector.x), abs(deltaVector.y)); break;
-    case DT_CHEBYSHEV_MIN : distance = min(abs(deltaVector.x), abs(deltaVector.y)); break;
-    }
-
-    distanceList.push_back(distance);
-  }
-}
-
 std::vector<Vec4f>
 Noise::getMap(Vec2f offset, int32 sideLength, std::list<GenData>& genDatas,
 	      const std::string& expression)
@@ -542,17 +815,23 @@ Noise::getMap(Vec2f offset, int32 sideLength, std::list<GenData>& genDatas,
   Vec2f point01 = Vec2f(-0.5f, -0.5f);
   Vec2f point11 = Vec2f(0.5f, -0.5f);
 
-  std::vector<float> values;
-  values.resize(genDatas.size());
-
   // Parser Stuff ----------------
+  // Slots are Map1 - MapN followed by x and y
+  int32 xSlot = genDatas.size();
+  int32 ySlot = xSlot + 1;
+
+  SlotNameList slotNames;
+  for(int32 j = 0; j < genDatas.size(); j++)
+    slotNames.push_back("Map" + std::to_string(j+1));
+  slotNames.push_back("x");
+  slotNames.push_back("y");
+
   SimpleParser simpleParser;
-  VariableMap variableMap;
-  simpleParser.setVariableMap(&variableMap);
-  EntryList reversePolish = simpleParser.getReversePolish(expression);
+  CompiledExpression compiledExpression = simpleParser.compile(expression, slotNames);
   // -----------------------------
 
-  std::vector<VariableMap> variableMapBuffer;
+  std::vector<real32> slots;
+  slots.resize(slotNames.size());
 
   for(int32 y = 0; y < sideLength; y++)
   {
@@ -565,24 +844,16 @@ Noise::getMap(Vec2f offset, int32 sideLength, std::list<GenData>& genDatas,
       Vec2f point = Vec2f::lerp(point0, point1, ((float)x) * stepSize);
       Vec2f realPosition = point + offset;
 
-      for(auto it = genDatas.begin(); it != genDatas.end(); it++)
+      int32 index = 0;
+      for(auto it = genDatas.begin(); it != genDatas.end(); it++, index++)
       {
-	int index = std::distance(genDatas.begin(), it);
-	values[index] = (Noise::sumPerlin(realPosition, it->noiseParams) * 0.5f + 0.5f) * it->scale;
+	slots[index] = (Noise::sumPerlin(realPosition, it->noiseParams) * 0.5f + 0.5f) * it->scale;
       }
 
-      real32 finalValue = 0;
+      slots[xSlot] = realPosition.x;
+      slots[ySlot] = realPosition.y;
 
-      for(int32 j = 0; j < genDatas.size(); j++)
-      {
-	variableMap["Map" + std::to_string(j+1)] = &values[j];
-      }
-
-      variableMap["x"] = &realPosition.x;
-      variableMap["y"] = &realPosition.y;
-
-      EntryList reversePolishCopy = reversePolish;
-      finalValue = simpleParser.evaluateExpression(reversePolishCopy);
+      real32 finalValue = compiledExpression.evaluate(slots.data());
 
       vertices[(y * sideLength) + x] = Vec4f(point.x * 100, finalValue * 100.0f, -point.y * 100, 1.0f);
     }
@@ -591,28 +862,45 @@ Noise::getMap(Vec2f offset, int32 sideLength, std::list<GenData>& genDatas,
   return vertices;
 }
 
-std::vector<Vec4f>
-Noise::getMapFast(Vec2f offset, int32 sideLength, const std::unordered_map<int32, GenData>& genDataMap,
-		  const std::string& expression, real32 baseWidthModifier, bool withBounds)
-{
-  int32 numbOfVertices = -1;
+// Everything needed to evaluate part of the map, read only while evaluating
+// so it can be shared between threads
+struct MapContext {
+  Vec2f offset;
+  int32 sideLength;
+  int32 numbOfVertices;
+  real32 stepSize;
+
+  Vec2f point00;
+  Vec2f point10;
+  Vec2f point01;
+  Vec2f point11;
+
+  int32 slotCount;
+  int32 xSlot;
+  int32 ySlot;
+
+  // Every map slot is either sampled from its GenData or read from precomputed layer
+  std::vector<const GenData*> slotGenDatas;
+  std::vector<const real32*> slotLayerValues;
+  CompiledExpression compiledExpression;
+};
 
+static void
+initMapGrid(MapContext& context, Vec2f offset, int32 sideLength, real32 baseWidthModifier, bool withBounds)
+{
   // if there should be bounds we add the vertices at the bounds
   if(!withBounds)
-    numbOfVertices = sideLength * sideLength;
+    context.numbOfVertices = sideLength * sideLength;
   else
-    numbOfVertices = (sideLength + 2) * (sideLength + 2);
+    context.numbOfVertices = (sideLength + 2) * (sideLength + 2);
 
-  std::vector<Vec4f> vertices;
-  vertices.resize(numbOfVertices);
+  context.offset = offset;
+  context.stepSize = 1.0f / (sideLength - 1);
 
-  real32 stepSize = 1.0f / (sideLength - 1);
-  real32 greyValue;
-
-  Vec2f point00 = Vec2f(-0.5f, 0.5f) * baseWidthModifier;
-  Vec2f point10 = Vec2f(0.5f, 0.5f) * baseWidthModifier;
-  Vec2f point01 = Vec2f(-0.5f, -0.5f) * baseWidthModifier;
-  Vec2f point11 = Vec2f(0.5f, -0.5f) * baseWidthModifier;
+  context.point00 = Vec2f(-0.5f, 0.5f) * baseWidthModifier;
+  context.point10 = Vec2f(0.5f, 0.5f) * baseWidthModifier;
+  context.point01 = Vec2f(-0.5f, -0.5f) * baseWidthModifier;
+  context.point11 = Vec2f(0.5f, -0.5f) * baseWidthModifier;
 
   // Adding appropriate stepSize to extend the range of interpolation values
   if(withBounds)
@@ -623,121 +911,354 @@ Noise::getMapFast(Vec2f offset, int32 sideLength, const std::unordered_map<int32
 
     sideLength += 2;
   }
+  context.sideLength = sideLength;
+}
 
-  // Parser Stuff ----------------
-  SimpleParser simpleParser;
-  VariableMap variableMap;
-
-  // I set variable Map first becauuuse ???
-  simpleParser.setVariableMap(&variableMap);
-  EntryList reversePolish = simpleParser.getReversePolish(expression);
-  // -----------------------------
+// Expression is compiled once, every map gets its own slot followed by x and y
+static void
+compileMapExpression(MapContext& context, SlotNameList& slotNames, const std::string& expression)
+{
+  context.xSlot = slotNames.size();
+  context.ySlot = context.xSlot + 1;
+  slotNames.push_back("x");
+  slotNames.push_back("y");
+  context.slotCount = slotNames.size();
 
-  std::map<uint32, Vec4f> values;
-  std::vector<VariableMap> variableMapBuffer;
+  SimpleParser simpleParser;
+  context.compiledExpression = simpleParser.compile(expression, slotNames);
+}
 
-  std::unordered_map<int32, real32> currentPointMapValues;
-  Vec2f currentPointRealPosition;
+static void
+initMapContext(MapContext& context, Vec2f offset, int32 sideLength, const std::unordered_map<int32, GenData>& genDataMap,
+	       const std::string& expression, real32 baseWidthModifier, bool withBounds)
+{
+  initMapGrid(context, offset, sideLength, baseWidthModifier, withBounds);
 
-  // Setting pointer to variables in parser - because map insertion is too expensive
-  // to be done every sampled point
-  // Increased efficiency by the factor of 2
+  SlotNameList slotNames;
   for(auto it = genDataMap.begin(); it != genDataMap.end(); it++)
   {
-    int32 mapIndex = it->first;
-    std::string mapName = "Map" + std::to_string(mapIndex);
-    variableMap[mapName] = &currentPointMapValues[mapIndex];
+    slotNames.push_back("Map" + std::to_string(it->first));
+    context.slotGenDatas.push_back(&it->second);
+    context.slotLayerValues.push_back(NULL);
   }
 
-  variableMap["x"] = &currentPointRealPosition.x;
-  variableMap["y"] = &currentPointRealPosition.y;
+  compileMapExpression(context, slotNames, expression);
+}
+
+// Map point and its world position for 8 vertices starting from valIndex
+static inline void
+getMapPoints(const MapContext& context, int32 valIndex, Vec2f points[], Vec2f realPositions[])
+{
+  Vec2f offset = context.offset;
+
+  for(int i = 0; i < 8; i++)
+  {
+    int32 currValIndex = valIndex + i;
+
+    int32 x = currValIndex % context.sideLength;
+    int32 y = currValIndex / context.sideLength;
+
+    Vec2f point0 = Vec2f::lerp(context.point00, context.point01, ((float)y ) * context.stepSize);
+    Vec2f point1 = Vec2f::lerp(context.point10, context.point11, ((float)y ) * context.stepSize);
+
+    points[i] = Vec2f::lerp(point0, point1, ((float)x) * context.stepSize);
+    realPositions[i] = points[i] + offset;
+  }
+}
 
-  for(int32 valIndex = 0; valIndex < numbOfVertices; valIndex += 4)
+static inline void
+sampleLayer(const GenData& genData, const Vec2f realPositions[], Vec4f mapValues[])
+{
+  switch(genData.noiseType)
   {
-    Vec2f points[4];
-    Vec2f realPositions[4];
+  case NT_PERLIN :
+    {
+      Noise::sumPerlin8(realPositions, genData.noiseParams, mapValues);
 
-    for(int i = 0; i < 4; i++)
+      // It's not rigged noise
+      if(genData.noiseParams.extraParam == 0)
+      {
+	for(int half = 0; half < 2; half++)
+	{
+	  mapValues[half] *= 0.5f;
+	  mapValues[half] += 0.5f;
+	}
+      }
+    } break;
+  case NT_VALUE :
     {
-      int32 currValIndex = valIndex + i;
+      Noise::sumValue8(realPositions, genData.noiseParams, mapValues);
+    } break;
+  case NT_WORLEY :
+    {
+      Noise::sumWorley8(realPositions, genData.noiseParams, mapValues);
+    } break;
+  default :
+    std::cout << "Error in Noise getMapFast No such noise type. \n";
+  }
 
-      int32 x = currValIndex % sideLength;
-      int32 y = currValIndex / sideLength;
+  for(int half = 0; half < 2; half++)
+  {
+    mapValues[half] *= genData.scale;
+  }
+}
 
-      Vec2f point0 = Vec2f::lerp(point00, point01, ((float)y ) * stepSize);
-      Vec2f point1 = Vec2f::lerp(point10, point11, ((float)y ) * stepSize);
+// Fills vertices from startIndex to endIndex, every point is computed independently
+// so results don't depend on how the map is split
+static void
+fillMapRange(const MapContext& context, int32 startIndex, int32 endIndex, Vec4f* vertices)
+{
+  // Points are processed 8 at once, slots[0] holds values for first 4 of them
+  std::vector<Vec4f> slots[2];
+  slots[0].resize(context.slotCount);
+  slots[1].resize(context.slotCount);
+
+  int32 xSlot = context.xSlot;
+  int32 ySlot = context.ySlot;
+
+  for(int32 valIndex = startIndex; valIndex < endIndex; valIndex += 8)
+  {
+    Vec2f points[8];
+    Vec2f realPositions[8];
+    getMapPoints(context, valIndex, points, realPositions);
 
-      points[i] = Vec2f::lerp(point0, point1, ((float)x) * stepSize);
-      realPositions[i] = points[i] + offset;
+    for(int i = 0; i < 8; i++)
+    {
+      slots[i / 4][xSlot][i % 4] = realPositions[i].x * 50;
+      slots[i / 4][ySlot][i % 4] = realPositions[i].y * 50;
     }
 
-    // Calculating map Values for 4 pixels
+    // Calculating map Values for 8 pixels
     //------------------------------------
-    for(auto it = genDataMap.begin(); it != genDataMap.end(); it++) {
-      int index = it->first;
-      const GenData& genData = it->second;
+    for(int32 index = 0; index < context.slotGenDatas.size(); index++) {
+      Vec4f mapValues[2];
 
-      switch(genData.noiseType)
+      const real32* layerValues = context.slotLayerValues[index];
+      if(layerValues)
       {
-      case NT_PERLIN :
-	{
-	  values[index] = Noise::sumPerlinFast(realPositions, genData.noiseParams);
-
-	  // It's not rigged noise
-	  if(genData.noiseParams.extraParam == 0)
-	  {
-	    values[index] *= 0.5f;
-	    values[index] += 0.5f;
-	  }
-	} break;
-      case NT_VALUE :
-	{
-	  for(int i = 0; i < 4; i++)
-	  {
-	    values[index][i] = Noise::sumValue(realPositions[i], genData.noiseParams);
-	  }
-	} break;
-      case NT_WORLEY :
+	for(int i = 0; i < 8 && valIndex + i < context.numbOfVertices; i++)
 	{
-	  for(int i = 0; i < 4; i++)
-	  {
-	    values[index][i] = Noise::sumWorley(realPositions[i], genData.noiseParams);
-	  }
-	} break;
-      default :
-	std::cout << "Error in Noise getMapFast No such noise type. \n";
+	  mapValues[i / 4][i % 4] = layerValues[valIndex + i];
+	}
       }
+      else sampleLayer(*context.slotGenDatas[index], realPositions, mapValues);
 
-      values[index] *= genData.scale;
+      slots[0][index] = mapValues[0];
+      slots[1][index] = mapValues[1];
     }
 
-    for(int i = 0; i < 4; i++)
+    for(int half = 0; half < 2; half++)
     {
-      int32 currValIndex = valIndex + i;
-
-      int32 x = currValIndex % sideLength;
-      int32 y = currValIndex / sideLength;
-
-      real32 finalValue = 0;
+      Vec4f finalValues = context.compiledExpression.evaluate4(slots[half].data());
 
-      for(auto it = values.begin(); it != values.end(); it++)
+      for(int i = 0; i < 4; i++)
       {
-	int32 index = it->first;
-	currentPointMapValues[index] = values[index][i];
+	int32 currValIndex = valIndex + half * 4 + i;
+	if(currValIndex >= endIndex) break;
+
+	const Vec2f& point = points[half * 4 + i];
+	vertices[currValIndex] = Vec4f(point.x * 100, finalValues[i] * 100.0f, -point.y * 100, 1.0f);
       }
-      currentPointRealPosition = realPositions[i] * 50;
+    }
+  }
+}
+
+std::vector<Vec4f>
+Noise::getMapFast(Vec2f offset, int32 sideLength, const std::unordered_map<int32, GenData>& genDataMap,
+		  const std::string& expression, real32 baseWidthModifier, bool withBounds)
+{
+  MapContext context;
+  initMapContext(context, offset, sideLength, genDataMap, expression, baseWidthModifier, withBounds);
+
+  std::vector<Vec4f> vertices;
+  vertices.resize(context.numbOfVertices);
+
+  fillMapRange(context, 0, context.numbOfVertices, vertices.data());
+
+  return vertices;
+}
+
+std::vector<real32>
+Noise::getLayerFast(Vec2f offset, int32 sideLength, const GenData& genData,
+		    real32 baseWidthModifier, bool withBounds)
+{
+  MapContext context;
+  initMapGrid(context, offset, sideLength, baseWidthModifier, withBounds);
+
+  std::vector<real32> values;
+  values.resize(context.numbOfVertices);
 
-      EntryList reversePolishCopy = reversePolish;
-      finalValue = simpleParser.evaluateExpression(reversePolishCopy);
+  for(int32 valIndex = 0; valIndex < context.numbOfVertices; valIndex += 8)
+  {
+    Vec2f points[8];
+    Vec2f realPositions[8];
+    getMapPoints(context, valIndex, points, realPositions);
 
-      // Fucking fix this bullshit
-      if(currValIndex < numbOfVertices)
-	vertices[currValIndex] = Vec4f(points[i].x * 100, finalValue * 100.0f, -points[i].y * 100, 1.0f);
+    Vec4f mapValues[2];
+    sampleLayer(genData, realPositions, mapValues);
 
-      else break;
+    for(int i = 0; i < 8 && valIndex + i < context.numbOfVertices; i++)
+    {
+      values[valIndex + i] = mapValues[i / 4][i % 4];
     }
   }
 
+  return values;
+}
+
+std::vector<Vec4f>
+Noise::getMapFromLayers(Vec2f offset, int32 sideLength, const LayerValuesMap& layerValuesMap,
+			const std::string& expression, real32 baseWidthModifier, bool withBounds)
+{
+  MapContext context;
+  initMapGrid(context, offset, sideLength, baseWidthModifier, withBounds);
+
+  SlotNameList slotNames;
+  for(auto it = layerValuesMap.begin(); it != layerValuesMap.end(); it++)
+  {
+    assert(it->second->size() == context.numbOfVertices);
+
+    slotNames.push_back("Map" + std::to_string(it->first));
+    context.slotGenDatas.push_back(NULL);
+    context.slotLayerValues.push_back(it->second->data());
+  }
+
+  compileMapExpression(context, slotNames, expression);
+
+  std::vector<Vec4f> vertices;
+  vertices.resize(context.numbOfVertices);
+
+  fillMapRange(context, 0, context.numbOfVertices, vertices.data());
+
+  return vertices;
+}
+
+// Threads helping getMapParallel, started on first use and kept for the rest of the run
+// so maps don't pay for thread creation
+class MapWorkerPool {
+ public:
+  static MapWorkerPool& get();
+
+  // Runs job on the calling thread and on up to helperCount workers, returns once every call returned
+  void run(int32 helperCount, const std::function<void()>& job);
+
+ private:
+  MapWorkerPool(int32 workerCount);
+
+  std::vector<std::thread> workers;
+
+  // Only one map is spread over the workers at a time
+  std::mutex runMutex;
+
+  std::mutex mutex;
+  std::condition_variable wakeCondition;
+  std::condition_variable doneCondition;
+  const std::function<void()>* job = NULL;
+  int32 pendingStartCount = 0;
+  int32 runningCount = 0;
+
+  void workerLoop();
+};
+
+MapWorkerPool&
+MapWorkerPool::get()
+{
+  // Never destroyed, joining threads from static destructors of a dll deadlocks on the loader lock
+  static MapWorkerPool* pool = new MapWorkerPool((int32)std::thread::hardware_concurrency() - 1);
+  return *pool;
+}
+
+MapWorkerPool::MapWorkerPool(int32 workerCount)
+{
+  for(int32 i = 0; i < workerCount; i++)
+  {
+    workers.push_back(std::thread(&MapWorkerPool::workerLoop, this));
+    workers.back().detach();
+  }
+}
+
+void
+MapWorkerPool::run(int32 helperCount, const std::function<void()>& job)
+{
+  std::lock_guard<std::mutex> runLock(runMutex);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->job = &job;
+    pendingStartCount = helperCount < (int32)workers.size() ? helperCount : (int32)workers.size();
+  }
+  wakeCondition.notify_all();
+
+  job();
+
+  // Workers that haven't started yet would find nothing left to do
+  std::unique_lock<std::mutex> lock(mutex);
+  pendingStartCount = 0;
+  doneCondition.wait(lock, [this]() { return runningCount == 0; });
+  this->job = NULL;
+}
+
+void
+MapWorkerPool::workerLoop()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while(true)
+  {
+    wakeCondition.wait(lock, [this]() { return pendingStartCount > 0; });
+
+    pendingStartCount--;
+    runningCount++;
+    const std::function<void()>* currentJob = job;
+
+    lock.unlock();
+    (*currentJob)();
+    lock.lock();
+
+    runningCount--;
+    if(runningCount == 0) doneCondition.notify_all();
+  }
+}
+
+std::vector<Vec4f>
+Noise::getMapParallel(Vec2f offset, int32 sideLength, const std::unordered_map<int32, GenData>& genDataMap,
+		      const std::string& expression, real32 baseWidthModifier, bool withBounds, int32 threadCount)
+{
+  static const int32 rowsPerTile = 16;
+
+  MapContext context;
+  initMapContext(context, offset, sideLength, genDataMap, expression, baseWidthModifier, withBounds);
+
+  std::vector<Vec4f> vertices;
+  vertices.resize(context.numbOfVertices);
+
+  int32 rowCount = context.sideLength;
+  int32 tileCount = (rowCount + rowsPerTile - 1) / rowsPerTile;
+
+  if(threadCount <= 0)
+    threadCount = (int32)std::thread::hardware_concurrency();
+  if(threadCount > tileCount)
+    threadCount = tileCount;
+
+  // Threads take row tiles until there are none left, every tile writes
+  // only its own part of vertices
+  std::atomic<int32> nextTile(0);
+  Vec4f* vertexData = vertices.data();
+
+  std::function<void()> processTiles = [&]()
+  {
+    int32 tile;
+    while((tile = nextTile.fetch_add(1)) < tileCount)
+    {
+      int32 startIndex = tile * rowsPerTile * context.sideLength;
+      int32 endIndex = startIndex + rowsPerTile * context.sideLength;
+      if(endIndex > context.numbOfVertices) endIndex = context.numbOfVertices;
+
+      fillMapRange(context, startIndex, endIndex, vertexData);
+    }
+  };
+
+  MapWorkerPool::get().run(threadCount - 1, processTiles);
+
   return vertices;
 }
 
@@ -830,16 +1351,5 @@ Noise::gradients2DMask = 7;
 real32
 Noise::sqr2 = pow(2.0f, 0.5f);
 
-std::list<Vec2i> Noise::chunksToCheck{
-  Vec2i(-1, -1),
-    Vec2i(0, -1),
-    Vec2i(1, -1),
-
-    Vec2i(-1, 0),
-    Vec2i(0, 0),
-    Vec2i(1, 0),
-
-    Vec2i(-1, 1),
-    Vec2i(0, 1),
-    Vec2i(1, 1)
-    };
+bool
+Noise::avx2Enabled = true;
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <xmmintrin.h>
+#include <immintrin.h>
 #include <vector>
 #include <list>
+#include <cmath>
 #include <unordered_map>
 
 #include "jpb.h"
@@ -52,8 +54,17 @@ enum WORLEY_TYPE{
   WT_F1MULF2,
 };
 
+// How octaves of fractal noise are summed
+enum FRACTAL_MODE{
+  FM_FBM,
+  FM_RIDGED
+};
+
 typedef std::unordered_map<int, GenData> GenDataMap;
 
+// Precomputed layer values by map index
+typedef std::unordered_map<int32, const std::vector<real32>*> LayerValuesMap;
+
 class DllExport Noise {
  public:
   static real32 random() { return (rand() % 255) * (1.0f / 255); }
@@ -61,6 +72,7 @@ class DllExport Noise {
   static real32 perlin(real32 value, real32 frequency);
 
   static real32 worley(Vec2f point, real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TYPE distanceType);
+  static Vec4f worleyFast(const Vec2f points[], real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TYPE distanceType);
 
   static real32 perlin(Vec2f point, real32 frequency);
   static Vec4f perlinFast(const Vec2f points[], real32 frequency);
@@ -72,9 +84,29 @@ class DllExport Noise {
   // 1 - rigged Noise
   static Vec4f sumPerlinFast(const Vec2f point[], const NoiseParams& noiseParams);
 
+  // Fractal sums with octave count known at compile time, loops are unrolled and
+  // mode is resolved at compile time. sumPerlin and sumPerlinFast dispatch to them for 1 - 8 octaves
+  template <int32 octaves>
+  static real32 fractalPerlin(const Vec2f& point, real32 frequency, real32 lacunarity, real32 persistence);
+
+  template <int32 octaves, FRACTAL_MODE fractalMode>
+  static Vec4f fractalPerlinFast(const Vec2f points[], real32 frequency, real32 lacunarity, real32 persistence);
+
   static real32 sumValue(const Vec2f& point, const NoiseParams& noiseParams);
 
   static real32 sumWorley(const Vec2f& point, const NoiseParams& noiseParams);
+  static Vec4f sumWorleyFast(const Vec2f points[], const NoiseParams& noiseParams);
+
+  // 8 points at once, result[0] holds first 4 points and result[1] the rest
+  // AVX2 kernels are used when CPU supports them otherwise it falls back to SSE/scalar
+  static void sumPerlin8(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[]);
+  static void sumValue8(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[]);
+  static void sumWorley8(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[]);
+
+  static bool isAvx2Supported();
+
+  // Allows forcing fallback path, mostly for comparing paths in tests
+  static void setAvx2Enabled(bool enabled) { avx2Enabled = enabled; }
 
   static std::vector<Vec4f> getMap(Vec2f offset, int32 sideLength, std::list<GenData>& genDatas,
 				   const std::string& expression);
@@ -85,6 +117,21 @@ class DllExport Noise {
   static std::vector<Vec4f> getMapFast(Vec2f offset, int32 sideLength, const std::unordered_map<int32,GenData>& genDataMap,
 				       const std::string& expression, real32 baseWidthModifier = 1.0f, bool withBounds=false);
 
+  // Same as getMapFast but rows are split into tiles evaluated on threadCount threads,
+  // the calling thread and workers kept between calls
+  // threadCount 0 uses all hardware threads, results are identical to getMapFast
+  static std::vector<Vec4f> getMapParallel(Vec2f offset, int32 sideLength, const std::unordered_map<int32,GenData>& genDataMap,
+					   const std::string& expression, real32 baseWidthModifier = 1.0f, bool withBounds=false,
+					   int32 threadCount = 0);
+
+  // Values of single layer for every map vertex, they're the same as values getMapFast uses
+  static std::vector<real32> getLayerFast(Vec2f offset, int32 sideLength, const GenData& genData,
+					  real32 baseWidthModifier = 1.0f, bool withBounds=false);
+
+  // getMapFast with layer values already computed by getLayerFast
+  static std::vector<Vec4f> getMapFromLayers(Vec2f offset, int32 sideLength, const LayerValuesMap& layerValuesMap,
+					     const std::string& expression, real32 baseWidthModifier = 1.0f, bool withBounds=false);
+
  private:
   static int32 hash[];
   static int32 hashMask;
@@ -97,19 +144,107 @@ class DllExport Noise {
 
   static real32 sqr2;
 
-  static std::list<Vec2i> chunksToCheck;
+  static bool avx2Enabled;
+  static bool useAvx2() { return avx2Enabled && isAvx2Supported(); }
+
+  // Defined in NoiseAvx2.cpp
+  static __m256 perlinAvx2(__m256 pointsX, __m256 pointsY, real32 frequency);
+  static __m256 valueAvx2(__m256 pointsX, __m256 pointsY, real32 frequency);
+  static __m256 worleyAvx2(__m256 pointsX, __m256 pointsY, real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TYPE distanceType);
+  static void sumPerlinAvx2(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[]);
+  static void sumValueAvx2(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[]);
+  static void sumWorleyAvx2(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[]);
 
 
   static real32 smooth(real32 t);
   static inline __m128 smoothFast(const __m128& t);
 
   // For Worley Noise
-  static real32 getClosest(const Vec2f& point, std::vector<Vec2f>& marks);
-  static void addDistances(const Vec2f& point, std::vector<Vec2f>& marks, std::list<real32>& distanceList, DISTANCE_TYPE distanceType);
+  static const int32 maxWorleyPoints = 7;
+
+  // Feature points of a cell depend only on its 8 bit hash, so points
+  // for every hash are generated once and kept in one table
+  struct WorleyCell {
+    int32 pointCount;
+    Vec2f points[maxWorleyPoints]; // Offsets from cell corner
+  };
 
-  // Returns points from given chunk Position
-  static std::vector<Vec2f> worleyGetPoints(Vec2i cubePosition);
+  static const WorleyCell* getWorleyCells();
+  static std::vector<WorleyCell> buildWorleyCells();
+  static int32 getCellHash(int32 x, int32 y) { return hash[(hash[x & hashMask] + hash[y & hashMask]) & hashMask]; }
+  static real32 getWorleyDistance(real32 deltaX, real32 deltaY, DISTANCE_TYPE distanceType);
+
+  static real32 getClosest(const Vec2f& point, std::vector<Vec2f>& marks);
   static float getRandNormalized();
   static real32 poisson(real32 lambda, real32 m);
   static int32 factorial(int32 value);
 };
+
+// Sums octaves from octave to octaves - 1, each instance adds one octave and
+// the recursion ends in specialization below so the sum is fully unrolled
+template <int32 octave, int32 octaves, FRACTAL_MODE fractalMode>
+struct PerlinOctaves {
+  static inline void
+  sum(const Vec2f& point, real32 frequency, real32 amplitude, real32 lacunarity, real32 persistence,
+      real32& sum, real32& range)
+  {
+    range += amplitude;
+    sum += Noise::perlin(point, frequency) * amplitude;
+
+    PerlinOctaves<octave + 1, octaves, fractalMode>::sum(point, frequency * lacunarity, amplitude * persistence,
+							 lacunarity, persistence, sum, range);
+  }
+
+  static inline void
+  sumFast(const Vec2f points[], real32 frequency, real32 amplitude, real32 lacunarity, real32 persistence,
+	  Vec4f& sum, real32& range)
+  {
+    range += amplitude;
+
+    Vec4f octaveResult = Noise::perlinFast(points, frequency);
+
+    if(fractalMode == FM_RIDGED)
+    {
+      octaveResult.x = 1.0f - fabsf(octaveResult.x);
+      octaveResult.y = 1.0f - fabsf(octaveResult.y);
+      octaveResult.z = 1.0f - fabsf(octaveResult.z);
+      octaveResult.w = 1.0f - fabsf(octaveResult.w);
+    }
+
+    sum += octaveResult * amplitude;
+
+    PerlinOctaves<octave + 1, octaves, fractalMode>::sumFast(points, frequency * lacunarity, amplitude * persistence,
+							     lacunarity, persistence, sum, range);
+  }
+};
+
+template <int32 octaves, FRACTAL_MODE fractalMode>
+struct PerlinOctaves<octaves, octaves, fractalMode> {
+  static inline void
+  sum(const Vec2f& point, real32 frequency, real32 amplitude, real32 lacunarity, real32 persistence,
+      real32& sum, real32& range) {}
+
+  static inline void
+  sumFast(const Vec2f points[], real32 frequency, real32 amplitude, real32 lacunarity, real32 persistence,
+	  Vec4f& sum, real32& range) {}
+};
+
+template <int32 octaves>
+real32
+Noise::fractalPerlin(const Vec2f& point, real32 frequency, real32 lacunarity, real32 persistence)
+{
+  real32 sum = 0;
+  real32 range = 0;
+  PerlinOctaves<0, octaves, FM_FBM>::sum(point, frequency, 1.0f, lacunarity, persistence, sum, range);
+  return sum / range;
+}
+
+template <int32 octaves, FRACTAL_MODE fractalMode>
+Vec4f
+Noise::fractalPerlinFast(const Vec2f points[], real32 frequency, real32 lacunarity, real32 persistence)
+{
+  Vec4f sum;
+  real32 range = 0;
+  PerlinOctaves<0, octaves, fractalMode>::sumFast(points, frequency, 1.0f, lacunarity, persistence, sum, range);
+  return sum / range;
+}
@@ -0,0 +1,351 @@
+// AVX2 noise kernels, this file is compiled separately with /arch:AVX2
+// so functions from here can only be called after Noise::isAvx2Supported() check
+#include <immintrin.h>
+#include <cfloat>
+#include <cstddef>
+#include "Noise.h"
+
+static inline __m256
+smoothAvx2(__m256 t)
+{
+  static const __m256 value6 = _mm256_set1_ps(6.0f);
+  static const __m256 value15 = _mm256_set1_ps(15.0f);
+  static const __m256 value10 = _mm256_set1_ps(10.0f);
+
+  // Same operation order as smoothFast so both paths give the same results
+  __m256 t2 = _mm256_mul_ps(t, t);
+  __m256 result = _mm256_mul_ps(t, value6);
+  result = _mm256_sub_ps(result, value15);
+
+  result = _mm256_mul_ps(t, result);
+  result = _mm256_add_ps(result, value10);
+
+  result = _mm256_mul_ps(result, t2);
+  result = _mm256_mul_ps(result, t);
+
+  return result;
+}
+
+static inline __m256
+lerpAvx2(__m256 start, __m256 end, __m256 t)
+{
+  return _mm256_add_ps(start, _mm256_mul_ps(_mm256_sub_ps(end, start), t));
+}
+
+static inline void
+loadPointsAvx2(const Vec2f points[], __m256& pointsX, __m256& pointsY)
+{
+  pointsX = _mm256_setr_ps(points[0].x, points[1].x, points[2].x, points[3].x,
+			   points[4].x, points[5].x, points[6].x, points[7].x);
+  pointsY = _mm256_setr_ps(points[0].y, points[1].y, points[2].y, points[3].y,
+			   points[4].y, points[5].y, points[6].y, points[7].y);
+}
+
+__m256
+Noise::perlinAvx2(__m256 pointsX, __m256 pointsY, real32 frequency)
+{
+  static const __m256 oneFX8 = _mm256_set1_ps(1.0f);
+  static const __m256i oneIX8 = _mm256_set1_epi32(1);
+  static const __m256i hashMaskX8 = _mm256_set1_epi32(hashMask);
+  static const __m256i gradientMaskX8 = _mm256_set1_epi32(gradients2DMask);
+  static const __m256 sqr2X8 = _mm256_set1_ps(sqr2);
+
+  const __m256 freqX8 = _mm256_set1_ps(frequency);
+
+  pointsX = _mm256_mul_ps(pointsX, freqX8);
+  pointsY = _mm256_mul_ps(pointsY, freqX8);
+
+  __m256 floorX = _mm256_floor_ps(pointsX);
+  __m256 floorY = _mm256_floor_ps(pointsY);
+
+  __m256 tx0 = _mm256_sub_ps(pointsX, floorX);
+  __m256 ty0 = _mm256_sub_ps(pointsY, floorY);
+  __m256 tx1 = _mm256_sub_ps(tx0, oneFX8);
+  __m256 ty1 = _mm256_sub_ps(ty0, oneFX8);
+
+  __m256i ix0 = _mm256_and_si256(_mm256_cvtps_epi32(floorX), hashMaskX8);
+  __m256i iy0 = _mm256_and_si256(_mm256_cvtps_epi32(floorY), hashMaskX8);
+  __m256i ix1 = _mm256_and_si256(_mm256_add_epi32(ix0, oneIX8), hashMaskX8);
+  __m256i iy1 = _mm256_and_si256(_mm256_add_epi32(iy0, oneIX8), hashMaskX8);
+
+  __m256i h0 = _mm256_i32gather_epi32(hash, ix0, 4);
+  __m256i h1 = _mm256_i32gather_epi32(hash, ix1, 4);
+
+  // Hash table is doubled so h + iy doesn't have to be masked
+  __m256i g00 = _mm256_and_si256(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h0, iy0), 4), gradientMaskX8);
+  __m256i g10 = _mm256_and_si256(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h1, iy0), 4), gradientMaskX8);
+  __m256i g01 = _mm256_and_si256(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h0, iy1), 4), gradientMaskX8);
+  __m256i g11 = _mm256_and_si256(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h1, iy1), 4), gradientMaskX8);
+
+  // Gradients are stored as x, y pairs
+  const real32* gradientsX = &gradients2D[0].x;
+  const real32* gradientsY = &gradients2D[0].y;
+
+  g00 = _mm256_slli_epi32(g00, 1);
+  g10 = _mm256_slli_epi32(g10, 1);
+  g01 = _mm256_slli_epi32(g01, 1);
+  g11 = _mm256_slli_epi32(g11, 1);
+
+  __m256 v00 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(gradientsX, g00, 4), tx0),
+			     _mm256_mul_ps(_mm256_i32gather_ps(gradientsY, g00, 4), ty0));
+  __m256 v10 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(gradientsX, g10, 4), tx1),
+			     _mm256_mul_ps(_mm256_i32gather_ps(gradientsY, g10, 4), ty0));
+  __m256 v01 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(gradientsX, g01, 4), tx0),
+			     _mm256_mul_ps(_mm256_i32gather_ps(gradientsY, g01, 4), ty1));
+  __m256 v11 = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(gradientsX, g11, 4), tx1),
+			     _mm256_mul_ps(_mm256_i32gather_ps(gradientsY, g11, 4), ty1));
+
+  __m256 tx = smoothAvx2(tx0);
+  __m256 ty = smoothAvx2(ty0);
+
+  __m256 upX = lerpAvx2(v00, v10, tx);
+  __m256 downX = lerpAvx2(v01, v11, tx);
+
+  return _mm256_mul_ps(lerpAvx2(upX, downX, ty), sqr2X8);
+}
+
+__m256
+Noise::valueAvx2(__m256 pointsX, __m256 pointsY, real32 frequency)
+{
+  static const __m256i oneIX8 = _mm256_set1_epi32(1);
+  static const __m256i hashMaskX8 = _mm256_set1_epi32(hashMask);
+  static const __m256 inv255X8 = _mm256_set1_ps(1.0f / 255.0f);
+
+  const __m256 freqX8 = _mm256_set1_ps(frequency);
+
+  pointsX = _mm256_mul_ps(pointsX, freqX8);
+  pointsY = _mm256_mul_ps(pointsY, freqX8);
+
+  __m256 floorX = _mm256_floor_ps(pointsX);
+  __m256 floorY = _mm256_floor_ps(pointsY);
+
+  __m256 tx = smoothAvx2(_mm256_sub_ps(pointsX, floorX));
+  __m256 ty = smoothAvx2(_mm256_sub_ps(pointsY, floorY));
+
+  // Like in value() ix1 isn't masked, it still fits in doubled hash table
+  __m256i ix0 = _mm256_and_si256(_mm256_cvtps_epi32(floorX), hashMaskX8);
+  __m256i iy0 = _mm256_and_si256(_mm256_cvtps_epi32(floorY), hashMaskX8);
+  __m256i ix1 = _mm256_add_epi32(ix0, oneIX8);
+  __m256i iy1 = _mm256_and_si256(_mm256_add_epi32(iy0, oneIX8), hashMaskX8);
+
+  __m256i h0 = _mm256_i32gather_epi32(hash, ix0, 4);
+  __m256i h1 = _mm256_i32gather_epi32(hash, ix1, 4);
+
+  __m256 h00 = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h0, iy0), 4));
+  __m256 h10 = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h1, iy0), 4));
+  __m256 h01 = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h0, iy1), 4));
+  __m256 h11 = _mm256_cvtepi32_ps(_mm256_i32gather_epi32(hash, _mm256_add_epi32(h1, iy1), 4));
+
+  __m256 upX = lerpAvx2(h00, h10, tx);
+  __m256 downX = lerpAvx2(h01, h11, tx);
+
+  return _mm256_mul_ps(lerpAvx2(upX, downX, ty), inv255X8);
+}
+
+__m256
+Noise::worleyAvx2(__m256 pointsX, __m256 pointsY, real32 frequency, WORLEY_TYPE worleyType, DISTANCE_TYPE distanceType)
+{
+  static const __m256 maxDistance = _mm256_set1_ps(FLT_MAX);
+  static const __m256 signMask = _mm256_set1_ps(-0.0f);
+  static const __m256 oneFX8 = _mm256_set1_ps(1.0f);
+  static const __m256i twoIX8 = _mm256_set1_epi32(2);
+  static const __m256i hashMaskX8 = _mm256_set1_epi32(hashMask);
+
+  // Cells are gathered as 4 byte fields, point j of a cell is at
+  // cellIndex * cellStride + pointsStart + 2 * j
+  const int32 cellStride = sizeof(WorleyCell) / 4;
+  const int32 pointsStart = offsetof(WorleyCell, points) / 4;
+  const int32* cellsBase = (const int32*)getWorleyCells();
+  const real32* cellsBaseF = (const real32*)cellsBase;
+
+  const __m256 freqX8 = _mm256_set1_ps(frequency);
+
+  pointsX = _mm256_mul_ps(pointsX, freqX8);
+  pointsY = _mm256_mul_ps(pointsY, freqX8);
+
+  __m256i cellX = _mm256_cvtps_epi32(_mm256_floor_ps(pointsX));
+  __m256i cellY = _mm256_cvtps_epi32(_mm256_floor_ps(pointsY));
+
+  __m256 f1 = maxDistance;
+  __m256 f2 = maxDistance;
+  __m256i pointCount = _mm256_setzero_si256();
+
+  for(int32 offsetY = -1; offsetY <= 1; offsetY++)
+  {
+    for(int32 offsetX = -1; offsetX <= 1; offsetX++)
+    {
+      __m256i x = _mm256_add_epi32(cellX, _mm256_set1_epi32(offsetX));
+      __m256i y = _mm256_add_epi32(cellY, _mm256_set1_epi32(offsetY));
+
+      // Same as getCellHash
+      __m256i hashX = _mm256_i32gather_epi32(hash, _mm256_and_si256(x, hashMaskX8), 4);
+      __m256i hashY = _mm256_i32gather_epi32(hash, _mm256_and_si256(y, hashMaskX8), 4);
+      __m256i cellHash = _mm256_and_si256(_mm256_add_epi32(hashX, hashY), hashMaskX8);
+      cellHash = _mm256_i32gather_epi32(hash, cellHash, 4);
+
+      __m256i cellIndex = _mm256_mullo_epi32(cellHash, _mm256_set1_epi32(cellStride));
+      __m256i cellPointCount = _mm256_i32gather_epi32(cellsBase, cellIndex, 4);
+      pointCount = _mm256_add_epi32(pointCount, cellPointCount);
+
+      int32 counts[8];
+      _mm256_storeu_si256((__m256i*)counts, cellPointCount);
+      int32 cellPointsMax = 0;
+      for(int i = 0; i < 8; i++)
+      {
+	if(counts[i] > cellPointsMax) cellPointsMax = counts[i];
+      }
+
+      __m256 cornerX = _mm256_cvtepi32_ps(x);
+      __m256 cornerY = _mm256_cvtepi32_ps(y);
+      __m256i pointIndex = _mm256_add_epi32(cellIndex, _mm256_set1_epi32(pointsStart));
+
+      // Lanes run up to the longest point list, missing points are masked out
+      for(int32 j = 0; j < cellPointsMax; j++)
+      {
+	__m256 markX = _mm256_add_ps(cornerX, _mm256_i32gather_ps(cellsBaseF, pointIndex, 4));
+	__m256 markY = _mm256_add_ps(cornerY, _mm256_i32gather_ps(cellsBaseF + 1, pointIndex, 4));
+	pointIndex = _mm256_add_epi32(pointIndex, twoIX8);
+
+	__m256 deltaX = _mm256_sub_ps(pointsX, markX);
+	__m256 deltaY = _mm256_sub_ps(pointsY, markY);
+	__m256 distance;
+
+	switch(distanceType)
+	{
+	case DT_EUCLDIAN_SQUARED :
+	case DT_MANHATTAN_SQUARED :
+	  distance = _mm256_add_ps(_mm256_mul_ps(deltaX, deltaX), _mm256_mul_ps(deltaY, deltaY)); break;
+	case DT_MANHATTAN :
+	  distance = _mm256_add_ps(_mm256_andnot_ps(signMask, deltaX), _mm256_andnot_ps(signMask, deltaY)); break;
+	case DT_EUCLIDIAN :
+	  distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(deltaX, deltaX), _mm256_mul_ps(deltaY, deltaY))); break;
+	case DT_CHEBYSHEV_MAX :
+	  distance = _mm256_max_ps(_mm256_andnot_ps(signMask, deltaX), _mm256_andnot_ps(signMask, deltaY)); break;
+	case DT_CHEBYSHEV_MIN :
+	  distance = _mm256_min_ps(_mm256_andnot_ps(signMask, deltaX), _mm256_andnot_ps(signMask, deltaY)); break;
+	default :
+	  distance = maxDistance;
+	}
+
+	__m256 validPoint = _mm256_castsi256_ps(_mm256_cmpgt_epi32(cellPointCount, _mm256_set1_epi32(j)));
+	distance = _mm256_blendv_ps(maxDistance, distance, validPoint);
+
+	// Same as the branches in worley
+	f2 = _mm256_min_ps(f2, _mm256_max_ps(f1, distance));
+	f1 = _mm256_min_ps(f1, distance);
+      }
+    }
+  }
+
+  // Less than 2 points around, f1 is 0 and f2 is 1 like in worley
+  __m256 tooFewPoints = _mm256_castsi256_ps(_mm256_cmpgt_epi32(twoIX8, pointCount));
+  f1 = _mm256_blendv_ps(f1, _mm256_setzero_ps(), tooFewPoints);
+  f2 = _mm256_blendv_ps(f2, oneFX8, tooFewPoints);
+
+  switch (worleyType)
+  {
+  case WT_F2SUBF1: return _mm256_sub_ps(f2, f1);
+  case WT_F1: return f1;
+  case WT_F2: return f2;
+  case WT_F2ADDF1: return _mm256_add_ps(f2, f1);
+  case WT_F1MULF2: return _mm256_mul_ps(f1, f2);
+  }
+
+  return _mm256_setzero_ps();
+}
+
+void
+Noise::sumPerlinAvx2(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[])
+{
+  static const __m256 oneFX8 = _mm256_set1_ps(1.0f);
+  static const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+  __m256 pointsX, pointsY;
+  loadPointsAvx2(points, pointsX, pointsY);
+
+  __m256 sum = _mm256_setzero_ps();
+
+  real32 amplitude = 1.0f;
+  real32 range = 0;
+  real32 frequency = noiseParams.frequency;
+
+  for(int32 octave = 0; octave < noiseParams.octaves; octave++)
+  {
+    range += amplitude;
+
+    __m256 octaveResult = perlinAvx2(pointsX, pointsY, frequency);
+
+    // extraParam == 1 - rigded noise
+    if(noiseParams.extraParam != 0)
+      octaveResult = _mm256_sub_ps(oneFX8, _mm256_andnot_ps(signMask, octaveResult));
+
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(octaveResult, _mm256_set1_ps(amplitude)));
+
+    frequency *= noiseParams.lacunarity;
+    amplitude *= noiseParams.persistence;
+  }
+
+  sum = _mm256_div_ps(sum, _mm256_set1_ps(range));
+
+  result[0] = storeVec4f(_mm256_castps256_ps128(sum));
+  result[1] = storeVec4f(_mm256_extractf128_ps(sum, 1));
+}
+
+void
+Noise::sumValueAvx2(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[])
+{
+  __m256 pointsX, pointsY;
+  loadPointsAvx2(points, pointsX, pointsY);
+
+  __m256 sum = _mm256_setzero_ps();
+
+  real32 amplitude = 1.0f;
+  real32 range = 0;
+  real32 frequency = noiseParams.frequency;
+
+  for(int32 octave = 0; octave < noiseParams.octaves; octave++)
+  {
+    range += amplitude;
+
+    __m256 octaveResult = valueAvx2(pointsX, pointsY, frequency);
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(octaveResult, _mm256_set1_ps(amplitude)));
+
+    frequency *= noiseParams.lacunarity;
+    amplitude *= noiseParams.persistence;
+  }
+
+  sum = _mm256_div_ps(sum, _mm256_set1_ps(range));
+
+  result[0] = storeVec4f(_mm256_castps256_ps128(sum));
+  result[1] = storeVec4f(_mm256_extractf128_ps(sum, 1));
+}
+
+void
+Noise::sumWorleyAvx2(const Vec2f points[], const NoiseParams& noiseParams, Vec4f result[])
+{
+  __m256 pointsX, pointsY;
+  loadPointsAvx2(points, pointsX, pointsY);
+
+  __m256 sum = _mm256_setzero_ps();
+
+  real32 amplitude = 1.0f;
+  real32 range = 0;
+  real32 frequency = noiseParams.frequency;
+
+  for(int32 octave = 0; octave < noiseParams.octaves; octave++)
+  {
+    range += amplitude;
+
+    __m256 octaveResult = worleyAvx2(pointsX, pointsY, frequency, (WORLEY_TYPE)noiseParams.extraParam,
+				     (DISTANCE_TYPE)noiseParams.extraParam2);
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(octaveResult, _mm256_set1_ps(amplitude)));
+
+    frequency *= noiseParams.lacunarity;
+    amplitude *= noiseParams.persistence;
+  }
+
+  sum = _mm256_div_ps(sum, _mm256_set1_ps(range));
+
+  result[0] = storeVec4f(_mm256_castps256_ps128(sum));
+  result[1] = storeVec4f(_mm256_extractf128_ps(sum, 1));
+}
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include "NoiseCache.h"
+
+static inline void
+hashCombine(size_t& seed, size_t value)
+{
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+static inline size_t
+hashFloat(real32 value)
+{
+  uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return std::hash<uint32>()(bits);
+}
+
+static size_t
+hashRegion(const NoiseRegion& region)
+{
+  size_t seed = 0;
+  hashCombine(seed, hashFloat(region.offset.x));
+  hashCombine(seed, hashFloat(region.offset.y));
+  hashCombine(seed, std::hash<int32>()(region.sideLength));
+  hashCombine(seed, hashFloat(region.baseWidthModifier));
+  hashCombine(seed, region.withBounds);
+  return seed;
+}
+
+static size_t
+hashTile(const NoiseTileKey& tile)
+{
+  size_t seed = std::hash<int32>()(tile.tileX);
+  hashCombine(seed, std::hash<int32>()(tile.tileY));
+  hashCombine(seed, hashFloat(tile.spacing));
+  hashCombine(seed, std::hash<int32>()(tile.phaseX));
+  hashCombine(seed, std::hash<int32>()(tile.phaseY));
+  return seed;
+}
+
+// Rounds towards negative infinity, so tiles left of and above the origin work too
+static inline int32
+floorDivide(int32 value, int32 divisor)
+{
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static size_t
+hashGenData(const GenData& genData)
+{
+  size_t seed = std::hash<int32>()(genData.noiseType);
+  hashCombine(seed, hashFloat(genData.noiseParams.frequency));
+  hashCombine(seed, std::hash<int32>()(genData.noiseParams.octaves));
+  hashCombine(seed, hashFloat(genData.noiseParams.lacunarity));
+  hashCombine(seed, hashFloat(genData.noiseParams.persistence));
+  hashCombine(seed, std::hash<int32>()(genData.noiseParams.extraParam));
+  hashCombine(seed, std::hash<int32>()(genData.noiseParams.extraParam2));
+  hashCombine(seed, hashFloat(genData.scale));
+  return seed;
+}
+
+bool
+NoiseRegion::operator==(const NoiseRegion& region) const
+{
+  return offset.x == region.offset.x && offset.y == region.offset.y &&
+    sideLength == region.sideLength && baseWidthModifier == region.baseWidthModifier &&
+    withBounds == region.withBounds;
+}
+
+bool
+NoiseTileKey::operator==(const NoiseTileKey& key) const
+{
+  return tileX == key.tileX && tileY == key.tileY && spacing == key.spacing &&
+    phaseX == key.phaseX && phaseY == key.phaseY;
+}
+
+bool
+NoiseTileCache::MapKey::operator==(const MapKey& key) const
+{
+  if(!(region == key.region) || expression != key.expression || layers.size() != key.layers.size())
+    return false;
+
+  for(int32 i = 0; i < layers.size(); i++)
+  {
+    if(layers[i].first != key.layers[i].first || layers[i].second != key.layers[i].second)
+      return false;
+  }
+
+  return true;
+}
+
+size_t
+NoiseTileCache::KeyHash::operator()(const LayerKey& key) const
+{
+  size_t seed = hashTile(key.tile);
+  hashCombine(seed, hashGenData(key.genData));
+  return seed;
+}
+
+size_t
+NoiseTileCache::KeyHash::operator()(const MapKey& key) const
+{
+  size_t seed = hashRegion(key.region);
+  hashCombine(seed, std::hash<std::string>()(key.expression));
+
+  for(auto it = key.layers.begin(); it != key.layers.end(); it++)
+  {
+    hashCombine(seed, std::hash<int32>()(it->first));
+    hashCombine(seed, hashGenData(it->second));
+  }
+
+  return seed;
+}
+
+NoiseTileCache::NoiseTileCache(size_t memoryCap) : memoryCap(memoryCap)
+{
+}
+
+NoiseMapPtr
+NoiseTileCache::getMap(Vec2f offset, int32 sideLength, const GenDataMap& genDataMap, const std::string& expression,
+		       real32 baseWidthModifier, bool withBounds)
+{
+  MapKey mapKey;
+  mapKey.region.offset = offset;
+  mapKey.region.sideLength = sideLength;
+  mapKey.region.baseWidthModifier = baseWidthModifier;
+  mapKey.region.withBounds = withBounds;
+  mapKey.expression = expression;
+
+  for(auto it = genDataMap.begin(); it != genDataMap.end(); it++)
+  {
+    mapKey.layers.push_back(std::make_pair((int32)it->first, it->second));
+  }
+
+  // Map iteration order isn't defined so layers are sorted to get the same key
+  std::sort(mapKey.layers.begin(), mapKey.layers.end(),
+	    [](const std::pair<int32, GenData>& a, const std::pair<int32, GenData>& b) { return a.first < b.first; });
+
+  auto mapIt = mapIndex.find(mapKey);
+  if(mapIt != mapIndex.end())
+  {
+    mapHits++;
+    touch(mapIt->second);
+    return mapIt->second->map;
+  }
+
+  mapMisses++;
+
+  std::vector<std::vector<real32>> layers(mapKey.layers.size());
+  LayerValuesMap layerValuesMap;
+
+  for(int32 i = 0; i < mapKey.layers.size(); i++)
+  {
+    getLayer(mapKey.region, mapKey.layers[i].second, layers[i]);
+    layerValuesMap[mapKey.layers[i].first] = &layers[i];
+  }
+
+  CacheEntry entry;
+  entry.isLayer = false;
+  entry.mapKey = mapKey;
+
+  std::shared_ptr<std::vector<Vec4f>> map = std::make_shared<std::vector<Vec4f>>();
+  *map = Noise::getMapFromLayers(offset, sideLength, layerValuesMap, expression, baseWidthModifier, withBounds);
+
+  entry.map = map;
+  entry.size = map->size() * sizeof(Vec4f);
+  addEntry(entry);
+
+  return entry.map;
+}
+
+void
+NoiseTileCache::getLayer(const NoiseRegion& region, const GenData& genData, std::vector<real32>& values)
+{
+  int32 sampleCount = region.withBounds ? region.sideLength + 2 : region.sideLength;
+  real32 spacing = region.baseWidthModifier / (region.sideLength - 1);
+
+  // First sample, columns go towards +x and rows towards -y from it (same as getMapFast)
+  Vec2f origin = region.offset + Vec2f(-0.5f, 0.5f) * region.baseWidthModifier;
+
+  // Lattice column and row of the first sample, phase is what's left over
+  int32 firstColumn = (int32)floorf(origin.x / spacing + 0.5f);
+  int32 firstRow = (int32)floorf(-origin.y / spacing + 0.5f);
+
+  NoiseTileKey tile;
+  tile.spacing = spacing;
+  tile.phaseX = (int32)floorf((origin.x - firstColumn * spacing) / spacing * noisePhaseSteps + 0.5f);
+  tile.phaseY = (int32)floorf((origin.y + firstRow * spacing) / spacing * noisePhaseSteps + 0.5f);
+
+  values.resize(sampleCount * sampleCount);
+
+  int32 lastColumn = firstColumn + sampleCount - 1;
+  int32 lastRow = firstRow + sampleCount - 1;
+
+  for(tile.tileY = floorDivide(firstRow, noiseTileSize); tile.tileY <= floorDivide(lastRow, noiseTileSize); tile.tileY++)
+  {
+    for(tile.tileX = floorDivide(firstColumn, noiseTileSize); tile.tileX <= floorDivide(lastColumn, noiseTileSize); tile.tileX++)
+    {
+      NoiseLayerPtr tileValues = getLayerTile(tile, genData);
+
+      // Part of the tile inside of the region, in lattice coordinates
+      int32 tileColumn = tile.tileX * noiseTileSize;
+      int32 tileRow = tile.tileY * noiseTileSize;
+      int32 startColumn = std::max(firstColumn, tileColumn);
+      int32 endColumn = std::min(lastColumn, tileColumn + noiseTileSize - 1);
+      int32 startRow = std::max(firstRow, tileRow);
+      int32 endRow = std::min(lastRow, tileRow + noiseTileSize - 1);
+
+      for(int32 row = startRow; row <= endRow; row++)
+      {
+	const real32* source = tileValues->data() + (row - tileRow) * noiseTileSize + (startColumn - tileColumn);
+	real32* destination = values.data() + (row - firstRow) * sampleCount + (startColumn - firstColumn);
+	memcpy(destination, source, (endColumn - startColumn + 1) * sizeof(real32));
+      }
+    }
+  }
+}
+
+NoiseLayerPtr
+NoiseTileCache::getLayerTile(const NoiseTileKey& tile, const GenData& genData)
+{
+  LayerKey layerKey = { tile, genData };
+
+  auto layerIt = layerIndex.find(layerKey);
+  if(layerIt != layerIndex.end())
+  {
+    layerHits++;
+    touch(layerIt->second);
+    return layerIt->second->layer;
+  }
+
+  layerMisses++;
+
+  CacheEntry entry;
+  entry.isLayer = true;
+  entry.layerKey = layerKey;
+
+  // Tile is a getLayerFast grid whose first sample sits on its lattice position
+  real32 tileWidth = tile.spacing * (noiseTileSize - 1);
+  Vec2f firstSample((real32)tile.phaseX / noisePhaseSteps * tile.spacing + tile.tileX * noiseTileSize * tile.spacing,
+		    (real32)tile.phaseY / noisePhaseSteps * tile.spacing - tile.tileY * noiseTileSize * tile.spacing);
+  Vec2f tileOffset = firstSample + Vec2f(0.5f, -0.5f) * tileWidth;
+
+  std::shared_ptr<std::vector<real32>> layer = std::make_shared<std::vector<real32>>();
+  *layer = Noise::getLayerFast(tileOffset, noiseTileSize, genData, tileWidth, false);
+
+  entry.layer = layer;
+  entry.size = layer->size() * sizeof(real32);
+  addEntry(entry);
+
+  return entry.layer;
+}
+
+void
+NoiseTileCache::clear()
+{
+  entries.clear();
+  layerIndex.clear();
+  mapIndex.clear();
+  memoryUsage = 0;
+}
+
+void
+NoiseTileCache::setMemoryCap(size_t memoryCap)
+{
+  this->memoryCap = memoryCap;
+  evict();
+}
+
+void
+NoiseTileCache::touch(CacheEntryList::iterator entry)
+{
+  entries.splice(entries.begin(), entries, entry);
+}
+
+void
+NoiseTileCache::addEntry(const CacheEntry& entry)
+{
+  entries.push_front(entry);
+  memoryUsage += entry.size;
+
+  if(entry.isLayer) layerIndex[entry.layerKey] = entries.begin();
+  else mapIndex[entry.mapKey] = entries.begin();
+
+  evict();
+}
+
+void
+NoiseTileCache::evict()
+{
+  // The newest entry always stays even if it's bigger than the cap
+  while(memoryUsage > memoryCap && entries.size() > 1)
+  {
+    CacheEntry& entry = entries.back();
+
+    if(entry.isLayer) layerIndex.erase(entry.layerKey);
+    else mapIndex.erase(entry.mapKey);
+
+    memoryUsage -= entry.size;
+    entries.pop_back();
+  }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "jpb.h"
+#include "Types.h"
+#include "Noise.h"
+
+typedef std::shared_ptr<const std::vector<Vec4f>> NoiseMapPtr;
+typedef std::shared_ptr<const std::vector<real32>> NoiseLayerPtr;
+
+// Region of the map, same values getMapFast takes
+struct NoiseRegion {
+  Vec2f offset;
+  int32 sideLength;
+  real32 baseWidthModifier;
+  bool withBounds;
+
+  bool operator==(const NoiseRegion& region) const;
+};
+
+// Layer samples are cached in square tiles of this many samples per side
+const int32 noiseTileSize = 32;
+
+// Maps with the same sample spacing share one lattice of samples, tileX/tileY count tiles on it
+// Phase is where the lattice starts inside of one spacing, in 1/noisePhaseSteps of it
+struct NoiseTileKey {
+  int32 tileX;
+  int32 tileY;
+  real32 spacing;
+  int32 phaseX;
+  int32 phaseY;
+
+  bool operator==(const NoiseTileKey& key) const;
+};
+
+const int32 noisePhaseSteps = 4096;
+
+// LRU cache of getMapFast results and of grid aligned tiles of the layers they were built from,
+// panning samples only the tiles that weren't requested before and when one layer changes
+// only that layer is sampled again
+class DllExport NoiseTileCache {
+ public:
+  NoiseTileCache(size_t memoryCap = 64 * 1024 * 1024);
+
+  // Returns the same map as Noise::getMapFast, for offsets that aren't a whole number of samples
+  // apart from cached tiles it can be shifted by at most 1/noisePhaseSteps of a sample
+  NoiseMapPtr getMap(Vec2f offset, int32 sideLength, const GenDataMap& genDataMap, const std::string& expression,
+		     real32 baseWidthModifier = 1.0f, bool withBounds = false);
+
+  void clear();
+
+  void setMemoryCap(size_t memoryCap);
+  size_t getMemoryCap() const { return memoryCap; }
+  size_t getMemoryUsage() const { return memoryUsage; }
+
+  uint64 getMapHits() const { return mapHits; }
+  uint64 getMapMisses() const { return mapMisses; }
+  // Counted per layer tile
+  uint64 getLayerHits() const { return layerHits; }
+  uint64 getLayerMisses() const { return layerMisses; }
+
+ private:
+  typedef std::vector<std::pair<int32, GenData>> LayerList;
+
+  struct LayerKey {
+    NoiseTileKey tile;
+    GenData genData;
+
+    bool operator==(const LayerKey& key) const { return tile == key.tile && genData == key.genData; }
+  };
+
+  struct MapKey {
+    NoiseRegion region;
+    LayerList layers; // Sorted by map index
+    std::string expression;
+
+    bool operator==(const MapKey& key) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const LayerKey& key) const;
+    size_t operator()(const MapKey& key) const;
+  };
+
+  // Layers and maps share one list so memory cap covers both
+  struct CacheEntry {
+    bool isLayer;
+    LayerKey layerKey;
+    MapKey mapKey;
+
+    NoiseLayerPtr layer;
+    NoiseMapPtr map;
+    size_t size;
+  };
+
+  typedef std::list<CacheEntry> CacheEntryList;
+
+  // Most recently used entries are at the front
+  CacheEntryList entries;
+  std::unordered_map<LayerKey, CacheEntryList::iterator, KeyHash> layerIndex;
+  std::unordered_map<MapKey, CacheEntryList::iterator, KeyHash> mapIndex;
+
+  size_t memoryCap;
+  size_t memoryUsage = 0;
+
+  uint64 mapHits = 0;
+  uint64 mapMisses = 0;
+  uint64 layerHits = 0;
+  uint64 layerMisses = 0;
+
+  // Values of the layer over the region, copied out of the tiles covering it
+  void getLayer(const NoiseRegion& region, const GenData& genData, std::vector<real32>& values);
+  NoiseLayerPtr getLayerTile(const NoiseTileKey& tile, const GenData& genData);
+
+  void touch(CacheEntryList::iterator entry);
+  void addEntry(const CacheEntry& entry);
+  void evict();
+};
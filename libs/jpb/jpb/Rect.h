@@ -10,23 +10,113 @@ public:
   T width;
   T height;
 
-  Rect(T left = 0,T top = 0,  T width = 0, T height = 0) :
+  constexpr Rect(T left = 0,T top = 0,  T width = 0, T height = 0) :
     left(left), top(top),  width(width), height(height) {}
 
-  Vec2<T> getCorner(const int cornerIndex) const ;
-  Vec2<T> operator[](const int cornerIndex) const ;
+  Vec2<T> getCorner(const int cornerIndex) const
+  {
+    Vec2<T> corner;
+    switch(cornerIndex){
+    case 0: corner = Vec2<T>(left, top);
+      break;
+    case 1: corner = Vec2<T>(left + width, top);
+      break;
+    case 2: corner = Vec2<T>(left + width, top + height);
+      break;
+    case 3: corner = Vec2<T>(left, top + height);
+      break;
+    };
+    return corner;
+  }
+  Vec2<T> operator[](const int cornerIndex) const
+  {
+    return getCorner(cornerIndex);
+  }
 
-  void operator+=(const Vec2<T>& delta);
-  Rect<T> operator+(const Vec2<T>& delta);
+  void operator+=(const Vec2<T>& delta)
+  {
+    left += delta.x;
+    top += delta.y;
+  }
+  constexpr Rect<T> operator+(const Vec2<T>& delta) const
+  {
+    return Rect<T>(left + delta.x, top + delta.y, width, height);
+  }
 
-  bool doesContain(const Vec2<T>& point) const ;
-  bool doesRectCollideWith(const Rect<T>& collisionRect) const;
+  constexpr bool doesContain(const Vec2<T>& point) const
+  {
+    return point.x >= left && point.x <= (left + width) &&
+      point.y >= top && point.y <= (top + height);
+  }
+  constexpr bool doesRectCollideWith(const Rect<T>& collisionRect) const
+  {
+    return !(left > (collisionRect.left + collisionRect.width) ||
+	     (left + width) < collisionRect.left ||
+	     top > (collisionRect.top + collisionRect.height) ||
+	     (top + height) < collisionRect.top);
+  }
 
   // Top Right Down Left
-  float getMaxTime(const Vec2<T>& point, const Vec2f& deltaVec, const int wallIndex) const;
+  inline float getMaxTime(const Vec2<T>& point, const Vec2f& deltaVec, const int wallIndex) const
+  {
+    float result = 1000.0f;
+
+    switch(wallIndex)
+    {
+    case 0:
+      {
+	// Upper Wall
+	if(deltaVec.y != 0)
+	{
+	  result = (top - point.y) / deltaVec.y;
+	  float newPositionX = point.x + result * deltaVec.x;
+	  if(newPositionX >= left && newPositionX <= left + width) return result;
+	  else return 1000.0f;
+	}
+
+      }break;
+    case 1:
+      {
+	// Right Wall
+	if(deltaVec.x != 0)
+	{
+	  result = ((left + width) - point.x) / deltaVec.x;
+	  float newPositionY = point.y + result * deltaVec.y;
+
+	  if(newPositionY >= top && newPositionY <= top + height) return result;
+	  else return 1000.0f;
+	}
+      }break;
+    case 2:
+      {
+	// Lower Wall
+	if(deltaVec.y != 0)
+	{
+	  result = ((top + height) - point.y) / deltaVec.y;
+	  float newPositionX = point.x + result * deltaVec.x;
+
+	  if(newPositionX > left && newPositionX < left + width) return result;
+	  else return 1000.0f;
+	}
+
+      }break;
+    case 3:
+      {
+	// Left Wall
+	if(deltaVec.x != 0)
+	{
+	  result = (left - point.x) / deltaVec.x;
+	  float newPositionY = point.y + result * deltaVec.y;
+
+	  if(newPositionY >= top && newPositionY <= top + height) return result;
+	  else return 1000.0f;
+	}
+      }break;
+    }
+
+    return result;
+  }
 };
 
 typedef Rect<int> IntRect;
 typedef Rect<float> FloatRect;
-
-#include "Rect.cpp"
@@ -2,6 +2,8 @@
 #include <algorithm>
 #include <assert.h>
 #include <string>
+#include <cmath>
+#include <xmmintrin.h>
 #include "Types.h"
 
 bool SimpleParser::isExpressionCorrect(std::string expression, StringList& validVariables)
@@ -347,6 +349,292 @@ real32 SimpleParser::evaluateExpression(std::string expression) const
   return result;
 }
 
+static OPCODE
+getOpcode(const Entry& entry)
+{
+  if(entry.type == ET_OPERATOR)
+  {
+    switch(entry.value[0])
+    {
+    case '+': return OP_ADD;
+    case '-': return OP_SUB;
+    case '*': return OP_MUL;
+    case '/': return OP_DIV;
+    case '^': return OP_POW;
+    case '%': return OP_FMOD;
+    }
+  }
+
+  const std::string& function = entry.value;
+  if(function == "min") return OP_MIN;
+  else if(function == "max") return OP_MAX;
+  else if(function == "mod") return OP_FMOD;
+  else if(function == "sin") return OP_SIN;
+  else if(function == "cos") return OP_COS;
+  else if(function == "abs") return OP_ABS;
+  else if(function == "floor") return OP_FLOOR;
+  else if(function == "ceil") return OP_CEIL;
+  else if(function == "blend") return OP_BLEND;
+
+  return OP_INVALID;
+}
+
+// How many values instruction takes from the stack
+static int32
+getArgumentCount(OPCODE opcode)
+{
+  switch(opcode)
+  {
+  case OP_CONSTANT:
+  case OP_VARIABLE: return 0;
+  case OP_SIN:
+  case OP_COS:
+  case OP_ABS:
+  case OP_FLOOR:
+  case OP_CEIL: return 1;
+  case OP_BLEND: return 4;
+  }
+  return 2;
+}
+
+static inline real32
+applyBinary(OPCODE opcode, real32 left, real32 right)
+{
+  switch(opcode)
+  {
+  case OP_ADD: return left + right;
+  case OP_SUB: return left - right;
+  case OP_MUL: return left * right;
+  case OP_DIV: return left / right;
+  case OP_POW: return powf(left, right);
+  case OP_FMOD: return fmodf(left, right);
+  case OP_MIN: return std::min(left, right);
+  case OP_MAX: return std::max(left, right);
+  }
+  return 0;
+}
+
+static inline real32
+applyUnary(OPCODE opcode, real32 argument)
+{
+  switch(opcode)
+  {
+  case OP_SIN: return sinf(argument);
+  case OP_COS: return cosf(argument);
+  case OP_ABS: return fabsf(argument);
+  case OP_FLOOR: return floorf(argument);
+  case OP_CEIL: return ceilf(argument);
+  }
+  return 0;
+}
+
+CompiledExpression
+SimpleParser::compile(const std::string& expression, const SlotNameList& slotNames) const
+{
+  CompiledExpression result;
+  EntryList reversePolish = getReversePolish(expression);
+
+  if(reversePolish.size() == 0 || reversePolish.front().type == ET_INVALID)
+  {
+    std::cout << "Invalid Atom starting at: " << (reversePolish.size() ? reversePolish.front().value : "") << std::endl;
+    std::cout << "In Expression: " << expression  << std::endl << std::endl;
+    return result;
+  }
+
+  result.program.reserve(reversePolish.size());
+
+  // Tracking stack depth so evaluation doesn't have to check it
+  int32 stackDepth = 0;
+
+  for(auto it = reversePolish.begin(); it != reversePolish.end(); it++)
+  {
+    const Entry& entry = *it;
+    Instruction instruction;
+
+    switch(entry.type)
+    {
+    case ET_NUMBER:
+      {
+	instruction.opcode = OP_CONSTANT;
+	instruction.constant = std::stof(entry.value);
+      } break;
+    case ET_VARIABLE:
+      {
+	auto slotIt = std::find(slotNames.begin(), slotNames.end(), entry.value);
+	if(slotIt != slotNames.end())
+	{
+	  instruction.opcode = OP_VARIABLE;
+	  instruction.slot = (int32)std::distance(slotNames.begin(), slotIt);
+	}
+	else
+	{
+	  // Same as evaluateExpression missing variables evaluate to 0
+	  std::cout << "Coulnd find variable: " << entry.value << std::endl;
+	  instruction.opcode = OP_CONSTANT;
+	  instruction.constant = 0;
+	}
+      } break;
+    default:
+      {
+	instruction.opcode = getOpcode(entry);
+	instruction.slot = 0;
+      }
+    }
+
+    if(instruction.opcode == OP_INVALID)
+    {
+      std::cout << "Function: " << entry.value << " doesn't exist" << std::endl;
+      std::cout << "In Expression: " << expression  << std::endl << std::endl;
+      result.program.clear();
+      return result;
+    }
+
+    stackDepth -= getArgumentCount(instruction.opcode);
+    if(stackDepth < 0)
+    {
+      std::cout << "Missing arguments for: " << entry.value << std::endl;
+      std::cout << "In Expression: " << expression  << std::endl << std::endl;
+      result.program.clear();
+      return result;
+    }
+
+    ++stackDepth;
+    if(stackDepth > CompiledExpression::maxStackSize)
+    {
+      std::cout << "Expression too deep: " << expression  << std::endl << std::endl;
+      result.program.clear();
+      return result;
+    }
+
+    result.program.push_back(instruction);
+  }
+
+  result.valid = stackDepth == 1;
+  if(!result.valid)
+  {
+    std::cout << "Too many values in Expression: " << expression  << std::endl << std::endl;
+    result.program.clear();
+  }
+
+  return result;
+}
+
+real32
+CompiledExpression::evaluate(const real32* slots) const
+{
+  if(!valid) return 0;
+
+  real32 stack[maxStackSize];
+  int32 top = -1;
+
+  const Instruction* instruction = program.data();
+  const Instruction* programEnd = instruction + program.size();
+
+  for(; instruction != programEnd; instruction++)
+  {
+    switch(instruction->opcode)
+    {
+    case OP_CONSTANT: stack[++top] = instruction->constant; break;
+    case OP_VARIABLE: stack[++top] = slots[instruction->slot]; break;
+    case OP_ADD: --top; stack[top] = stack[top] + stack[top + 1]; break;
+    case OP_SUB: --top; stack[top] = stack[top] - stack[top + 1]; break;
+    case OP_MUL: --top; stack[top] = stack[top] * stack[top + 1]; break;
+    case OP_DIV: --top; stack[top] = stack[top] / stack[top + 1]; break;
+    case OP_POW:
+    case OP_FMOD:
+    case OP_MIN:
+    case OP_MAX:
+      --top;
+      stack[top] = applyBinary(instruction->opcode, stack[top], stack[top + 1]);
+      break;
+    case OP_BLEND:
+      top -= 3;
+      stack[top] = blendSmooth(stack[top], stack[top + 1], stack[top + 2], stack[top + 3]);
+      break;
+    default:
+      stack[top] = applyUnary(instruction->opcode, stack[top]);
+    }
+  }
+
+  return stack[0];
+}
+
+Vec4f
+CompiledExpression::evaluate4(const Vec4f* slots) const
+{
+  Vec4f result;
+  if(!valid) return result;
+
+  static const __m128 signMask = _mm_set1_ps(-0.0f);
+  static const __m128 half = _mm_set1_ps(0.5f);
+  static const __m128 two = _mm_set1_ps(2.0f);
+
+  __m128 stack[maxStackSize];
+  int32 top = -1;
+
+  const Instruction* instruction = program.data();
+  const Instruction* programEnd = instruction + program.size();
+
+  for(; instruction != programEnd; instruction++)
+  {
+    switch(instruction->opcode)
+    {
+    case OP_CONSTANT: stack[++top] = _mm_set1_ps(instruction->constant); break;
+    case OP_VARIABLE: stack[++top] = _mm_loadu_ps(slots[instruction->slot].arr); break;
+    case OP_ADD: --top; stack[top] = _mm_add_ps(stack[top], stack[top + 1]); break;
+    case OP_SUB: --top; stack[top] = _mm_sub_ps(stack[top], stack[top + 1]); break;
+    case OP_MUL: --top; stack[top] = _mm_mul_ps(stack[top], stack[top + 1]); break;
+    case OP_DIV: --top; stack[top] = _mm_div_ps(stack[top], stack[top + 1]); break;
+      // Argument order matches std::min and std::max
+    case OP_MIN: --top; stack[top] = _mm_min_ps(stack[top + 1], stack[top]); break;
+    case OP_MAX: --top; stack[top] = _mm_max_ps(stack[top + 1], stack[top]); break;
+    case OP_ABS: stack[top] = _mm_andnot_ps(signMask, stack[top]); break;
+    case OP_BLEND:
+      {
+	top -= 3;
+	__m128 val1 = stack[top];
+	__m128 val2 = stack[top + 1];
+	__m128 t = stack[top + 2];
+	__m128 blendRange = stack[top + 3];
+
+	__m128 rangeStart = _mm_sub_ps(half, blendRange);
+	__m128 rangeEnd = _mm_add_ps(half, blendRange);
+	__m128 inRange = _mm_and_ps(_mm_cmpgt_ps(t, rangeStart), _mm_cmplt_ps(t, rangeEnd));
+
+	__m128 resultT = _mm_div_ps(_mm_sub_ps(t, rangeStart), _mm_mul_ps(blendRange, two));
+	__m128 blended = _mm_add_ps(val1, _mm_mul_ps(_mm_sub_ps(val2, val1), resultT));
+
+	// Outside of the range lower half takes val1 and upper val2
+	__m128 lower = _mm_cmplt_ps(t, half);
+	__m128 outside = _mm_or_ps(_mm_and_ps(lower, val1), _mm_andnot_ps(lower, val2));
+
+	stack[top] = _mm_or_ps(_mm_and_ps(inRange, blended), _mm_andnot_ps(inRange, outside));
+      } break;
+    case OP_POW:
+    case OP_FMOD:
+      {
+	// No SSE equivalent, doing it lane by lane
+	--top;
+	real32 left[4], right[4];
+	_mm_storeu_ps(left, stack[top]);
+	_mm_storeu_ps(right, stack[top + 1]);
+	for(int i = 0; i < 4; i++) left[i] = applyBinary(instruction->opcode, left[i], right[i]);
+	stack[top] = _mm_loadu_ps(left);
+      } break;
+    default:
+      {
+	real32 argument[4];
+	_mm_storeu_ps(argument, stack[top]);
+	for(int i = 0; i < 4; i++) argument[i] = applyUnary(instruction->opcode, argument[i]);
+	stack[top] = _mm_loadu_ps(argument);
+      }
+    }
+  }
+
+  _mm_storeu_ps(result.arr, stack[0]);
+  return result;
+}
+
 real32
 blendSmooth(real32 val1, real32 val2, real32 t, real32 blendRange)
 {
@@ -2,10 +2,12 @@
 
 #include <iostream>
 #include <list>
+#include <vector>
 #include <unordered_map>
 
 #include "jpb.h"
 #include "types.h"
+#include "Vector.h"
 
 // #define DEBUG_PARSER
 
@@ -27,6 +29,55 @@ struct Entry {
 typedef std::list<std::string> StringList;
 typedef std::list<Entry> EntryList;
 typedef std::unordered_map<std::string, float*> VariableMap;
+typedef std::vector<std::string> SlotNameList;
+
+enum OPCODE{
+  OP_CONSTANT,
+  OP_VARIABLE,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_POW,
+  OP_FMOD,
+  OP_MIN,
+  OP_MAX,
+  OP_SIN,
+  OP_COS,
+  OP_ABS,
+  OP_FLOOR,
+  OP_CEIL,
+  OP_BLEND,
+  OP_INVALID
+};
+
+struct Instruction {
+  OPCODE opcode;
+  union{
+    real32 constant;
+    int32 slot;
+  };
+};
+
+// Expression compiled once to flat postfix program, numbers are parsed
+// and variables resolved to indices into slot array passed on evaluation
+class DllExport CompiledExpression {
+ public:
+  static const int maxStackSize = 32;
+
+  bool isValid() const { return valid; }
+
+  real32 evaluate(const real32* slots) const;
+
+  // Evaluates 4 points at once, slots[i] holds values of i-th variable for each point
+  Vec4f evaluate4(const Vec4f* slots) const;
+
+ private:
+  friend class SimpleParser;
+
+  std::vector<Instruction> program;
+  bool valid = false;
+};
 
 class DllExport SimpleParser {
  public:
@@ -39,6 +90,9 @@ class DllExport SimpleParser {
   EntryList getReversePolish(std::string expression) const;
 
   static StringList getListOfVariables(const EntryList& reversePolish);
+
+  // Variables are looked up in slotNames, index in list is index of slot
+  CompiledExpression compile(const std::string& expression, const SlotNameList& slotNames) const;
  private:
   static const int maxOpStackSize = 16;
   const VariableMap* variableMap = NULL;
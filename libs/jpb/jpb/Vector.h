@@ -1,5 +1,7 @@
 #pragma once
 #include <functional>
+#include <cmath>
+#include <xmmintrin.h>
 
 #if 0
 
@@ -18,6 +20,12 @@
 #include <iostream>
 #include "types.h"
 
+// Everything in here is header only so vector math gets inlined in every
+// translation unit, constructors are constexpr and all types stay trivially copyable
+
+// Define before including to get Vec4 storage aliased with __m128 (Vec4::simd)
+// #define JPB_VEC4_M128
+
 enum CARDINAL_DIRECTION{
   CD_UP,
   CD_RIGHT,
@@ -31,36 +39,137 @@ public:
   T x;
   T y;
 
-  Vec2<T>(const T x=0, const T y=0) : x(x), y(y) {}
+  constexpr Vec2<T>(const T x=0, const T y=0) : x(x), y(y) {}
 
-  Vec2<T> operator+(Vec2<T>& vector) const ;
-  Vec2<T> operator-(const Vec2<T>& vector) const ;
-  Vec2<T> operator*(const float scalar) const ;
-  Vec2<T> operator/(const float scalar) const ;
+  constexpr Vec2<T> operator+(const Vec2<T>& vector) const
+  {
+    return Vec2<T>(x + vector.x, y + vector.y);
+  }
+  constexpr Vec2<T> operator-(const Vec2<T>& vector) const
+  {
+    return Vec2<T>(x - vector.x, y - vector.y);
+  }
+  constexpr Vec2<T> operator*(const float scalar) const
+  {
+    return Vec2<T>(x * scalar, y * scalar);
+  }
+  constexpr Vec2<T> operator/(const float scalar) const
+  {
+    return Vec2<T>(x / scalar, y / scalar);
+  }
 
-  void operator+=(const Vec2<T>& vector);
-  void operator-=(const Vec2<T>& vector);
-  void operator*=(const Vec2<T>& vector);
-  void operator*=(const float scalar);
+  void operator+=(const Vec2<T>& vector)
+  {
+    x += vector.x;
+    y += vector.y;
+  }
+  void operator-=(const Vec2<T>& vector)
+  {
+    x -= vector.x;
+    y -= vector.y;
+  }
+  void operator*=(const Vec2<T>& vector)
+  {
+    x *= vector.x;
+    y *= vector.y;
+  }
+  void operator*=(const float scalar)
+  {
+    x *= scalar;
+    y *= scalar;
+  }
 
-  bool operator==(const Vec2<T>& vector) const ;
-  bool operator!=(const Vec2<T>& vector) const ;
+  constexpr bool operator==(const Vec2<T>& vector) const
+  {
+    return x == vector.x && y == vector.y;
+  }
+  constexpr bool operator!=(const Vec2<T>& vector) const
+  {
+    return x != vector.x || y != vector.y;
+  }
 
-  float getLength() const ;
-  void normalize();
+  float getLength() const
+  {
+    return sqrt(pow(x, 2) + pow(y, 2));
+  }
+  void normalize()
+  {
+    float length = getLength();
+    x /= length;
+    y /= length;
+  }
 
-  static Vec2<T> normalize(const Vec2<T>& vector);
-  static Vec2<T> directionVector(float angle = rand()%360);
-  static Vec2<T> cardinalDirection(CARDINAL_DIRECTION cardinalDirection);
+  static Vec2<T> normalize(const Vec2<T>& vector)
+  {
+    Vec2<T> temp = vector;
+    temp.normalize();
+    return temp;
+  }
+  static Vec2<T> directionVector(float angle = rand()%360)
+  {
+    float radAng = ((M_PI)/180.0f) * angle;
+    return Vec2<T>(cos(radAng), -sin(radAng));
+  }
+  static Vec2<T> cardinalDirection(CARDINAL_DIRECTION cardinalDirection)
+  {
+    Vec2<T> result;
 
-  static float dotProduct(const Vec2<T>& vector, const T x, const T y);
-  static Vec2<float> lerp(const Vec2<T>& v1,const Vec2<T>& v2, const float t);
+    switch(cardinalDirection)
+    {
+    case CD_UP:
+      result = Vec2<T>(0, (T)-1);
+      break;
+    case CD_RIGHT:
+      result = Vec2<T>((T)1, 0);
+      break;
+    case CD_DOWN:
+      result = Vec2<T>(0, (T)1);
+      break;
+    case CD_LEFT:
+      result = Vec2<T>((T)-1, 0);
+      break;
+    default:
+      std::cout << "Incorrect direction \n";
+    }
 
-  void rotate(float angle);
+    return result;
+  }
+
+  static constexpr float dotProduct(const Vec2<T>& vector, const T x, const T y)
+  {
+    return vector.x * x + vector.y * y;
+  }
+  static Vec2<float> lerp(const Vec2<T>& v1,const Vec2<T>& v2, const float t)
+  {
+    return v1 + (v2 - v1) * t;
+  }
+
+  void rotate(float angle)
+  {
+    float radAng = (angle / 180.0f) * M_PI;
+
+    Vec2<T> rotatedVector;
+    rotatedVector.x = x * cos(radAng) - y * sin(radAng);
+    rotatedVector.y = x * sin(radAng) + y * cos(radAng);
+
+    *this = rotatedVector;
+  }
 
   // Returns X for lineEquation defined by the vector, starting at startPosition
-  float getXFor(real32 yValue, const Vec2<T>& startPosition) const ;
-  void showData() const;
+  float getXFor(real32 yValue, const Vec2<T>& startPosition) const
+  {
+    // For what x y value will be 0
+    // y = ax + b
+
+    real32 a = y / x;
+    real32 n_x = ((yValue - startPosition.y) / a) + startPosition.x;
+
+    return n_x;
+  }
+  void showData() const
+  {
+    std::cout << "x: " << x << " y: " << y << std::endl;
+  }
 };
 
 typedef Vec2<int32> Vec2i;
@@ -74,54 +183,170 @@ public:
   T y;
   T z;
 
-  Vec3<T>(const T x=0, const T y=0, const T z=0) : x(x), y(y), z(z) {}
+  constexpr Vec3<T>(const T x=0, const T y=0, const T z=0) : x(x), y(y), z(z) {}
+
+  constexpr Vec3<T> operator+(const Vec3<T>& vector) const
+  {
+    return Vec3<T>(x + vector.x, y + vector.y, z + vector.z);
+  }
+  constexpr Vec3<T> operator-(const Vec3<T>& vector) const
+  {
+    return Vec3<T>(x - vector.x, y - vector.y, z - vector.z);
+  }
+  constexpr Vec3<T> operator-() const
+  {
+    return Vec3<T>(x * -1.0f, y * -1.0f, z * -1.0f);
+  }
+  constexpr Vec3<T> operator*(const Vec3<T>& vector) const
+  {
+    return Vec3<T>(x * vector.x, y * vector.y, z * vector.z);
+  }
+  constexpr Vec3<T> operator*(const float scalar) const
+  {
+    return Vec3<T>(x * scalar, y * scalar, z * scalar);
+  }
+  constexpr Vec3<T> operator/(const float scalar) const
+  {
+    return Vec3<T>(x / scalar, y / scalar, z / scalar);
+  }
+
+  void operator+=(const Vec3<T>& vector)
+  {
+    x += vector.x;
+    y += vector.y;
+    z += vector.z;
+  }
+  void operator-=(const Vec3<T>& vector)
+  {
+    x -= vector.x;
+    y -= vector.y;
+    z -= vector.z;
+  }
+  void operator*=(const Vec3<T>& vector)
+  {
+    x *= vector.x;
+    y *= vector.y;
+    z *= vector.z;
+  }
+  void operator*=(const float scalar)
+  {
+    x *= scalar;
+    y *= scalar;
+    z *= scalar;
+  }
+  void operator/=(const float scalar)
+  {
+    x /= scalar;
+    y /= scalar;
+    z /= scalar;
+  }
+
+  constexpr bool operator==(const Vec3<T>& vector) const
+  {
+    return x == vector.x && y == vector.y && z == vector.z;
+  }
+  constexpr bool operator!=(const Vec3<T>& vector) const
+  {
+    return x != vector.x || y != vector.y || z != vector.z;
+  }
 
-  Vec3<T> operator+(Vec3<T>& vector) const ;
-  Vec3<T> operator-(const Vec3<T>& vector) const ;
-  Vec3<T> operator-() const
+  float getLength() const
+  {
+    return sqrt(pow(x, 2) + pow(y, 2) + pow(z, 2));
+  }
+  constexpr Vec2<T> toVec2() const
+  {
+    return Vec2<T>(x, y);
+  }
+  Vec3<real32> degToRad() const
   {
-    Vec3<T> result = *this;
-    result *= -1.0f;
+    Vec3<real32> result;
+    real32 angRadValue = (M_PI/180.0f);
+
+    result.x = angRadValue * x;
+    result.y = angRadValue * y;
+    result.z = angRadValue * z;
+
     return result;
   }
-  Vec3<T> operator*(const Vec3<T>& vector) const ;
-  Vec3<T> operator*(const float scalar) const ;
-  Vec3<T> operator/(const float scalar) const ;
 
-  void operator+=(const Vec3<T>& vector);
-  void operator-=(const Vec3<T>& vector);
-  void operator*=(const Vec3<T>& vector);
-  void operator*=(const float scalar);
-  void operator/=(const float scalar);
+  static Vec3<T> normalize(const Vec3<T>& vector)
+  {
+    Vec3<T> result = vector;
+    float length = vector.getLength();
+    result /= length;
+    return result;
+  }
 
-  bool operator==(const Vec3<T>& vector) const ;
-  bool operator!=(const Vec3<T>& vector) const ;
+  static constexpr real32 dotProduct(const Vec3<T>& v1, const Vec3<T>& v2)
+  {
+    return (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+  }
+  static constexpr Vec3<T> lerp(const Vec3<T>& v1, const Vec3<T>& v2, float t)
+  {
+    return v1 + (v2 - v1) * t ;
+  }
+  static constexpr Vec3<real32> cross(const Vec3<T>& v1, const Vec3<T>& v2)
+  {
+    return Vec3<real32>((v1.y * v2.z) - (v1.z * v2.y),
+			(v1.z * v2.x) - (v1.x * v2.z),
+			(v1.x * v2.y) - (v1.y * v2.x));
+  }
 
-  float getLength() const ;
-  Vec2<T> toVec2() const ;
-  Vec3<real32> degToRad() const ;
+  // Defined after Mat3
+  static Vec3<T> rotateAround(const Vec3<T> src, real32 angle, const Vec3<T>& orbital);
 
-  static Vec3<T> normalize(const Vec3<T>& vector);
+  void rotateAroundX(float radAngle)
+  {
+    Vec3<real32> rotatedPosition;
 
-  static float dotProduct(const Vec3<T>& v1, const Vec3<T>& v2);
-  static Vec3<T> lerp(const Vec3<T>& v1, const Vec3<T>& v2, float t);
-  static Vec3<real32> cross(const Vec3<T>& v1, const Vec3<T>& v2);
+    // Rotation
+    rotatedPosition.y = y * cos(radAngle) - z * sin(radAngle);
+    rotatedPosition.z = y * sin(radAngle) + z * cos(radAngle);
 
-  static Vec3<T> rotateAround(const Vec3<T> src, real32 angle, Vec3& orbital)
+    y = rotatedPosition.y;
+    z = rotatedPosition.z;
+  }
+  void rotateAroundY(float radAngle)
   {
-    Mat3 rotMat = Mat3::createRotationMatrix(angle, orbital);
-    return rotMat * src;
+    Vec3<real32> rotatedPosition;
+
+    // Rotation
+    rotatedPosition.x = x * cos(radAngle) - z * sin(radAngle);
+    rotatedPosition.z = x * sin(radAngle) + z * cos(radAngle);
+
+    x = rotatedPosition.x;
+    z = rotatedPosition.z;
   }
+  void rotateAroundZ(float radAngle)
+  {
+    Vec3<real32> rotatedPosition;
 
-  void rotateAroundX(float radAngle);
-  void rotateAroundY(float radAngle);
-  void rotateAroundZ(float radAngle);
+    // Rotation
+    rotatedPosition.x = x * cos(radAngle) - y * sin(radAngle);
+    rotatedPosition.y = x * sin(radAngle) + y * cos(radAngle);
 
-  void rotateAroundXDeg(float angle);
-  void rotateAroundYDeg(float angle);
-  void rotateAroundZDeg(float angle);
+    x = rotatedPosition.x;
+    y = rotatedPosition.y;
+  }
 
-  void showData() const;
+  void rotateAroundXDeg(float angle)
+  {
+    rotateAroundX((M_PI / 180.0f) * angle);
+  }
+  void rotateAroundYDeg(float angle)
+  {
+    rotateAroundY((M_PI / 180.0f) * angle);
+  }
+  void rotateAroundZDeg(float angle)
+  {
+    rotateAroundZ((M_PI / 180.0f) * angle);
+  }
+
+  void showData() const
+  {
+    std::cout << "x: " << x << " y: " << y << " z: " << z << std::endl;
+  }
 };
 
 typedef Vec3<int32> Vec3i;
@@ -129,7 +354,13 @@ typedef Vec3<uint32> Vec3u;
 typedef Vec3<real32> Vec3f;
 
 template <typename T>
-Vec2<T> normalize(const Vec2<T>& vector);
+inline Vec2<T> normalize(const Vec2<T>& vector)
+{
+  Vec2<T> resultVector;
+  float length = vector.getLength();
+  resultVector = vector / length;
+  return resultVector;
+}
 
 namespace std {
   template <> struct hash<Vec3i>
@@ -151,8 +382,9 @@ namespace std {
   };
 }
 
+// 16 byte aligned so it can be loaded straight into an SSE register
 template <typename T>
-class Vec4 {
+class alignas(16) Vec4 {
 public:
   union{
     struct{
@@ -162,25 +394,71 @@ public:
       T w;
     };
     T arr[4];
+#ifdef JPB_VEC4_M128
+    __m128 simd;
+#endif
   };
 
-  Vec4<T>(const T x=0, const T y=0, const T z=0, const T w=0) : x(x), y(y), z(z), w(w) {}
+  constexpr Vec4<T>(const T x=0, const T y=0, const T z=0, const T w=0) : x(x), y(y), z(z), w(w) {}
 
-  Vec4<T> operator*(const float scalar) const ;
-  Vec4<T> operator/(const float scalar) const ;
-  void operator+=(const float value) ;
+  constexpr Vec4<T> operator*(const float scalar) const
+  {
+    return Vec4<T>(x * scalar, y * scalar, z * scalar, w * scalar);
+  }
+  constexpr Vec4<T> operator/(const float scalar) const
+  {
+    return (*this) * (1.0f / scalar);
+  }
+  void operator+=(const float value)
+  {
+    x += value;
+    y += value;
+    z += value;
+    w += value;
+  }
 
-  void operator+=(const Vec4<T>& vector) ;
-  void operator*=(const float scalar) ;
+  void operator+=(const Vec4<T>& vector)
+  {
+    x += vector.x;
+    y += vector.y;
+    z += vector.z;
+    w += vector.w;
+  }
+  void operator*=(const float scalar)
+  {
+    x *= scalar;
+    y *= scalar;
+    z *= scalar;
+    w *= scalar;
+  }
 
-  T& operator[](const int index) ;
-  void showData() const;
+  T& operator[](const int index)
+  {
+    return arr[index];
+  }
+  const T& operator[](const int index) const
+  {
+    return arr[index];
+  }
+  void showData() const
+  {
+    std::cout << "x: " << x << " y: " << y << " z: " << z << " w: " << w << std::endl;
+  }
 };
 
 typedef Vec4<int32> Vec4i;
 typedef Vec4<uint32> Vec4u;
 typedef Vec4<real32> Vec4f;
 
+// Lanes of an SSE register in x, y, z, w order, aligned store since Vec4 is 16 byte aligned
+inline Vec4f
+storeVec4f(__m128 value)
+{
+  Vec4f result;
+  _mm_store_ps(result.arr, value);
+  return result;
+}
+
 class Mat3 {
 public:
   Mat3()
@@ -191,7 +469,7 @@ public:
   }
   Vec3f m[3];
 
-  Vec3f operator*(const Vec3f& vector)
+  Vec3f operator*(const Vec3f& vector) const
   {
     Vec3f result;
     result.x = Vec3f::dotProduct(m[0], vector);
@@ -231,6 +509,14 @@ public:
 
 };
 
+template <typename T>
+inline Vec3<T>
+Vec3<T>::rotateAround(const Vec3<T> src, real32 angle, const Vec3<T>& orbital)
+{
+  Mat3 rotMat = Mat3::createRotationMatrix(angle, orbital);
+  return rotMat * src;
+}
+
 class Mat4 {
 public:
   Mat4()
@@ -323,5 +609,3 @@ public:
 
 
 };
-
-#include "Vector.cpp"
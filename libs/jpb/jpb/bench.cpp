@@ -0,0 +1,221 @@
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "Noise.h"
+
+typedef std::chrono::high_resolution_clock BenchClock;
+
+// Computes noise for count points, the results are summed so compiler can't drop the work
+typedef std::function<real32(const Vec2f points[], int32 count, const NoiseParams& noiseParams)> SampleFunction;
+
+static const int32 pointCount = 4096;
+static const real64 minBenchTime = 0.25;
+
+static std::vector<Vec2f> benchPoints;
+static real32 benchSink = 0;
+
+// Samples/s of the row speedups are relative to: the last scalar (width 1) row,
+// or the first row after a header
+static real64 baselineSamplesPerSecond = 0;
+
+static void
+printHeader(const char* title)
+{
+  baselineSamplesPerSecond = 0;
+  std::cout << std::endl << title << std::endl;
+  std::cout << std::left << std::setw(24) << "Name" << std::right
+	    << std::setw(8) << "Octaves" << std::setw(8) << "Width"
+	    << std::setw(16) << "Samples/s" << std::setw(12) << "ns/sample"
+	    << std::setw(10) << "Speedup" << std::endl;
+}
+
+static void
+printResult(const char* name, int32 octaves, int32 width, uint64 samples, real64 seconds)
+{
+  real64 samplesPerSecond = samples / seconds;
+  real64 nsPerSample = (seconds * 1e9) / samples;
+
+  if(width == 1 || baselineSamplesPerSecond == 0) baselineSamplesPerSecond = samplesPerSecond;
+  real64 speedup = samplesPerSecond / baselineSamplesPerSecond;
+
+  std::cout << std::left << std::setw(24) << name << std::right
+	    << std::setw(8) << octaves << std::setw(8) << width
+	    << std::setw(16) << std::fixed << std::setprecision(0) << samplesPerSecond
+	    << std::setw(12) << std::setprecision(2) << nsPerSample
+	    << std::setw(9) << std::setprecision(2) << speedup << "x" << std::endl;
+}
+
+static void
+benchNoise(const char* name, int32 width, int32 octaves, const SampleFunction& sampleFunction)
+{
+  NoiseParams noiseParams = {0.05f, octaves, 2.0f, 0.5f};
+
+  // Warm up, Worley table and CPU detection are initialized on first use
+  benchSink += sampleFunction(benchPoints.data(), pointCount, noiseParams);
+
+  uint64 samples = 0;
+  real64 seconds = 0;
+  BenchClock::time_point start = BenchClock::now();
+
+  while(seconds < minBenchTime)
+  {
+    benchSink += sampleFunction(benchPoints.data(), pointCount, noiseParams);
+    samples += pointCount;
+    seconds = std::chrono::duration<real64>(BenchClock::now() - start).count();
+  }
+
+  printResult(name, octaves, width, samples, seconds);
+}
+
+static void
+benchMap(const char* name, int32 sideLength, const std::function<std::vector<Vec4f>()>& mapFunction)
+{
+  uint64 samples = 0;
+  real64 seconds = 0;
+  BenchClock::time_point start = BenchClock::now();
+
+  while(seconds < minBenchTime)
+  {
+    std::vector<Vec4f> map = mapFunction();
+    benchSink += map[map.size() / 2].y;
+    samples += map.size();
+    seconds = std::chrono::duration<real64>(BenchClock::now() - start).count();
+  }
+
+  printResult(name, 3, sideLength, samples, seconds);
+}
+
+static real32
+sumPerlinScalar(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  for(int32 i = 0; i < count; i++) sum += Noise::sumPerlin(points[i], noiseParams);
+  return sum;
+}
+
+static real32
+sumPerlin4(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  for(int32 i = 0; i < count; i += 4) sum += Noise::sumPerlinFast(points + i, noiseParams).x;
+  return sum;
+}
+
+static real32
+sumPerlinWide(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  Vec4f result[2];
+  for(int32 i = 0; i < count; i += 8)
+  {
+    Noise::sumPerlin8(points + i, noiseParams, result);
+    sum += result[0].x + result[1].x;
+  }
+  return sum;
+}
+
+static real32
+sumValueScalar(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  for(int32 i = 0; i < count; i++) sum += Noise::sumValue(points[i], noiseParams);
+  return sum;
+}
+
+static real32
+sumValueWide(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  Vec4f result[2];
+  for(int32 i = 0; i < count; i += 8)
+  {
+    Noise::sumValue8(points + i, noiseParams, result);
+    sum += result[0].x + result[1].x;
+  }
+  return sum;
+}
+
+static real32
+sumWorleyScalar(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  for(int32 i = 0; i < count; i++) sum += Noise::sumWorley(points[i], noiseParams);
+  return sum;
+}
+
+static real32
+sumWorley4(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  for(int32 i = 0; i < count; i += 4) sum += Noise::sumWorleyFast(points + i, noiseParams).x;
+  return sum;
+}
+
+static real32
+sumWorleyWide(const Vec2f points[], int32 count, const NoiseParams& noiseParams)
+{
+  real32 sum = 0;
+  Vec4f result[2];
+  for(int32 i = 0; i < count; i += 8)
+  {
+    Noise::sumWorley8(points + i, noiseParams, result);
+    sum += result[0].x + result[1].x;
+  }
+  return sum;
+}
+
+int main()
+{
+  benchPoints.resize(pointCount);
+  for(int32 i = 0; i < pointCount; i++)
+  {
+    benchPoints[i] = Vec2f((i % 64) * 0.731f - 20.0f, (i / 64) * 0.593f + 11.0f);
+  }
+
+  std::cout << "AVX2 supported: " << (Noise::isAvx2Supported() ? "yes" : "no") << std::endl;
+
+  printHeader("Noise sums");
+
+  int32 octaveCounts[] = {1, 3, 6};
+  for(int octaveIt = 0; octaveIt < 3; octaveIt++)
+  {
+    int32 octaves = octaveCounts[octaveIt];
+
+    benchNoise("sumPerlin", 1, octaves, sumPerlinScalar);
+    benchNoise("sumPerlinFast", 4, octaves, sumPerlin4);
+
+    Noise::setAvx2Enabled(false);
+    benchNoise("sumPerlin8 fallback", 8, octaves, sumPerlinWide);
+    Noise::setAvx2Enabled(true);
+    if(Noise::isAvx2Supported()) benchNoise("sumPerlin8 AVX2", 8, octaves, sumPerlinWide);
+
+    benchNoise("sumValue", 1, octaves, sumValueScalar);
+    if(Noise::isAvx2Supported()) benchNoise("sumValue8 AVX2", 8, octaves, sumValueWide);
+
+    benchNoise("sumWorley", 1, octaves, sumWorleyScalar);
+    benchNoise("sumWorleyFast", 4, octaves, sumWorley4);
+    if(Noise::isAvx2Supported()) benchNoise("sumWorley8 AVX2", 8, octaves, sumWorleyWide);
+  }
+
+  // Whole maps, width column is the side length
+  printHeader("Maps");
+
+  const int32 sideLength = 257;
+  std::list<GenData> genDataList;
+  GenDataMap genDataMap;
+
+  GenData genData = { NT_PERLIN, {0.05f, 3, 2.0f, 0.5f}, 1.0f };
+  genDataList.push_back(genData);
+  genDataMap[1] = genData;
+
+  benchMap("getMap", sideLength, [&]() { return Noise::getMap(Vec2f(0, 0), sideLength, genDataList, "Map1"); });
+  benchMap("getMapFast", sideLength, [&]() { return Noise::getMapFast(Vec2f(0, 0), sideLength, genDataMap, "Map1"); });
+  benchMap("getMapParallel", sideLength, [&]() { return Noise::getMapParallel(Vec2f(0, 0), sideLength, genDataMap, "Map1"); });
+
+  std::cout << std::endl << "Sink: " << benchSink << std::endl;
+
+  return 0;
+}
@@ -17,14 +17,21 @@ set Libs=
 
 set FilesToCompile= ^
 ../jpb/Noise.cpp ^
+../jpb/NoiseCache.cpp ^
 ../jpb/SimpleParser.cpp ^
 ../jpb/Profiler.cpp
 
 set FilesToLink= ^
 Noise.obj ^
+NoiseAvx2.obj ^
+NoiseCache.obj ^
 SimpleParser.obj ^
 Profiler.obj
 
+REM AVX2 kernels are compiled separately, the rest of the library has to run on any x64 CPU
+set Avx2Files= ^
+../jpb/NoiseAvx2.cpp
+
 REM Zi(Generate Debug information), FC(Full Path To Source), O2(Fast Code)
 
 set CompilerOptions=%Defines% /FC /EHsc /MD /MP /wd4503 /nologo %IncludeDirectories%
@@ -45,7 +52,8 @@ echo compillingDll
 echo -----------------------------------------------
 echo.
 
-cl %CompilerOptions% /Zi /O2x /DJPB_DLL_BUILD %FilesToCompile% %Libs% /link /dll /OUT:..\lib\jpb.dll /implib:..\lib\jpb.lib
+cl %CompilerOptions% /c /Zi /O2x /arch:AVX2 /DJPB_DLL_BUILD %Avx2Files%
+cl %CompilerOptions% /Zi /O2x /DJPB_DLL_BUILD %FilesToCompile% NoiseAvx2.obj %Libs% /link /dll /OUT:..\lib\jpb.dll /implib:..\lib\jpb.lib
 
 copy ..\lib\jpb.dll e:\Projekty\ProcGen\build\jpb.dll
 copy ..\lib\jpb.dll e:\Projekty\xWorkingProjects\RoqueLike\build\jpb.dll
@@ -62,6 +70,7 @@ echo Compilling Static lib
 echo -----------------------------------------------
 echo.
 
+cl %CompilerOptions% /c /O2x /Zi /arch:AVX2 %Avx2Files%
 cl %CompilerOptions% /c /O2x /Zi %FilesToCompile% %Libs%
 lib /nologo %FilesToLink% /OUT:..\lib\jpb_s.lib
 
@@ -77,6 +86,25 @@ echo.
 
 cl %CompilerOptions% /Zi ..\jpb\test.cpp ..\lib\%TestLib%
 
+echo.
+echo runningTest
+test.exe
+if errorlevel 1 (
+echo Tests failed
+popd
+exit /b 1
+)
+
+echo.
+echo -----------------------------------------------
+
+echo.
+echo compilingBench
+echo -----------------------------------------------
+echo.
+
+cl %CompilerOptions% /O2x /Zi ..\jpb\bench.cpp ..\lib\%TestLib%
+
 echo.
 echo -----------------------------------------------
 
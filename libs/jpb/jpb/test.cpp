@@ -5,6 +5,7 @@
 #include "Profiler.h"
 
 #include "SimpleParser.h"
+#include "NoiseCache.h"
 
 void noiseTest()
 {
@@ -54,6 +55,293 @@ void noiseTest()
   }
 }
 
+// Reference values of scalar noise, SIMD paths are checked against them
+// so accuracy drift in any of them shows up here
+struct GoldenValue {
+  Vec2f point;
+  real32 perlin;
+  real32 perlinDetailed;
+  real32 value;
+  real32 valueDetailed;
+};
+
+bool goldenTest()
+{
+  const real32 tolerance = 0.00001f;
+  bool correct = true;
+
+  NoiseParams noiseParams = {0.05f, 3, 2.0f, 0.5f};
+  NoiseParams detailedParams = {1.3f, 5, 2.1f, 0.6f};
+
+  GoldenValue goldenValues[] = {
+    { Vec2f(0.30f, 0.70f), -0.0317760f, -0.0481523f, 0.0695687f, 0.6010113f },
+    { Vec2f(-12.25f, 3.50f), -0.1332875f, -0.0291300f, 0.1905952f, 0.5311578f },
+    { Vec2f(100.10f, -42.90f), -0.1129509f, 0.1113181f, 0.8542914f, 0.4112883f },
+    { Vec2f(7.77f, 7.77f), -0.1116034f, 0.1551189f, 0.5538025f, 0.4251460f },
+    { Vec2f(-0.50f, -250.30f), -0.0295983f, 0.0397415f, 0.3971776f, 0.5145835f }
+  };
+
+  // Every point repeated in all lanes so the wide paths see it in each of them
+  for(int goldenIt = 0; goldenIt < 5; goldenIt++)
+  {
+    const GoldenValue& golden = goldenValues[goldenIt];
+    Vec2f points[8];
+    for(int i = 0; i < 8; i++) points[i] = golden.point;
+
+    real32 scalarResults[4] = {
+      Noise::sumPerlin(golden.point, noiseParams),
+      Noise::sumPerlin(golden.point, detailedParams),
+      Noise::sumValue(golden.point, noiseParams),
+      Noise::sumValue(golden.point, detailedParams)
+    };
+
+    Vec4f sseResults[2] = {
+      Noise::sumPerlinFast(points, noiseParams),
+      Noise::sumPerlinFast(points, detailedParams)
+    };
+
+    Vec4f wideResults[4][2];
+    Noise::sumPerlin8(points, noiseParams, wideResults[0]);
+    Noise::sumPerlin8(points, detailedParams, wideResults[1]);
+    Noise::sumValue8(points, noiseParams, wideResults[2]);
+    Noise::sumValue8(points, detailedParams, wideResults[3]);
+
+    real32 expected[4] = { golden.perlin, golden.perlinDetailed, golden.value, golden.valueDetailed };
+
+    for(int resultIt = 0; resultIt < 4; resultIt++)
+    {
+      bool matches = fabsf(scalarResults[resultIt] - expected[resultIt]) < tolerance;
+
+      for(int i = 0; i < 8; i++)
+	matches = matches && fabsf(wideResults[resultIt][i / 4][i % 4] - expected[resultIt]) < tolerance;
+
+      // smoothFast is only used by SSE perlin
+      if(resultIt < 2)
+	for(int i = 0; i < 4; i++)
+	  matches = matches && fabsf(sseResults[resultIt][i] - expected[resultIt]) < tolerance;
+
+      if(!matches)
+      {
+	std::cout << "Golden value mismatch at: " << golden.point.x << " " << golden.point.y
+		  << " result: " << resultIt << std::endl;
+	correct = false;
+      }
+    }
+  }
+
+  std::cout << "Golden test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Checks that scalar, SSE and AVX2 noise paths give the same values
+bool simdTest()
+{
+  const real32 tolerance = 0.0001f;
+  bool correct = true;
+
+  NoiseParams noiseParamsList[] = {
+    {0.05f, 3, 2.0f, 0.5f},
+    {0.2f, 1, 2.0f, 0.4f},
+    {1.3f, 5, 2.1f, 0.6f}
+  };
+
+  std::cout << "AVX2 supported: " << (Noise::isAvx2Supported() ? "yes" : "no") << std::endl;
+
+  for(int paramsIt = 0; paramsIt < 3; paramsIt++)
+  {
+    const NoiseParams& noiseParams = noiseParamsList[paramsIt];
+
+    for(int batch = 0; batch < 1000; batch++)
+    {
+      Vec2f points[8];
+      for(int i = 0; i < 8; i++)
+      {
+	points[i] = Vec2f((batch * 8 + i) * 0.37f - 300.0f, (batch % 91) * 1.7f - 77.0f);
+      }
+
+      Vec4f perlinWide[2];
+      Vec4f valueWide[2];
+      Vec4f perlinFallback[2];
+      Vec4f valueFallback[2];
+      Vec4f worleyWide[2];
+      Vec4f worleyFallback[2];
+
+      Noise::setAvx2Enabled(true);
+      Noise::sumPerlin8(points, noiseParams, perlinWide);
+      Noise::sumValue8(points, noiseParams, valueWide);
+      Noise::sumWorley8(points, noiseParams, worleyWide);
+
+      Noise::setAvx2Enabled(false);
+      Noise::sumPerlin8(points, noiseParams, perlinFallback);
+      Noise::sumValue8(points, noiseParams, valueFallback);
+      Noise::sumWorley8(points, noiseParams, worleyFallback);
+
+      for(int i = 0; i < 8; i++)
+      {
+	real32 perlinScalar = Noise::sumPerlin(points[i], noiseParams);
+	real32 valueScalar = Noise::sumValue(points[i], noiseParams);
+	real32 worleyScalar = Noise::sumWorley(points[i], noiseParams);
+
+	if(fabsf(perlinWide[i / 4][i % 4] - perlinScalar) > tolerance ||
+	   fabsf(perlinFallback[i / 4][i % 4] - perlinScalar) > tolerance ||
+	   fabsf(valueWide[i / 4][i % 4] - valueScalar) > tolerance ||
+	   fabsf(valueFallback[i / 4][i % 4] - valueScalar) > tolerance ||
+	   fabsf(worleyWide[i / 4][i % 4] - worleyScalar) > tolerance ||
+	   fabsf(worleyFallback[i / 4][i % 4] - worleyScalar) > tolerance)
+	{
+	  std::cout << "Noise paths differ at: " << points[i].x << " " << points[i].y << std::endl;
+	  correct = false;
+	}
+      }
+    }
+  }
+
+  // Every Worley and distance type, the AVX2 kernel masks them lane by lane
+  for(int32 worleyType = WT_F2SUBF1; worleyType <= WT_F1MULF2; worleyType++)
+  {
+    for(int32 distanceType = DT_EUCLDIAN_SQUARED; distanceType <= DT_CHEBYSHEV_MIN; distanceType++)
+    {
+      NoiseParams noiseParams = {0.9f, 2, 2.0f, 0.5f, worleyType, distanceType};
+
+      for(int batch = 0; batch < 100; batch++)
+      {
+	Vec2f points[8];
+	for(int i = 0; i < 8; i++)
+	{
+	  points[i] = Vec2f((batch * 8 + i) * 0.37f - 30.0f, (batch % 13) * 1.7f - 7.0f);
+	}
+
+	Vec4f worleyWide[2];
+	Noise::setAvx2Enabled(true);
+	Noise::sumWorley8(points, noiseParams, worleyWide);
+	Noise::setAvx2Enabled(false);
+
+	for(int i = 0; i < 8; i++)
+	{
+	  if(fabsf(worleyWide[i / 4][i % 4] - Noise::sumWorley(points[i], noiseParams)) > tolerance)
+	  {
+	    std::cout << "Worley paths differ for type: " << worleyType << " " << distanceType << std::endl;
+	    correct = false;
+	    break;
+	  }
+	}
+      }
+    }
+  }
+
+  // Worley maps from the AVX2 kernel match the SSE ones
+  std::unordered_map<int32,GenData> worleyDataMap;
+  GenData worleyData = { NT_WORLEY, {0.2f, 1, 2.0f, 0.4f}, 2.0f };
+  worleyDataMap[1] = worleyData;
+
+  Noise::setAvx2Enabled(true);
+  std::vector<Vec4f> worleyMapWide = Noise::getMapFast(Vec2f(5.0f, 1.0f), 33, worleyDataMap, "Map1");
+  Noise::setAvx2Enabled(false);
+  std::vector<Vec4f> worleyMapFallback = Noise::getMapFast(Vec2f(5.0f, 1.0f), 33, worleyDataMap, "Map1");
+
+  for(int i = 0; i < worleyMapWide.size(); i++)
+  {
+    if(fabsf(worleyMapWide[i].y - worleyMapFallback[i].y) > tolerance)
+    {
+      std::cout << "Worley map differs with AVX2 at: " << i << std::endl;
+      correct = false;
+      break;
+    }
+  }
+
+  Noise::setAvx2Enabled(true);
+
+  std::cout << "Simd test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Parallel map has to match serial one exactly
+bool parallelMapTest()
+{
+  std::unordered_map<int32,GenData> genDataMap;
+
+  GenData perlinData = { NT_PERLIN, {0.05f, 3, 2.0f, 0.5f}, 1.0f };
+  GenData worleyData = { NT_WORLEY, {0.2f, 1, 2.0f, 0.4f}, 2.0f };
+  genDataMap[1] = perlinData;
+  genDataMap[2] = worleyData;
+
+  std::vector<Vec4f> serialMap = Noise::getMapFast(Vec2f(3.0f, -7.0f), 257, genDataMap, "Map1 * Map2 + x", 4.0f, true);
+  bool correct = true;
+
+  // Workers are kept between calls, later maps reuse them with any thread count
+  int32 threadCounts[] = {0, 3, 1, 0};
+  for(int threadIt = 0; threadIt < 4; threadIt++)
+  {
+    std::vector<Vec4f> parallelMap = Noise::getMapParallel(Vec2f(3.0f, -7.0f), 257, genDataMap, "Map1 * Map2 + x", 4.0f, true,
+							   threadCounts[threadIt]);
+
+    correct = correct && serialMap.size() == parallelMap.size();
+    for(int i = 0; correct && i < serialMap.size(); i++)
+    {
+      for(int j = 0; j < 4; j++)
+      {
+	if(serialMap[i][j] != parallelMap[i][j])
+	{
+	  std::cout << "Parallel map differs at: " << i << std::endl;
+	  correct = false;
+	  break;
+	}
+      }
+    }
+  }
+
+  std::cout << "Parallel map test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Cached maps have to match getMapFast, changing one layer samples only that layer again
+// and panning samples only the tiles that weren't cached yet
+bool tileCacheTest()
+{
+  const real32 tolerance = 0.001f;
+
+  NoiseTileCache tileCache;
+  GenDataMap genDataMap;
+
+  GenData perlinData = { NT_PERLIN, {0.05f, 3, 2.0f, 0.5f}, 1.0f };
+  GenData valueData = { NT_VALUE, {0.2f, 2, 2.0f, 0.4f}, 2.0f };
+  genDataMap[1] = perlinData;
+  genDataMap[2] = valueData;
+
+  auto isSameMap = [tolerance](const std::vector<Vec4f>& map, const std::vector<Vec4f>& cachedMap)
+    {
+      if(map.size() != cachedMap.size()) return false;
+      for(int i = 0; i < map.size(); i++)
+      {
+	if(fabsf(map[i][1] - cachedMap[i][1]) > tolerance) return false;
+      }
+      return true;
+    };
+
+  // 65 samples 1/64 apart starting at lattice column 32 and row -160 cover 3x3 tiles of 32
+  std::vector<Vec4f> map = Noise::getMapFast(Vec2f(1.0f, 2.0f), 65, genDataMap, "Map1 + Map2");
+  NoiseMapPtr cachedMap = tileCache.getMap(Vec2f(1.0f, 2.0f), 65, genDataMap, "Map1 + Map2");
+  tileCache.getMap(Vec2f(1.0f, 2.0f), 65, genDataMap, "Map1 + Map2");
+
+  bool correct = isSameMap(map, *cachedMap);
+  correct = correct && tileCache.getMapHits() == 1 && tileCache.getLayerMisses() == 18;
+
+  // Panning by 40 samples reuses two columns of tiles and samples one new column per layer
+  map = Noise::getMapFast(Vec2f(1.625f, 2.0f), 65, genDataMap, "Map1 + Map2");
+  cachedMap = tileCache.getMap(Vec2f(1.625f, 2.0f), 65, genDataMap, "Map1 + Map2");
+  correct = correct && isSameMap(map, *cachedMap);
+  correct = correct && tileCache.getLayerHits() == 12 && tileCache.getLayerMisses() == 24;
+
+  genDataMap[2].scale = 3.0f;
+  map = Noise::getMapFast(Vec2f(1.0f, 2.0f), 65, genDataMap, "Map1 + Map2");
+  cachedMap = tileCache.getMap(Vec2f(1.0f, 2.0f), 65, genDataMap, "Map1 + Map2");
+  correct = correct && isSameMap(map, *cachedMap);
+  correct = correct && tileCache.getLayerHits() == 21 && tileCache.getLayerMisses() == 33;
+
+  std::cout << "Tile cache test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
 void parserTest()
 {
   SimpleParser sp;
@@ -120,10 +408,15 @@ void matTest()
 
 int main()
 {
+  // Non-zero exit code when any test fails so the build notices
+  int32 failedCount = 0;
+  if(!goldenTest()) failedCount++;
+  if(!simdTest()) failedCount++;
+  if(!parallelMapTest()) failedCount++;
+  if(!tileCacheTest()) failedCount++;
   noiseTest();
   // parserTest();
   // matTest();
 
-
-  return 0;
+  return failedCount;
 }
@@ -0,0 +1,72 @@
+#include "AIScheduler.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "Entity.h"
+
+AIScheduler::AIScheduler()
+{
+  // Snakes only strike when lined up with the player, so they look more often
+  decisionRates[AI_RAT] = { 0.2f, 32 };
+  decisionRates[AI_SNAKE] = { 0.1f, 32 };
+  decisionRates[AI_FOLLOWER] = { 0.2f, 32 };
+  decisionRates[AI_CANNON] = { 0.25f, 16 };
+}
+
+void
+AIScheduler::setDecisionRate(AI_TYPE aiType, const AIDecisionRate& decisionRate)
+{
+  assert(aiType < AI_TYPE_COUNT && decisionRate.period >= 0 && decisionRate.budget > 0);
+  decisionRates[aiType] = decisionRate;
+}
+
+void
+AIScheduler::schedule(const std::vector<Entity*>& entities, const std::vector<float>& updateDeltas,
+		      std::vector<float>& thinkTimes)
+{
+  thinkTimes.assign(entities.size(), -1.0f);
+
+  for(int32 i = 0; i < (int32)entities.size(); i++)
+  {
+    Entity* entity = entities[i];
+    AI_TYPE aiType = entity->getAIType();
+    if(aiType == AI_NONE) continue;
+
+    float period = decisionRates[aiType].period;
+
+    // Random first phase, so mobs spawned together don't keep deciding on the same tick
+    if(!entity->hasThinkPhase)
+    {
+      entity->timeSinceThink = period * (float)(rand()%100) / 100.0f;
+      entity->hasThinkPhase = true;
+    }
+
+    entity->timeSinceThink += updateDeltas[i];
+    if(entity->timeSinceThink >= period) dueEntities[aiType].push_back(i);
+  }
+
+  for(int32 aiType = 0; aiType < AI_TYPE_COUNT; aiType++)
+  {
+    std::vector<int32>& due = dueEntities[aiType];
+    int32 budget = decisionRates[aiType].budget;
+
+    if((int32)due.size() > budget)
+    {
+      std::nth_element(due.begin(), due.begin() + budget, due.end(),
+		       [&entities](int32 index1, int32 index2)
+		       {
+			 return entities[index1]->timeSinceThink > entities[index2]->timeSinceThink;
+		       });
+      due.resize(budget);
+    }
+
+    for(auto index = due.begin(); index != due.end(); index++)
+    {
+      thinkTimes[*index] = entities[*index]->timeSinceThink;
+      entities[*index]->timeSinceThink = 0;
+    }
+    due.clear();
+  }
+}
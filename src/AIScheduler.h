@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+#include "Types.h"
+
+class Entity;
+
+enum AI_TYPE{
+  AI_RAT,
+  AI_SNAKE,
+  AI_FOLLOWER,
+  AI_CANNON,
+  AI_TYPE_COUNT,
+  AI_NONE = AI_TYPE_COUNT
+};
+
+struct AIDecisionRate {
+  // Seconds between two decisions of a mob
+  float period;
+
+  // Most mobs of the type that decide in one tick, the rest waits for the next one
+  int32 budget;
+};
+
+// Decides which mobs run their perception and target selection (Entity::think) this tick,
+// per tick steering stays in update
+class AIScheduler{
+public:
+  AIScheduler();
+
+  void setDecisionRate(AI_TYPE aiType, const AIDecisionRate& decisionRate);
+  const AIDecisionRate& getDecisionRate(AI_TYPE aiType) const { return decisionRates[aiType]; }
+
+  // thinkTimes gets the time since the last decision for entities that think this tick, -1 for the rest
+  void schedule(const std::vector<Entity*>& entities, const std::vector<float>& updateDeltas,
+		std::vector<float>& thinkTimes);
+
+private:
+  AIDecisionRate decisionRates[AI_TYPE_COUNT];
+
+  // Indices of entities due to think by type, most overdue are picked first
+  std::vector<int32> dueEntities[AI_TYPE_COUNT];
+};
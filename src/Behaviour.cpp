@@ -0,0 +1,59 @@
+#include "Behaviour.h"
+
+#include <cmath>
+
+#include "Entity.h"
+
+BehaviourScheduler::BehaviourScheduler(float slotDuration, int32 slotCount) :
+  slotDuration(slotDuration), accumulatedTime(0), currentSlot(0)
+{
+  slots.resize(slotCount);
+}
+
+void
+BehaviourScheduler::schedule(const std::shared_ptr<Entity>& entityPtr, float sleepTime)
+{
+  int32 slotCount = (int32)slots.size();
+
+  // At least one slot ahead, the current one was already handed out
+  int32 slotDelta = (int32)ceilf(sleepTime / slotDuration);
+  if(slotDelta < 1) slotDelta = 1;
+
+  SleepingBehaviour sleepingBehaviour;
+  sleepingBehaviour.entity = entityPtr;
+  sleepingBehaviour.remainingTurns = (slotDelta - 1) / slotCount;
+
+  slots[(currentSlot + slotDelta) % slotCount].push_back(sleepingBehaviour);
+}
+
+void
+BehaviourScheduler::advance(float lastDelta, std::vector<std::shared_ptr<Entity>>& dueEntities)
+{
+  dueEntities.clear();
+  accumulatedTime += lastDelta;
+
+  while(accumulatedTime >= slotDuration)
+  {
+    accumulatedTime -= slotDuration;
+    currentSlot = (currentSlot + 1) % (int32)slots.size();
+
+    std::vector<SleepingBehaviour>& slot = slots[currentSlot];
+    size_t i = 0;
+    while(i < slot.size())
+    {
+      if(slot[i].remainingTurns > 0)
+      {
+	slot[i].remainingTurns--;
+	i++;
+	continue;
+      }
+
+      // Entities removed from the level while sleeping are dropped here
+      std::shared_ptr<Entity> entityPtr = slot[i].entity.lock();
+      if(entityPtr && entityPtr->isAlive()) dueEntities.push_back(entityPtr);
+
+      slot[i] = slot.back();
+      slot.pop_back();
+    }
+  }
+}
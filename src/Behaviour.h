@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "Types.h"
+
+class Entity;
+
+// Where a behaviour continues the next time it's resumed
+// Behaviours are stackless coroutines written with the macros below, so nothing
+// declared inside of them survives a sleep, whatever has to is kept in the entity
+struct BehaviourState {
+  int32 resumePoint = 0;
+};
+
+// A resume function returns the seconds it wants to sleep, negative ends the behaviour
+#define BEHAVIOUR_BEGIN(state) switch((state).resumePoint) { case 0:
+
+#define BEHAVIOUR_SLEEP(state, seconds)		\
+  do {						\
+    (state).resumePoint = __LINE__;		\
+    return (seconds);				\
+  case __LINE__:;				\
+  } while(0)
+
+// Conditions are checked every pollPeriod seconds
+#define BEHAVIOUR_WAIT_UNTIL(state, condition, pollPeriod)	\
+  while(!(condition)) BEHAVIOUR_SLEEP(state, pollPeriod)
+
+#define BEHAVIOUR_END(state) } (state).resumePoint = 0; return -1.0f
+
+// Timer wheel of sleeping behaviours, only the ones whose sleep elapsed are handed out
+// Sleeps longer than a turn of the wheel go around it several times
+class BehaviourScheduler{
+public:
+  BehaviourScheduler(float slotDuration = 0.05f, int32 slotCount = 64);
+
+  void schedule(const std::shared_ptr<Entity>& entityPtr, float sleepTime);
+
+  // Moves the wheel by lastDelta and collects entities that are due and still exist
+  void advance(float lastDelta, std::vector<std::shared_ptr<Entity>>& dueEntities);
+
+private:
+  struct SleepingBehaviour {
+    std::weak_ptr<Entity> entity;
+    int32 remainingTurns;
+  };
+
+  float slotDuration;
+  float accumulatedTime;
+  int32 currentSlot;
+  std::vector<std::vector<SleepingBehaviour>> slots;
+};
@@ -0,0 +1,128 @@
+#include "CollisionSnapshot.h"
+
+#include <algorithm>
+#include <math.h>
+
+#include "Entity.h"
+
+void
+CollisionSnapshot::clear(const Vec2i& tileChunkSize)
+{
+  this->tileChunkSize = tileChunkSize;
+  movedRowCount = 0;
+
+  entities.clear();
+  positions.clear();
+  collisionRects.clear();
+  isCollidable.clear();
+  hasMoved.clear();
+  surfaces.clear();
+  rowGrid.clear();
+}
+
+int32
+CollisionSnapshot::addEntity(Entity* entity)
+{
+  entities.push_back(entity);
+  positions.push_back(entity->getPosition());
+  collisionRects.push_back(entity->getCollisionRect());
+  isCollidable.push_back(entity->isAlive() && entity->canCollideWithEntities());
+  hasMoved.push_back(0);
+  surfaces.push_back(SurfaceSample());
+
+  int32 row = (int32)entities.size() - 1;
+  if(isCollidable[row]) addToGrid(row);
+  return row;
+}
+
+void
+CollisionSnapshot::moveRow(int32 row, const EntityPosition& position)
+{
+  removeFromGrid(row);
+  positions[row] = position;
+  addToGrid(row);
+
+  if(!hasMoved[row]) movedRowCount++;
+  hasMoved[row] = 1;
+}
+
+void
+CollisionSnapshot::getSweptRows(const EntityPosition& basePosition, const FloatRect& collisionRect,
+				const Vec2f& deltaVec, std::vector<int32>& rows) const
+{
+  rows.clear();
+  if(rowGrid.empty()) return;
+
+  // Rect covering the collision rect at both ends of the sweep
+  FloatRect sweptRect(collisionRect.left + std::min(deltaVec.x, 0.0f),
+		      collisionRect.top + std::min(deltaVec.y, 0.0f),
+		      collisionRect.width + fabsf(deltaVec.x),
+		      collisionRect.height + fabsf(deltaVec.y));
+
+  Vec3i firstCell, lastCell;
+  getGridCells(basePosition, sweptRect, tileChunkSize, firstCell, lastCell);
+
+  for(int32 y = firstCell.y; y <= lastCell.y; y++)
+  {
+    for(int32 x = firstCell.x; x <= lastCell.x; x++)
+    {
+      auto cell = rowGrid.find(Vec3i(x, y, firstCell.z));
+      if(cell == rowGrid.end()) continue;
+      rows.insert(rows.end(), cell->second.begin(), cell->second.end());
+    }
+  }
+
+  // Rows spanning several cells are found more than once, sorting keeps the row order
+  // so ties between rects resolve the same way a scan of all rows would
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+}
+
+void
+CollisionSnapshot::getGridCells(const EntityPosition& position, const FloatRect& collisionRect,
+				const Vec2i& tileChunkSize, Vec3i& firstCell, Vec3i& lastCell)
+{
+  float left = position.worldPosition.tileChunkPosition.x * tileChunkSize.x +
+    position.worldPosition.tilePosition.x + position.tileOffset.x + collisionRect.left;
+  float top = position.worldPosition.tileChunkPosition.y * tileChunkSize.y +
+    position.worldPosition.tilePosition.y + position.tileOffset.y + collisionRect.top;
+
+  int32 z = position.worldPosition.tileChunkPosition.z;
+  firstCell = Vec3i((int32)floorf(left), (int32)floorf(top), z);
+  lastCell = Vec3i((int32)floorf(left + collisionRect.width), (int32)floorf(top + collisionRect.height), z);
+}
+
+void
+CollisionSnapshot::addToGrid(int32 row)
+{
+  Vec3i firstCell, lastCell;
+  getGridCells(positions[row], collisionRects[row], tileChunkSize, firstCell, lastCell);
+
+  for(int32 y = firstCell.y; y <= lastCell.y; y++)
+  {
+    for(int32 x = firstCell.x; x <= lastCell.x; x++)
+    {
+      rowGrid[Vec3i(x, y, firstCell.z)].push_back(row);
+    }
+  }
+}
+
+void
+CollisionSnapshot::removeFromGrid(int32 row)
+{
+  Vec3i firstCell, lastCell;
+  getGridCells(positions[row], collisionRects[row], tileChunkSize, firstCell, lastCell);
+
+  for(int32 y = firstCell.y; y <= lastCell.y; y++)
+  {
+    for(int32 x = firstCell.x; x <= lastCell.x; x++)
+    {
+      auto cell = rowGrid.find(Vec3i(x, y, firstCell.z));
+      if(cell == rowGrid.end()) continue;
+
+      std::vector<int32>& cellRows = cell->second;
+      auto rowIt = std::find(cellRows.begin(), cellRows.end(), row);
+      if(rowIt != cellRows.end()) cellRows.erase(rowIt);
+    }
+  }
+}
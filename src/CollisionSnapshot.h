@@ -0,0 +1,64 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <jpb/Vector.h>
+#include <jpb/Rect.h>
+#include "EntityPosition.h"
+#include "Types.h"
+
+class Entity;
+
+// Tile properties under the collision center of an entity
+struct SurfaceSample {
+  float frictionValue = 2.0f;
+  float accelerationModifier = 1.0f;
+  bool isSampled = false;
+};
+
+// Copy of what collision checks and the friction lookup read, taken from layer 0 at the
+// start of every tick so sweeps iterate dense arrays instead of calling virtual functions
+// of entities spread over the heap. Entities own their state, this is only a snapshot of it
+// Cleared before dead entities are removed
+class CollisionSnapshot{
+public:
+  void clear(const Vec2i& tileChunkSize);
+
+  // Copies the entity into a new row, returns its index
+  int32 addEntity(Entity* entity);
+  int32 getRowCount() const { return (int32)entities.size(); }
+
+  // Position of a collidable row after its movement was applied, it's moved in the grid too
+  void moveRow(int32 row, const EntityPosition& position);
+  int32 getMovedRowCount() const { return movedRowCount; }
+
+  // Collidable rows whose grid cells intersect the bounds of the rect swept by deltaVec,
+  // ascending and without duplicates
+  void getSweptRows(const EntityPosition& basePosition, const FloatRect& collisionRect,
+		    const Vec2f& deltaVec, std::vector<int32>& rows) const;
+
+  // First and last cell (absolute tile) covered by the collision rect, both inclusive
+  static void getGridCells(const EntityPosition& position, const FloatRect& collisionRect,
+			   const Vec2i& tileChunkSize, Vec3i& firstCell, Vec3i& lastCell);
+
+  // Rows in the order they were added, read only while entities update
+  std::vector<Entity*> entities;
+  std::vector<EntityPosition> positions;
+  std::vector<FloatRect> collisionRects;
+  std::vector<uint8> isCollidable;
+  std::vector<uint8> hasMoved;
+
+  // Filled in by the level only for entities updated this tick
+  std::vector<SurfaceSample> surfaces;
+
+private:
+  Vec2i tileChunkSize;
+  int32 movedRowCount = 0;
+
+  // Collidable rows by every tile their collision rect touches
+  std::unordered_map<Vec3i, std::vector<int32>> rowGrid;
+
+  void addToGrid(int32 row);
+  void removeFromGrid(int32 row);
+};
@@ -23,17 +23,29 @@ Entity::die()
 
 void
 Entity::spawnDustParticles(const EntityPosition& position, int amount, float speed)
+{
+  spawnDustParticles(level, position, amount, speed);
+}
+
+void
+Entity::spawnBloodParticles(const EntityPosition& position, int amount, float speed)
+{
+  spawnBloodParticles(level, position, amount, speed);
+}
+
+void
+Entity::spawnDustParticles(ILevel* level, const EntityPosition& position, int amount, float speed)
 {
   for(int i = 0; i < amount; i++)
   {
     Entity* particle = new PrimitiveParticle(position, Vec2f::directionVector((rand()%16) * 22.5f) * speed,
 					     Vec3f(102, 102, 102), 1.0f + ((rand()%10) * 0.1f));
-    level->addEntity(EntityPtr(particle));
+    level->queueSpawn(EntityPtr(particle));
   }
 }
 
 void
-Entity::spawnBloodParticles(const EntityPosition& position, int amount, float speed)
+Entity::spawnBloodParticles(ILevel* level, const EntityPosition& position, int amount, float speed)
 {
   for(int i = 0; i < amount; i++)
   {
@@ -53,7 +65,7 @@ Entity::spawnBloodParticles(const EntityPosition& position, int amount, float sp
 
     Entity* particle = new PrimitiveParticle(position, Vec2f::directionVector((rand()%16) * 22.5f) * realSpeed,
 					     color, 1.0f + ((rand()%10) * 0.1f));
-    level->addEntity(EntityPtr(particle));
+    level->queueSpawn(EntityPtr(particle));
   }
 }
 
@@ -180,10 +192,38 @@ Moveable::getReflectedVelocity(COLLISION_PLANE collisionPlane, float speedIncrea
   return reflectedVec;
 }
 
+void
+Moveable::integrateMovement(const float lastDelta)
+{
+  SurfaceSample surfaceSample = level->getSurfaceSample(this);
+  Vec2f positionDeltaVec = getPositionDeltaVec(lastDelta, surfaceSample.frictionValue,
+					       surfaceSample.accelerationModifier);
+
+  EntityCollisionResult collisionResult = level->checkCollisions(this, positionDeltaVec);
+  handleCollisionResult(collisionResult, positionDeltaVec);
+}
+
 void
 Moveable::handleCollisionResult(EntityCollisionResult& collisionResult,
 				const Vec2f& positionDeltaVec)
 {
+  hasPendingCollisionResult = true;
+  pendingCollisionResult = collisionResult;
+  pendingPositionDeltaVec = positionDeltaVec;
+}
+
+void
+Moveable::applyDeferredUpdate()
+{
+  if(!hasPendingCollisionResult) return;
+  hasPendingCollisionResult = false;
+
+  EntityCollisionResult& collisionResult = pendingCollisionResult;
+  const Vec2f& positionDeltaVec = pendingPositionDeltaVec;
+
+  // Others might have moved into the way since it was checked
+  level->clampToMovedEntities(this, positionDeltaVec, collisionResult);
+
   if(collisionResult.maxAllowedT != 1.0f)
   {
     // Colliding With Entities
@@ -239,6 +279,15 @@ PrimitiveParticle::update(const float lastDelta)
   handleCollisionResult(collisionResult, positionDeltaVec);
 }
 
+void
+PrimitiveParticle::catchUp(const float elapsedTime)
+{
+  Moveable::catchUp(elapsedTime);
+
+  localTime += elapsedTime;
+  if(localTime > lifeTime) die();
+}
+
 void
 PrimitiveParticle::onWorldCollision(COLLISION_PLANE collisionPlane)
 {
@@ -307,7 +356,7 @@ XpOrb::update(const float lastDelta)
       FloatRect orbCollisionRect = getCollisionRect();
       if(orbCollisionRect.doesRectCollideWith(playerCollisionRect))
       {
-	player->addXp(xpAmount);
+	level->queueXp(player, xpAmount);
 	die();
       }
     }
@@ -333,72 +382,6 @@ XpOrb::getCollisionRect() const
   return FloatRect(0, 0, dimensions.x, dimensions.y );
 }
 
-Bullet::Bullet(const EntityPosition& position, const Vec2f& initialVelocity,
-	       const Vec2f& dimensions, float damageValue)
-{
-
-  this->dimensions = dimensions;
-  this->position = position;
-  velocity = initialVelocity;
-  numbOfBouncesLeft = 2;
-
-  this->damageValue = damageValue;
-
-  renderData.primitiveType = PT_CIRCLE;
-  renderData.dimensionsInTiles = dimensions;
-  renderData.color = Vec3f(rand()%256, rand()%256, rand()%256);
-  renderData.colorAlpha = 1.0f;
-}
-
-void
-Bullet::update(const float lastDelta)
-{
-
-  Vec2f positionDeltaVec = getPositionDeltaVec(lastDelta, 0.001f);
-
-  if(velocity.getLength() < 1.0f) die();
-
-  EntityCollisionResult collisionResult = level->checkCollisions(this, positionDeltaVec);
-  handleCollisionResult(collisionResult, positionDeltaVec);
-}
-
-void
-Bullet::onWorldCollision(COLLISION_PLANE collisionPlane)
-{
-  if(numbOfBouncesLeft-- == 0)
-  {
-    spawnDustParticles(getCollisionCenter(), 10, velocity.getLength() / 4.0f);
-    die();
-  }
-
-  static const float speedIncrease = 1.0f;
-  velocity = getReflectedVelocity(collisionPlane, speedIncrease);
-}
-
-FloatRect
-Bullet::getCollisionRect() const
-{
-
-  static const float bottomPart = 1.0f;
-  return FloatRect(0, dimensions.y *(1.0f - bottomPart), dimensions.x, dimensions.y * bottomPart);
-}
-
-void
-Bullet::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
-{
-  static const float speedIncrease = 1.0f;
-
-  //std::cout << "Died with the entity\n";
-
-  entity->addHealth(-damageValue);
-  entity->addVelocity(velocity * 0.5f);
-
-  velocity = getReflectedVelocity(collisionPlane, speedIncrease);
-
-  spawnBloodParticles(entity->getCollisionCenter(), 10, velocity.getLength() / 4.0f);
-  die();
-}
-
 Item::Item(const EntityPosition& position, const float value)
 {
   this->position = position;
@@ -442,11 +425,11 @@ Item::getCollisionRect() const
 
 HealthItem::HealthItem(const EntityPosition& position, const float value) : Item(position, value)
 {
-  renderData.basicSpriteName = "healthPotion";
+  renderData.basicSpriteHandle = SPRITE_HEALTH_POTION;
 }
 
 void
 HealthItem::performItemAction(Entity* actionReceiver)
 {
-  actionReceiver->addHealth(itemValue);
+  level->queueHealthChange(actionReceiver, itemValue);
 }
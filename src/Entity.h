@@ -4,8 +4,12 @@
 #include <jpb/Rect.h>
 #include "EntityPosition.h"
 #include "ILevel.h"
+#include "SpriteIds.h"
+#include "AIScheduler.h"
+#include "Behaviour.h"
 
 #include <memory>
+#include <atomic>
 
 struct PlayerInput {
   bool up;
@@ -66,11 +70,11 @@ public:
 
 class MobRenderData : public EntityRenderData {
 public:
-  MobRenderData() : EntityRenderData(ER_MOB), spriteColorAlpha(1.0f) {}
+  MobRenderData() : EntityRenderData(ER_MOB), spriteHandle(0), spriteColorAlpha(1.0f) {}
   std::string caption;
   float life;
 
-  std::string spriteName;
+  SpriteHandle spriteHandle;
   Vec3f spriteColor;
   float spriteColorAlpha;
 };
@@ -88,8 +92,8 @@ public:
 class BasicSpriteRenderData : public EntityRenderData {
 public:
 
-  BasicSpriteRenderData() : EntityRenderData(ER_BASICSPRITE) {}
-  std::string basicSpriteName;
+  BasicSpriteRenderData() : EntityRenderData(ER_BASICSPRITE), basicSpriteHandle(0) {}
+  SpriteHandle basicSpriteHandle;
   // Vec3f color;
   // float colorAlpha;
 };
@@ -105,6 +109,22 @@ public:
 
   virtual void update(const float lastDelta) = 0;
 
+  // Second phase of the level update, runs serially after every entity got updated
+  virtual void applyDeferredUpdate() {}
+
+  // Called before the first update after sleeping outside of the active chunks,
+  // timers are advanced coarsely here instead of simulating the whole time
+  virtual void catchUp(const float elapsedTime) {}
+
+  // Perception and target selection, runs right before update at the rate of its AI_TYPE
+  virtual void think(const float elapsedTime) {}
+  virtual AI_TYPE getAIType() const { return AI_NONE; }
+
+  // Behaviours sleep in the level's BehaviourScheduler and cost nothing until they're due,
+  // resumeBehaviour returns how long to sleep next, negative when it's done
+  virtual bool hasBehaviour() const { return false; }
+  virtual float resumeBehaviour() { return -1.0f; }
+
   // Position / Movement
   const EntityPosition& getPosition() const { return position; }
   void setPosition(const EntityPosition& position) { this->position = position; }
@@ -144,11 +164,33 @@ public:
   void spawnDustParticles(const EntityPosition& position, int amount, float speed);
   void spawnBloodParticles(const EntityPosition& position, int amount, float speed);
 
+  // For whatever isn't an entity, e.g. projectiles
+  static void spawnDustParticles(ILevel* level, const EntityPosition& position, int amount, float speed);
+  static void spawnBloodParticles(ILevel* level, const EntityPosition& position, int amount, float speed);
+
 protected:
   // Hold pointer to the level it's on
   ILevel* level;
   EntityPosition position;
-  bool alive = true;
+  // Read by other entities while updating in parallel
+  std::atomic<bool> alive{true};
+
+private:
+  friend class Level;
+  friend class AIScheduler;
+
+  // Time the level didn't update the entity for, because it was far from the player
+  float skippedTime = 0;
+  bool isSleeping = false;
+
+  // Removed by the level without dying, performDeathAction is skipped
+  bool isDespawned = false;
+
+  bool hasThinkPhase = false;
+  float timeSinceThink = 0;
+
+  // Row in the level's CollisionSnapshot this tick, -1 if it isn't there
+  int32 snapshotRow = -1;
 };
 typedef std::shared_ptr<Entity> EntityPtr;
 
@@ -189,6 +231,12 @@ public:
 
   float getBottomY() const { return dimensions.y; }
 
+  // Moves by the collision result stored in update and calls collision reactions
+  void applyDeferredUpdate();
+
+  // Whatever pushed it came to rest long ago
+  void catchUp(const float elapsedTime) { velocity = Vec2f(); }
+
 protected:
   Vec2f dimensions;
 
@@ -201,9 +249,18 @@ protected:
   Vec2f getPositionDeltaVec(const float lastDelta, const float fakeFrictionValue,
 				  const float accelerationModifier = 1.0f);
 
-  // Handles Collision Result calls onEntityCollision, onWorldCollision.
+  // Integrates with the friction of the surface it's on and stores the collision result
+  void integrateMovement(const float lastDelta);
+
+  // Stores Collision Result, onEntityCollision, onWorldCollision and the movement
+  // are done by applyDeferredUpdate when other entities are no longer reading this one
   void handleCollisionResult(EntityCollisionResult& collisionResult,
 			     const Vec2f& positionDeltaVec);
+
+private:
+  bool hasPendingCollisionResult = false;
+  EntityCollisionResult pendingCollisionResult;
+  Vec2f pendingPositionDeltaVec;
 };
 
 class PrimitiveParticle : public Moveable {
@@ -212,6 +269,7 @@ public:
 		    const Vec3f& color, float lifeTime);
 
   void update(const float lastDelta);
+  void catchUp(const float elapsedTime);
 
   void onWorldCollision(COLLISION_PLANE worldCollisionType);
   FloatRect getCollisionRect() const;
@@ -243,25 +301,6 @@ private:
   float localTime;
 };
 
-class Bullet : public Moveable {
-public:
-  Bullet(const EntityPosition& position, const Vec2f& initialVelocity,
-	 const Vec2f& dimensions, float damageValue);
-
-  void update(const float lastDelta);
-  void onWorldCollision(COLLISION_PLANE worldCollisionType);
-  void onEntityCollision(COLLISION_PLANE worldCollisionType, Entity* entity);
-
-  FloatRect getCollisionRect() const;
-
-  const EntityRenderData* getRenderData() { return &renderData;}
-private:
-  PrimitiveRenderData renderData;
-
-  int numbOfBouncesLeft = 0;
-  float damageValue;
-};
-
 class Item : public Entity {
 public:
   Item(const EntityPosition& position, const float value);
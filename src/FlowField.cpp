@@ -0,0 +1,124 @@
+#include "FlowField.h"
+
+// Distances of tiles that are not walkable or not reached yet
+static const int32 blockedTile = -2;
+static const int32 unreachedTile = -1;
+
+FlowField::FlowField(int32 radius) : radius(radius), size(radius * 2 + 1), isValid(false)
+{
+  distances.resize(size * size);
+  directions.resize(size * size);
+}
+
+void
+FlowField::update(const TileMap& tileMap, const WorldPosition& targetTile)
+{
+  if(isValid && this->targetTile == targetTile) return;
+
+  this->targetTile = targetTile;
+  originTile = targetTile - Vec2i(radius, radius);
+  originTile.recanonicalize(tileMap.getTileChunkSize());
+
+  compute(tileMap);
+  isValid = true;
+}
+
+void
+FlowField::compute(const TileMap& tileMap)
+{
+  for(int32 y = 0; y < size; y++)
+  {
+    for(int32 x = 0; x < size; x++)
+    {
+      WorldPosition tile = originTile + Vec2i(x, y);
+      TILE_TYPE tileType = tileMap.getTileType(tile);
+
+      bool isWalkable = tileType != TILE_TYPE_WALL && tileType != TILE_TYPE_VOID;
+      distances[y * size + x] = isWalkable ? unreachedTile : blockedTile;
+      directions[y * size + x] = Vec2f();
+    }
+  }
+
+  // Every step costs the same, so breadth first gives the same distances as Dijkstra
+  static const Vec2i neighbours[4] = { Vec2i(1, 0), Vec2i(-1, 0), Vec2i(0, 1), Vec2i(0, -1) };
+
+  static thread_local std::vector<int32> openTiles;
+  openTiles.clear();
+
+  int32 targetIndex = radius * size + radius;
+  if(distances[targetIndex] == blockedTile) return;
+
+  distances[targetIndex] = 0;
+  openTiles.push_back(targetIndex);
+
+  for(size_t i = 0; i < openTiles.size(); i++)
+  {
+    int32 index = openTiles[i];
+    int32 x = index % size;
+    int32 y = index / size;
+
+    for(int32 j = 0; j < 4; j++)
+    {
+      int32 neighbourX = x + neighbours[j].x;
+      int32 neighbourY = y + neighbours[j].y;
+      if(!isInside(neighbourX, neighbourY)) continue;
+
+      int32 neighbourIndex = neighbourY * size + neighbourX;
+      if(distances[neighbourIndex] != unreachedTile) continue;
+
+      distances[neighbourIndex] = distances[index] + 1;
+      openTiles.push_back(neighbourIndex);
+    }
+  }
+
+  // Pointing every reached tile at its closest neighbour, diagonals can't cut wall corners
+  for(auto indexIt = openTiles.begin() + 1; indexIt != openTiles.end(); indexIt++)
+  {
+    int32 index = *indexIt;
+    int32 x = index % size;
+    int32 y = index / size;
+
+    int32 bestDistance = distances[index];
+    Vec2i bestStep;
+
+    for(int32 stepY = -1; stepY <= 1; stepY++)
+    {
+      for(int32 stepX = -1; stepX <= 1; stepX++)
+      {
+	if(!isInside(x + stepX, y + stepY)) continue;
+
+	int32 neighbourDistance = distances[(y + stepY) * size + x + stepX];
+	if(neighbourDistance < 0 || neighbourDistance >= bestDistance) continue;
+
+	if(stepX != 0 && stepY != 0)
+	{
+	  if(distances[y * size + x + stepX] < 0 || distances[(y + stepY) * size + x] < 0) continue;
+	}
+
+	bestDistance = neighbourDistance;
+	bestStep = Vec2i(stepX, stepY);
+      }
+    }
+
+    Vec2f direction((float)bestStep.x, (float)bestStep.y);
+    direction.normalize();
+    directions[index] = direction;
+  }
+}
+
+FlowFieldSample
+FlowField::sample(const WorldPosition& tile, const Vec2i& tileChunkSize) const
+{
+  FlowFieldSample result = { Vec2f(), -1 };
+  if(!isValid || tile.tileChunkPosition.z != originTile.tileChunkPosition.z) return result;
+
+  Vec2i offset = WorldPosition::calculateDistanceInTilesInclusive(originTile, tile, tileChunkSize);
+  if(!isInside(offset.x, offset.y)) return result;
+
+  int32 index = offset.y * size + offset.x;
+  if(distances[index] < 0) return result;
+
+  result.direction = directions[index];
+  result.distance = distances[index];
+  return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "TileMap.h"
+#include "Types.h"
+
+// Where to go from a tile to reach the target, distance is -1 when it can't be reached
+struct FlowFieldSample {
+  Vec2f direction;
+  int32 distance;
+};
+
+// Breadth first distances over walkable tiles in a square window around the target tile,
+// every tile keeps the direction to its closest neighbour so sampling is a single lookup
+class FlowField{
+public:
+  FlowField(int32 radius = 24);
+
+  // Only recomputes when the target moved to a different tile
+  void update(const TileMap& tileMap, const WorldPosition& targetTile);
+  void reset() { isValid = false; }
+
+  FlowFieldSample sample(const WorldPosition& tile, const Vec2i& tileChunkSize) const;
+
+private:
+  int32 radius;
+  int32 size;
+
+  bool isValid;
+  WorldPosition targetTile;
+
+  // Tile at index 0 of the window
+  WorldPosition originTile;
+
+  std::vector<int32> distances;
+  std::vector<Vec2f> directions;
+
+  void compute(const TileMap& tileMap);
+  bool isInside(int32 x, int32 y) const { return x >= 0 && y >= 0 && x < size && y < size; }
+};
@@ -1,6 +1,8 @@
 #include <sstream>
+#include <assert.h>
 #include <jpb\Profiler.h>
 #include "Game.h"
+#include "JobSystem.h"
 
 void
 Game::updateGameState()
@@ -8,15 +10,21 @@ Game::updateGameState()
   GameState* newGameState = gameState->update(this);
   if(newGameState != NULL)
   {
-    gameState->leave(this);
-
-    delete gameState;
-    gameState = newGameState;
-    gameState->enter(this);
+    switchGameState(newGameState);
   }
 
 }
 
+void
+Game::switchGameState(GameState* newGameState)
+{
+  gameState->leave(this);
+
+  delete gameState;
+  gameState = newGameState;
+  gameState->enter(this);
+}
+
 void
 Game::processEvents()
 {
@@ -31,13 +39,83 @@ Game::processEvents()
 	break;
       }
     case sf::Event::KeyPressed:
-      input.handleKeyPress(event.key.code);
-      break;
+      {
+	// Keys handled by the main thread
+	if(event.key.code == sf::Keyboard::P) showProfilerData = true;
+	if(event.key.code == sf::Keyboard::F2)
+	{
+	  pipelinedMode = !pipelinedMode;
+	  std::cout << "Pipelined Mode: " << pipelinedMode << std::endl;
+	}
+
+	std::lock_guard<std::mutex> lock(inputMutex);
+	eventInput.handleKeyPress(event.key.code);
+      } break;
     case sf::Event::KeyReleased:
-      input.handleKeyRelease(event.key.code);
+      {
+	std::lock_guard<std::mutex> lock(inputMutex);
+	eventInput.handleKeyRelease(event.key.code);
+      } break;
+    }
+  }
+}
+
+void
+Game::takeInput()
+{
+  std::lock_guard<std::mutex> lock(inputMutex);
+  input = eventInput;
+
+  // Presses are kept until update sees them, even if it runs slower than the main thread
+  eventInput.clearKeyStates();
+}
+
+void
+Game::startSimulationThread()
+{
+  assert(!simulationThread.joinable());
+
+  stopSimulation = false;
+  isSimulationRunning = true;
+  simulationThread = std::thread(&Game::simulationLoop, this);
+}
+
+void
+Game::stopSimulationThread()
+{
+  if(!simulationThread.joinable()) return;
+
+  stopSimulation = true;
+  simulationThread.join();
+
+  // State can be switched only when nothing renders it
+  if(pendingGameState)
+  {
+    switchGameState(pendingGameState);
+    pendingGameState = NULL;
+  }
+}
+
+void
+Game::simulationLoop()
+{
+  // Leaves by itself when the state stops being safe to pipeline (e.g. regeneration)
+  while(!stopSimulation && gameState->canRunPipelined())
+  {
+    takeInput();
+    GameState* newGameState = gameState->update(this);
+    lastDelta = clock.restart().asSeconds();
+
+    if(newGameState != NULL)
+    {
+      pendingGameState = newGameState;
       break;
     }
+
+    std::this_thread::yield();
   }
+
+  isSimulationRunning = false;
 }
 
 void
@@ -46,12 +124,13 @@ Game::setWindowTitleToFps()
   static float cumulativeTime = 0;
   const float titleChangeTimePeriod = 1.0f;
 
-  cumulativeTime += lastDelta;
+  cumulativeTime += lastFrameDelta;
 
   if(cumulativeTime > titleChangeTimePeriod)
   {
     std::stringstream buffer;
-    buffer << "RoqueLike! Fps: " << 1.0f/lastDelta;
+    buffer << "RoqueLike! Fps: " << 1.0f/lastFrameDelta;
+    if(simulationThread.joinable()) buffer << " (Pipelined)";
     window.setTitle(buffer.str());
 
     cumulativeTime = fmodf(cumulativeTime, titleChangeTimePeriod);
@@ -76,6 +155,7 @@ Game::start()
   gameState->enter(this);
 
   Profiler::create();
+  JobSystem::create();
   while (window.isOpen())
   {
     Profiler::get()->startFrame();
@@ -83,7 +163,23 @@ Game::start()
       Profiler::get()->start("Update");
       {
 	processEvents();
-	updateGameState();
+
+	// Simulation thread finished by itself
+	if(simulationThread.joinable() && !isSimulationRunning) stopSimulationThread();
+	if(simulationThread.joinable() && (!pipelinedMode || quitRequested)) stopSimulationThread();
+
+	if(!simulationThread.joinable())
+	{
+	  if(pipelinedMode && gameState->canRunPipelined())
+	  {
+	    startSimulationThread();
+	  }
+	  else
+	  {
+	    takeInput();
+	    updateGameState();
+	  }
+	}
       }
       Profiler::get()->end("Update");
 
@@ -97,36 +193,48 @@ Game::start()
       }
       Profiler::get()->end("Render");
       // Time Handling
-      lastDelta = clock.restart().asSeconds();
+      lastFrameDelta = frameClock.restart().asSeconds();
+      if(!simulationThread.joinable()) lastDelta = clock.restart().asSeconds();
       setWindowTitleToFps();
     }
     Profiler::get()->endFrame();
 
-    if(input.isKeyPressed(sf::Keyboard::P)) Profiler::get()->showData();
-    input.clearKeyStates();
+    if(showProfilerData) Profiler::get()->showData();
+    showProfilerData = false;
+
+    if(quitRequested) window.close();
   }
+  stopSimulationThread();
   gameState->leave(this);
+
+  JobSystem::destroy();
 }
 
 void
 PlayGameState::render(Game* game)
 {
+  // Update isn't running on this thread in pipelined mode, so only snapshot can be used
+  renderSnapshots.acquire();
+  const RenderSnapshot& renderSnapshot = renderSnapshots.getReadBuffer();
+  if(!renderSnapshot.level) return;
+
   Profiler::get()->start("LevelRender");
-  levelRenderer.renderLevel(level, cameraPosition);
+  levelRenderer.renderLevel(renderSnapshot);
   Profiler::get()->end("LevelRender");
 
-  if(!levelGenerator->isGenerationFinished())
+  // Pipelined mode is never used during generation
+  if(!renderSnapshot.isGenerationFinished)
   {
-    levelGenerator->renderAdditionalData(game->window, cameraPosition, worldScale * baseTileSizeInPixels);
+    EntityPosition cameraPosition = renderSnapshot.cameraPosition;
+    levelGenerator->renderAdditionalData(game->window, cameraPosition, renderSnapshot.tileSizeInPixels);
   }
 
-  Player* player = level->getPlayer();
-  if(player)
+  if(renderSnapshot.hasPlayer)
   {
-    playerHud.render(player);
+    playerHud.render(renderSnapshot.playerHudStats);
   }
 
-  sf::Sprite tempSprite = spriteManager.getSprite("playerBase");
+  sf::Sprite tempSprite = spriteManager.getSprite(SPRITE_PLAYER_BASE);
   float tempScale = 8.0f;
   tempSprite.setScale(tempScale, tempScale);
   game->window.draw(tempSprite);
@@ -141,10 +249,9 @@ PlayGameState::enter(Game* game)
   eventManager.registerListener(level.get());
 
   levelRenderer.setWindow(&game->window);
-  levelRenderer.setTileSize(worldScale * baseTileSizeInPixels);
 
   playerHud.setWindow(&game->window);
-  playerHud.setFont(levelRenderer.getFont());
+  playerHud.setTextCache(levelRenderer.getTextCache());
 
   spriteManager.loadTexture("myTileset.png");
 
@@ -167,7 +274,19 @@ PlayGameState::enter(Game* game)
 
   spriteManager.loadSpriteSet("goblin_", IntRect(16 * 2, 16 * 13, 16, 16), 4);
 
+  // Handles are compiled in, so registration order has to match SPRITE_ID
+  assert(spriteManager.getSpriteHandle("floor1_1") == SPRITE_FLOOR1);
+  assert(spriteManager.getSpriteHandle("wallTop1_1") == SPRITE_WALLTOP1);
+  assert(spriteManager.getSpriteHandle("wall1_1") == SPRITE_WALL1);
+  assert(spriteManager.getSpriteHandle("healthPotion") == SPRITE_HEALTH_POTION);
+  assert(spriteManager.getSpriteHandle("snakeBase") == SPRITE_SNAKE_BASE);
+  assert(spriteManager.getSpriteHandle("goblin_4") == SPRITE_BUILTIN_COUNT - 1);
+
+  spriteManager.buildAtlas();
+
   levelRenderer.setSpriteManager(&spriteManager);
+
+  publishSnapshot();
 }
 
 void
@@ -222,9 +341,30 @@ PlayGameState::update(Game* game)
 
   level->removeDeadEntities();
 
+  publishSnapshot();
+
   return NULL;
 }
 
+void
+PlayGameState::publishSnapshot()
+{
+  RenderSnapshot& renderSnapshot = renderSnapshots.getWriteBuffer();
+
+  renderSnapshot.level = level;
+  renderSnapshot.cameraPosition = cameraPosition;
+  renderSnapshot.tileSizeInPixels = worldScale * baseTileSizeInPixels;
+  renderSnapshot.isGenerationFinished = levelGenerator->isGenerationFinished();
+
+  renderSnapshot.captureEntities(level.get());
+
+  Player* player = level->getPlayer();
+  renderSnapshot.hasPlayer = player != NULL;
+  if(player) renderSnapshot.playerHudStats.capture(player);
+
+  renderSnapshots.publish();
+}
+
 void
 PlayGameState::handleInput(Game* game)
 {
@@ -233,7 +373,7 @@ PlayGameState::handleInput(Game* game)
 
   if(input.isKeyPressed(sf::Keyboard::Escape) || input.isKeyPressed(sf::Keyboard::Q))
   {
-    game->window.close();
+    game->requestQuit();
   }
 
   float speed = 15.0f * (1.0f / worldScale);
@@ -248,13 +388,11 @@ PlayGameState::handleInput(Game* game)
   if(input.isKeyDown(sf::Keyboard::Add))
   {
     worldScale *= game->lastDelta + 1.0f;
-    levelRenderer.setTileSize(worldScale * baseTileSizeInPixels);
   }
 
   if(input.isKeyDown(sf::Keyboard::Subtract))
   {
     worldScale *= 1.0f - game->lastDelta;
-    levelRenderer.setTileSize(worldScale * baseTileSizeInPixels);
   }
 
   if(input.isKeyPressed(sf::Keyboard::C)) cameraBoundToPlayer = !cameraBoundToPlayer;
@@ -272,7 +410,6 @@ PlayGameState::handleInput(Game* game)
 
       level = levelGenerator->regenerate(seed);
       levelGenerator->generate();
-      levelRenderer.setTileSize(worldScale * baseTileSizeInPixels);
 
       eventManager.registerListener(level.get());
 
@@ -286,7 +423,6 @@ PlayGameState::handleInput(Game* game)
 
       if(input.isKeyDown(sf::Keyboard::LControl)) seed = 0;
       level = levelGenerator->regenerate(seed);
-      levelRenderer.setTileSize(worldScale * baseTileSizeInPixels);
 
       eventManager.registerListener(level.get());
 
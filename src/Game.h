@@ -1,5 +1,8 @@
 #pragma once
 #include <SFML/Graphics.hpp>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 #include "Input.h"
 #include "EventManager.h"
@@ -8,6 +11,8 @@
 #include "LevelRenderer.h" 
 #include "LevelGenerator.h"
 #include "SpriteManager.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
 
 class Game;
 class GameState{
@@ -15,6 +20,10 @@ class GameState{
   virtual ~GameState() {}
   virtual GameState* update(Game* game) = 0;
   virtual void render(Game* game) = 0;
+
+  // When true update is allowed to run on the simulation thread,
+  // render then has to use only data published by update
+  virtual bool canRunPipelined() { return false; }
   
   // Called When State is Entered 
   virtual void enter(Game* game) {};
@@ -26,21 +35,53 @@ class GameState{
 class Game {
   friend class PlayGameState;
  public:
+  Game() : gameState(NULL), pendingGameState(NULL), lastDelta(0), lastFrameDelta(0),
+	   pipelinedMode(false), isSimulationRunning(false), stopSimulation(false),
+	   quitRequested(false), showProfilerData(false) {}
+  
   void start();
+
+  // Window can be closed only from the main thread
+  void requestQuit() { quitRequested = true; }
   
  private:
   sf::RenderWindow window;
+  
+  // Input seen by update, eventInput collects events until update takes them
   Input input;
+  Input eventInput;
+  std::mutex inputMutex;
+  
   GameState* gameState;
-  sf::Clock clock;
+  GameState* pendingGameState;
   
-  // lastDelta In Seconds
+  // Simulation Time, lastDelta In Seconds
+  sf::Clock clock;
   float lastDelta;
 
+  // Frame Time, differs from simulation time only in pipelined mode
+  sf::Clock frameClock;
+  float lastFrameDelta;
+
+  // Pipelined Mode - Update runs on simulation thread while main thread renders
+  bool pipelinedMode;
+  std::thread simulationThread;
+  std::atomic<bool> isSimulationRunning;
+  std::atomic<bool> stopSimulation;
+  
+  std::atomic<bool> quitRequested;
+  bool showProfilerData;
+
   void setWindowTitleToFps();
 
   void processEvents();
+  void takeInput();
   void updateGameState();
+  void switchGameState(GameState* newGameState);
+
+  void startSimulationThread();
+  void stopSimulationThread();
+  void simulationLoop();
   
   void render();
 
@@ -54,6 +95,9 @@ class PlayGameState : public GameState {
   
   void enter(Game* game);
   void leave(Game* game);
+
+  // Tile map can't change under the renderer once generation is done
+  bool canRunPipelined() { return levelGenerator->isGenerationFinished(); }
   
 private:
   EventManager eventManager;
@@ -62,6 +106,9 @@ private:
   LevelGenerator* levelGenerator;
   LevelPtr level;
   PlayerHud playerHud;
+
+  // Written at the end of each update, render draws the newest one
+  TripleBuffer<RenderSnapshot> renderSnapshots;
   
   // Camera Position - It's The Center Of The Viewport
   EntityPosition cameraPosition;
@@ -71,4 +118,5 @@ private:
   double worldScale = 2.0f;
   
   void handleInput(Game* game);
+  void publishSnapshot();
 };
@@ -3,9 +3,13 @@
 #include "Event.h"
 #include "EventManager.h"
 #include "TileMap.h"
+#include "FlowField.h"
+#include "RoomGraph.h"
+#include "CollisionSnapshot.h"
 #include <memory>
 
 class Entity;
+struct Projectile;
 typedef std::shared_ptr<Entity> EntityPtr;
 typedef std::list<EntityPtr> EntityList;
 
@@ -47,14 +51,41 @@ public:
   
   virtual bool addEntity(EntityPtr& entityPtr) = 0;
   virtual void addOverlayEntity(EntityPtr& entityPtr) = 0;
+
+  // Recorded while the level updates and applied together once it's done,
+  // outside of the update they take effect right away
+  virtual void queueSpawn(const EntityPtr& entityPtr) = 0;
+  virtual void queueHealthChange(Entity* entity, float amount) = 0;
+  virtual void queueImpulse(Entity* entity, const Vec2f& velocity) = 0;
+  virtual void queueXp(Entity* entity, float amount) = 0;
+  virtual void queueKill(Entity* entity) = 0;
+
+  // Projectiles aren't entities, false when it would start inside of a wall or an entity
+  // While the level updates it's checked once the commands are applied and true is returned
+  virtual bool spawnProjectile(const Projectile& projectile) = 0;
+
   virtual Player* getPlayer() const = 0;
   
   virtual void removeDeadEntities() = 0;
   virtual EntityCollisionResult checkCollisions(const Entity* entity, Vec2f deltaVec) const  = 0;
+
+  // Movers are checked in parallel against where the others started the tick, before the
+  // result is applied it's clamped against the ones that already moved
+  virtual void clampToMovedEntities(const Entity* entity, const Vec2f& deltaVec,
+				    EntityCollisionResult& collisionResult) const = 0;
   
   virtual bool canSeeEachOther(const Entity* entity1, const Entity* entity2, float maxRange) const = 0;
   virtual Vec2f canSeeEachOtherCardinal(const Entity* entity1, const Entity* entity2, float maxRange) const = 0; 
   
+  // Shortest walkable way towards the player, shared by every mob that chases him
+  virtual FlowFieldSample samplePlayerFlowField(const EntityPosition& entityPosition) const = 0;
+
+  // Long range path between rooms, false when either end is outside of the rooms
+  virtual bool findPath(const EntityPosition& start, const EntityPosition& goal, TilePath& path) const = 0;
+
+  // Sampled once per tick for entities that move, falls back to a lookup for the rest
+  virtual SurfaceSample getSurfaceSample(const Entity* entity) const = 0;
+
   virtual float getFrictionValueAtPosition(EntityPosition& entityPosition) const = 0; 
   virtual float getAccelerationModifierAtPosition(EntityPosition& entityPosition) const = 0;
 };
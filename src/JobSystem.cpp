@@ -0,0 +1,151 @@
+#include "JobSystem.h"
+
+#include <assert.h>
+
+// Queue index of the worker running on this thread, -1 for other threads
+static thread_local int32 currentWorkerIndex = -1;
+
+JobSystem::JobSystem() : queuedBatchCount(0), isStopping(false)
+{
+  // Calling thread works too, so one core is left for it
+  int32 workerCount = (int32)std::thread::hardware_concurrency() - 1;
+  if(workerCount < 1) workerCount = 1;
+
+  for(int32 i = 0; i < workerCount + 1; i++)
+  {
+    workQueues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue));
+  }
+
+  for(int32 i = 0; i < workerCount; i++)
+  {
+    workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+  }
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    isStopping = true;
+  }
+  wakeCondition.notify_all();
+
+  for(auto i = workers.begin(); i != workers.end(); i++)
+  {
+    i->join();
+  }
+}
+
+void
+JobSystem::parallelFor(int32 count, int32 batchSize, const RangeJob& rangeJob)
+{
+  assert(batchSize > 0);
+  if(count <= 0) return;
+
+  // Not worth waking anybody up
+  if(count <= batchSize)
+  {
+    rangeJob(0, count);
+    return;
+  }
+
+  std::atomic<int32> pendingBatchCount((count + batchSize - 1) / batchSize);
+
+  int32 queueCount = (int32)workQueues.size();
+  int32 ownQueueIndex = getQueueIndex();
+
+  // Dealt round robin so every thread starts with its own share and only steals the rest
+  int32 batchIndex = 0;
+  for(int32 begin = 0; begin < count; begin += batchSize, batchIndex++)
+  {
+    JobBatch jobBatch;
+    jobBatch.rangeJob = &rangeJob;
+    jobBatch.begin = begin;
+    jobBatch.end = begin + batchSize < count ? begin + batchSize : count;
+    jobBatch.pendingBatchCount = &pendingBatchCount;
+
+    WorkQueue& workQueue = *workQueues[(ownQueueIndex + batchIndex) % queueCount];
+    std::lock_guard<std::mutex> lock(workQueue.mutex);
+    workQueue.batches.push_back(jobBatch);
+    queuedBatchCount.fetch_add(1);
+  }
+
+  // Taking the lock so a worker can't miss the wake up between its check and wait
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  wakeCondition.notify_all();
+
+  // Helping out instead of sleeping
+  while(pendingBatchCount.load() > 0)
+  {
+    if(!runQueuedBatch(ownQueueIndex)) std::this_thread::yield();
+  }
+}
+
+int32
+JobSystem::getQueueIndex() const
+{
+  return currentWorkerIndex >= 0 ? currentWorkerIndex : (int32)workers.size();
+}
+
+bool
+JobSystem::popBatch(int32 queueIndex, bool isOwner, JobBatch& jobBatch)
+{
+  WorkQueue& workQueue = *workQueues[queueIndex];
+  std::lock_guard<std::mutex> lock(workQueue.mutex);
+  if(workQueue.batches.empty()) return false;
+
+  // Owner works from the back, thieves take from the front
+  if(isOwner)
+  {
+    jobBatch = workQueue.batches.back();
+    workQueue.batches.pop_back();
+  }
+  else
+  {
+    jobBatch = workQueue.batches.front();
+    workQueue.batches.pop_front();
+  }
+  queuedBatchCount.fetch_sub(1);
+
+  return true;
+}
+
+bool
+JobSystem::runQueuedBatch(int32 queueIndex)
+{
+  if(queuedBatchCount.load() == 0) return false;
+
+  JobBatch jobBatch;
+  bool foundBatch = popBatch(queueIndex, true, jobBatch);
+
+  // Starting with the next queue so thieves spread out
+  int32 queueCount = (int32)workQueues.size();
+  for(int32 i = 1; !foundBatch && i < queueCount; i++)
+  {
+    foundBatch = popBatch((queueIndex + i) % queueCount, false, jobBatch);
+  }
+  if(!foundBatch) return false;
+
+  (*jobBatch.rangeJob)(jobBatch.begin, jobBatch.end);
+  jobBatch.pendingBatchCount->fetch_sub(1);
+
+  return true;
+}
+
+void
+JobSystem::workerLoop(int32 workerIndex)
+{
+  currentWorkerIndex = workerIndex;
+
+  while(true)
+  {
+    if(runQueuedBatch(workerIndex)) continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wakeCondition.wait(lock, [this]() { return isStopping || queuedBatchCount.load() > 0; });
+
+    if(isStopping && queuedBatchCount.load() == 0) return;
+  }
+}
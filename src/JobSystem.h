@@ -0,0 +1,61 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <memory>
+
+#include <jpb\Profiler.h>
+#include "Types.h"
+
+// Processes elements from begin up to end (exclusive)
+typedef std::function<void(int32 begin, int32 end)> RangeJob;
+
+// Worker threads for splitting frame work into batches, every thread owns a queue
+// and steals from the others once it runs dry,
+// the thread that submits the work helps until all of it is done
+class JobSystem : public Singleton<JobSystem> {
+public:
+  JobSystem();
+  ~JobSystem();
+
+  // Splits [0, count) into batches of batchSize and blocks until all of them are done
+  void parallelFor(int32 count, int32 batchSize, const RangeJob& rangeJob);
+
+  int32 getWorkerCount() const { return (int32)workers.size(); }
+
+private:
+  struct JobBatch {
+    const RangeJob* rangeJob;
+    int32 begin;
+    int32 end;
+    std::atomic<int32>* pendingBatchCount;
+  };
+
+  struct WorkQueue {
+    std::deque<JobBatch> batches;
+    std::mutex mutex;
+  };
+
+  std::vector<std::thread> workers;
+
+  // One per worker, the last one is shared by threads that are not workers
+  std::vector<std::unique_ptr<WorkQueue>> workQueues;
+  std::atomic<int32> queuedBatchCount;
+
+  std::mutex sleepMutex;
+  std::condition_variable wakeCondition;
+  bool isStopping;
+
+  // Index of the calling thread's own queue
+  int32 getQueueIndex() const;
+
+  // Runs a batch from the own queue or steals one, returns false if there wasn't any
+  bool runQueuedBatch(int32 queueIndex);
+  bool popBatch(int32 queueIndex, bool isOwner, JobBatch& jobBatch);
+  void workerLoop(int32 workerIndex);
+};
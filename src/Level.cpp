@@ -2,19 +2,68 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstdlib>
+
+#include "SweptCollision.h"
+#include "JobSystem.h"
+
+// Commands of the entity being updated on this thread, NULL outside of the parallel update
+static thread_local LevelCommandBuffer* currentEntityCommands = NULL;
+
+static float
+getTileFrictionValue(TILE_TYPE tileType)
+{
+  switch(tileType)
+  {
+  case TILE_TYPE_STONE_ICE_GROUND:
+    return 0.1f;
+  }
+  return 2.0f;
+}
+
+static float
+getTileAccelerationModifier(TILE_TYPE tileType)
+{
+  switch(tileType)
+  {
+  case TILE_TYPE_STONE_SPEED_GROUND:
+    return 2.0f;
+  }
+  return 1.0f;
+}
 
 Level::Level()
 {
   player = NULL;
+  isRecordingCommands = false;
+  tickIndex = 0;
+  populateRadius = defaultPopulateRadius;
+  releaseRadius = defaultReleaseRadius;
   tileMap = TileMapPtr(new TileMap(Vec2i(16, 16)));
+  roomGraph = RoomGraphPtr(new RoomGraph(tileMap->getTileChunkSize()));
   std::cout << "Level Created !\n";
 }
 
 void
 Level::update(const float lastDelta)
 {
+  // Collision reads merged wall rects, so they have to reflect tile changes first
+  tileMap->updateWallRects();
+
+  // Mobs sample it while updating, so it's refreshed before they run
+  if(player)
+  {
+    EntityPosition playerCenter = player->getCollisionCenter();
+    playerCenter.recanonicalize(tileMap->getTileChunkSize());
+    playerFlowField.update(*tileMap, playerCenter.worldPosition);
+  }
+  else playerFlowField.reset();
+
+  isRecordingCommands = true;
+  updateRoomPopulations();
   killCollidingEntities();
   updateEntities(lastDelta);
+  applyCommands();
 }
 
 void
@@ -25,6 +74,8 @@ Level::registerPendingEntities(EventManager& eventManager)
     EntityPtr entityPtr= *entityIt;
     eventManager.registerListener(entityPtr.get());
     entityList[0].push_back(entityPtr);
+
+    if(entityPtr->hasBehaviour()) behaviourScheduler.schedule(entityPtr, 0);
   }
 
   pendingEntityList.clear();
@@ -33,19 +84,261 @@ Level::registerPendingEntities(EventManager& eventManager)
 void
 Level::updateEntities(const float lastDelta)
 {
+  updatedEntities.clear();
+  updateDeltas.clear();
+  collisionSnapshot.clear(tileMap->getTileChunkSize());
+  movingRows.clear();
+  tickIndex++;
+
+  Vec3i playerChunk;
+  if(player)
+  {
+    EntityPosition playerCenter = player->getCollisionCenter();
+    playerCenter.recanonicalize(tileMap->getTileChunkSize());
+    playerChunk = playerCenter.worldPosition.tileChunkPosition;
+  }
 
+  int32 reducedEntityIndex = 0;
   for(int entityLayer = 0; entityLayer < numbOfEntityLayers; entityLayer++)
   {
     for(auto entityPtr = entityList[entityLayer].begin(); entityPtr != entityList[entityLayer].end(); entityPtr++)
     {
-      (*entityPtr)->update(lastDelta);
+      Entity* entity = (*entityPtr).get();
+
+      // Frozen entities are still in the way of the others
+      int32 snapshotRow = -1;
+      if(entityLayer == 0) snapshotRow = collisionSnapshot.addEntity(entity);
+      entity->snapshotRow = snapshotRow;
+
+      // Overlay entities are only ever spawned around the player
+      ACTIVITY_TIER activityTier = AT_ACTIVE;
+      if(player && entityLayer == 0) activityTier = getActivityTier(entity, playerChunk);
+
+      if(activityTier == AT_FROZEN)
+      {
+	entity->skippedTime += lastDelta;
+	entity->isSleeping = true;
+	continue;
+      }
+
+      // Woken up because the player came close
+      if(entity->isSleeping)
+      {
+	entity->catchUp(entity->skippedTime);
+	entity->skippedTime = 0;
+	entity->isSleeping = false;
+      }
+
+      if(activityTier == AT_REDUCED && (tickIndex + reducedEntityIndex++) % reducedUpdatePeriod != 0)
+      {
+	entity->skippedTime += lastDelta;
+	continue;
+      }
+
+      updatedEntities.push_back(entity);
+      updateDeltas.push_back(lastDelta + entity->skippedTime);
+      entity->skippedTime = 0;
+
+      if(snapshotRow >= 0 && collisionSnapshot.isCollidable[snapshotRow]) movingRows.push_back(snapshotRow);
     }
   }
+
+  sampleSurfaces();
+
+  // Only behaviours whose sleep elapsed run, serially since there are few of them
+  behaviourScheduler.advance(lastDelta, dueBehaviourEntities);
+  for(auto entityPtr = dueBehaviourEntities.begin(); entityPtr != dueBehaviourEntities.end(); entityPtr++)
+  {
+    Entity* entity = (*entityPtr).get();
+
+    float sleepTime = entity->isSleeping ? frozenBehaviourDelay : entity->resumeBehaviour();
+    if(sleepTime >= 0) behaviourScheduler.schedule(*entityPtr, sleepTime);
+  }
+  dueBehaviourEntities.clear();
+
+  int32 entityCount = (int32)updatedEntities.size();
+  if((int32)entityCommands.size() < entityCount) entityCommands.resize(entityCount);
+
+  aiScheduler.schedule(updatedEntities, updateDeltas, thinkTimes);
+
+  // Entities only read each other here, anything they change outside of themselves is recorded
+  JobSystem::get()->parallelFor(entityCount, 32,
+				[this](int32 begin, int32 end)
+				{
+				  for(int32 i = begin; i < end; i++)
+				  {
+				    currentEntityCommands = &entityCommands[i];
+				    if(thinkTimes[i] >= 0) updatedEntities[i]->think(thinkTimes[i]);
+				    updatedEntities[i]->update(updateDeltas[i]);
+				  }
+				  currentEntityCommands = NULL;
+				});
+
+  projectileManager.sweep(*this, lastDelta);
+
+  // Collision reactions run here in entity order and record into the level commands
+  for(int32 i = 0; i < entityCount; i++)
+  {
+    Entity* entity = updatedEntities[i];
+    entity->applyDeferredUpdate();
+
+    // Movers after this one are clamped against where it ended up
+    int32 snapshotRow = entity->snapshotRow;
+    if(snapshotRow >= 0 && collisionSnapshot.isCollidable[snapshotRow])
+    {
+      collisionSnapshot.moveRow(snapshotRow, entity->getPosition());
+    }
+  }
+
+  projectileManager.resolve(this);
+}
+
+void
+Level::addRoomSpawn(int32 roomIndex, const SpawnDescriptor& spawnDescriptor)
+{
+  if((int32)roomPopulations.size() <= roomIndex)
+  {
+    RoomPopulation emptyRoom;
+    emptyRoom.isPopulated = false;
+    roomPopulations.resize(roomIndex + 1, emptyRoom);
+  }
+
+  roomPopulations[roomIndex].spawnDescriptors.push_back(spawnDescriptor);
+}
+
+void
+Level::setRoomPopulationRadius(float populateRadius, float releaseRadius)
+{
+  assert(populateRadius < releaseRadius);
+  this->populateRadius = populateRadius;
+  this->releaseRadius = releaseRadius;
+}
+
+void
+Level::updateRoomPopulations()
+{
+  if(!player) return;
+
+  EntityPosition playerCenter = player->getCollisionCenter();
+  playerCenter.recanonicalize(tileMap->getTileChunkSize());
+
+  for(int32 roomIndex = 0; roomIndex < (int32)roomPopulations.size(); roomIndex++)
+  {
+    RoomPopulation& roomPopulation = roomPopulations[roomIndex];
+    if(roomPopulation.spawnDescriptors.empty()) continue;
+
+    float distance = roomGraph->getDistanceToRoom(playerCenter.worldPosition, roomIndex);
+
+    // Radii differ so walking along the border doesn't keep spawning and releasing
+    if(!roomPopulation.isPopulated && distance <= populateRadius) populateRoom(roomPopulation);
+    else if(roomPopulation.isPopulated && distance > releaseRadius) releaseRoom(roomPopulation);
+  }
+}
+
+static EntityPtr
+createSpawnedEntity(const SpawnDescriptor& spawnDescriptor)
+{
+  Entity* entity = NULL;
+  const EntityPosition& position = spawnDescriptor.position;
+
+  switch(spawnDescriptor.type)
+  {
+  case SE_RAT:
+    entity = new Rat(position, spawnDescriptor.mobLevel, spawnDescriptor.direction, spawnDescriptor.time);
+    break;
+  case SE_SNAKE:
+    entity = new Snake(position, spawnDescriptor.mobLevel, spawnDescriptor.direction);
+    break;
+  case SE_FOLLOWER:
+    entity = new Follower(position, spawnDescriptor.mobLevel);
+    break;
+  case SE_CANNON:
+    entity = new Cannon(position, spawnDescriptor.mobLevel);
+    break;
+  case SE_RAT_SPAWNER:
+    entity = new MobSpawner(position, spawnDescriptor.mobLevel, MT_RAT, spawnDescriptor.time);
+    break;
+  case SE_HEALTH_ITEM:
+    entity = new HealthItem(position, spawnDescriptor.value);
+    break;
+  case SE_NONE:
+    assert(false);
+    break;
+  }
+
+  return EntityPtr(entity);
+}
+
+void
+Level::populateRoom(RoomPopulation& roomPopulation)
+{
+  // Checked against the level in bulk with the rest of this tick's spawns
+  for(auto spawnDescriptor = roomPopulation.spawnDescriptors.begin();
+      spawnDescriptor != roomPopulation.spawnDescriptors.end(); spawnDescriptor++)
+  {
+    EntityPtr entityPtr = createSpawnedEntity(*spawnDescriptor);
+    roomPopulation.spawnedEntities.push_back(entityPtr);
+    queueSpawn(entityPtr);
+  }
+
+  roomPopulation.isPopulated = true;
+}
+
+void
+Level::releaseRoom(RoomPopulation& roomPopulation)
+{
+  // Killed entities stay dead, the rest is kept where it was left
+  // Spawns that were dropped for colliding are tried again next time
+  std::vector<SpawnDescriptor> remainingDescriptors;
+  for(size_t i = 0; i < roomPopulation.spawnedEntities.size(); i++)
+  {
+    Entity* entity = roomPopulation.spawnedEntities[i].get();
+    if(!entity->isAlive() && !entity->isDespawned) continue;
+
+    SpawnDescriptor spawnDescriptor = roomPopulation.spawnDescriptors[i];
+    spawnDescriptor.position = entity->getPosition();
+    remainingDescriptors.push_back(spawnDescriptor);
+
+    if(entity->isAlive()) despawnEntity(entity);
+  }
+
+  roomPopulation.spawnDescriptors.swap(remainingDescriptors);
+  roomPopulation.spawnedEntities.clear();
+  roomPopulation.isPopulated = false;
+}
+
+void
+Level::despawnEntity(Entity* entity)
+{
+  entity->isDespawned = true;
+  entity->die();
+}
+
+ACTIVITY_TIER
+Level::getActivityTier(const Entity* entity, const Vec3i& playerChunk) const
+{
+  EntityPosition position = entity->getPosition();
+  position.recanonicalize(tileMap->getTileChunkSize());
+  const Vec3i& chunk = position.worldPosition.tileChunkPosition;
+
+  if(chunk.z != playerChunk.z) return AT_FROZEN;
+
+  int32 chunkDistance = std::max(abs(chunk.x - playerChunk.x), abs(chunk.y - playerChunk.y));
+  if(chunkDistance <= activeChunkRadius) return AT_ACTIVE;
+  if(chunkDistance <= reducedChunkRadius) return AT_REDUCED;
+  return AT_FROZEN;
 }
 
 void
 Level::removeDeadEntities()
 {
+  // Rows point at entities that are about to be freed, they're gathered again next update
+  collisionSnapshot.clear(tileMap->getTileChunkSize());
+  movingRows.clear();
+
+  // Xp dropped by dead mobs is spawned in one pass
+  isRecordingCommands = true;
+
   for(int entityLayer = 0; entityLayer < numbOfEntityLayers; entityLayer++)
   {
     auto entityPtrIt = entityList[entityLayer].begin();
@@ -54,7 +347,7 @@ Level::removeDeadEntities()
     {
       if(!(*entityPtrIt)->isAlive())
       {
-	(*entityPtrIt)->performDeathAction();
+	if(!(*entityPtrIt)->isDespawned) (*entityPtrIt)->performDeathAction();
 
 	if((*entityPtrIt)->isPlayer()) player = NULL;
 	entityPtrIt = entityList[entityLayer].erase(entityPtrIt);
@@ -65,29 +358,41 @@ Level::removeDeadEntities()
       }
     }
   }
+
+  applyCommands();
 }
 
 EntityCollisionResult
 Level::checkCollisions(const Entity* entity, Vec2f deltaVec) const
+{
+  // If There's no velocity collision couldn't occur - That Eliminates non Moving Entities
+  if(deltaVec == Vec2f())
+  {
+    return EntityCollisionResult();
+  }
+
+  CollisionCheckData collisionCheckData = {entity->getPosition(), entity->getCollisionRect(), deltaVec};
+  return checkCollisions(collisionCheckData, entity, entity->canCollideWithEntities());
+}
+
+EntityCollisionResult
+Level::checkCollisions(const CollisionCheckData& collisionCheckData, const Entity* entity,
+		       bool canCollideWithEntities) const
 {
   // EntityCollision Is initalized by default with values indicating no collision
   EntityCollisionResult collisionCheckResult;
 
-  // If There's no velocity collision couldn't occur - That Eliminates non Moving Entities
+  const Vec2f& deltaVec = collisionCheckData.deltaVec;
   if(deltaVec == Vec2f())
   {
     return collisionCheckResult;
   }
 
-  EntityPosition entityPosition = entity->getPosition();
-  FloatRect collisionRect = entity->getCollisionRect();
-
-  CollisionCheckData collisionCheckData = {entityPosition, collisionRect, deltaVec};
   WorldCollisionResult worldCollisionResult = checkWorldCollision(collisionCheckData);
 
   EntityCollisionResult entityCollisionResult;
 
-  if(entity->canCollideWithEntities())
+  if(canCollideWithEntities)
   {
     entityCollisionResult = checkEntityCollision(entity, collisionCheckData);
   }
@@ -133,6 +438,24 @@ Level::checkCollisions(const Entity* entity, Vec2f deltaVec) const
   return collisionCheckResult;
 }
 
+void
+Level::clampToMovedEntities(const Entity* entity, const Vec2f& deltaVec,
+			    EntityCollisionResult& collisionResult) const
+{
+  if(collisionSnapshot.getMovedRowCount() == 0 || deltaVec == Vec2f() || !entity->canCollideWithEntities()) return;
+
+  CollisionCheckData collisionCheckData = {entity->getPosition(), entity->getCollisionRect(), deltaVec};
+  EntityCollisionResult movedCollisionResult = checkEntityCollision(entity, collisionCheckData, true);
+  if(movedCollisionResult.maxAllowedT == 1.0f) return;
+
+  // Same precision as checkCollisions keeps for entities
+  float decreaseValue = 0.1f / deltaVec.getLength();
+  if(decreaseValue < 1.0f) movedCollisionResult.maxAllowedT -= decreaseValue;
+  else movedCollisionResult.maxAllowedT = 0;
+
+  if(movedCollisionResult.maxAllowedT < collisionResult.maxAllowedT) collisionResult = movedCollisionResult;
+}
+
 bool
 Level::canSeeEachOther(const Entity* entity1, const Entity* entity2, float maxRange) const
 {
@@ -262,42 +585,88 @@ Level::canSeeEachOtherCardinal(const Entity* entity1, const Entity* entity2, flo
   return Vec2f();
 }
 
-float
-Level::getFrictionValueAtPosition(EntityPosition& entityPosition) const
+FlowFieldSample
+Level::samplePlayerFlowField(const EntityPosition& entityPosition) const
 {
-  float frictionValue = 2.0;
+  EntityPosition samplePosition = entityPosition;
+  samplePosition.recanonicalize(tileMap->getTileChunkSize());
+  return playerFlowField.sample(samplePosition.worldPosition, tileMap->getTileChunkSize());
+}
 
-  tileMap->recanonicalize(entityPosition);
-  TILE_TYPE tileType = tileMap->getTileType(entityPosition.worldPosition);
+bool
+Level::findPath(const EntityPosition& start, const EntityPosition& goal, TilePath& path) const
+{
+  EntityPosition startPosition = start;
+  EntityPosition goalPosition = goal;
+  startPosition.recanonicalize(tileMap->getTileChunkSize());
+  goalPosition.recanonicalize(tileMap->getTileChunkSize());
 
-  switch(tileType)
+  return roomGraph->findPath(*tileMap, startPosition.worldPosition, goalPosition.worldPosition, path);
+}
+
+SurfaceSample
+Level::getSurfaceSample(const Entity* entity) const
+{
+  int32 row = entity->snapshotRow;
+  if(row >= 0 && row < collisionSnapshot.getRowCount() && collisionSnapshot.entities[row] == entity &&
+     collisionSnapshot.surfaces[row].isSampled)
   {
-  case TILE_TYPE_STONE_ICE_GROUND:
-    frictionValue = 0.1f;
-    break;
+    return collisionSnapshot.surfaces[row];
   }
-  return frictionValue;
+
+  EntityPosition collisionCenter = entity->getCollisionCenter();
+  tileMap->recanonicalize(collisionCenter);
+  TILE_TYPE tileType = tileMap->getTileType(collisionCenter.worldPosition);
+
+  SurfaceSample surfaceSample;
+  surfaceSample.frictionValue = getTileFrictionValue(tileType);
+  surfaceSample.accelerationModifier = getTileAccelerationModifier(tileType);
+  surfaceSample.isSampled = true;
+  return surfaceSample;
 }
 
-float
-Level::getAccelerationModifierAtPosition(EntityPosition& entityPosition) const
+void
+Level::sampleSurfaces()
 {
-  float accelerationModifier = 1.0;
+  JobSystem::get()->parallelFor((int32)movingRows.size(), 64,
+				[this](int32 begin, int32 end)
+				{
+				  for(int32 i = begin; i < end; i++)
+				  {
+				    int32 row = movingRows[i];
+				    const FloatRect& collisionRect = collisionSnapshot.collisionRects[row];
+
+				    // Same as Moveable::getCollisionCenter
+				    EntityPosition collisionCenter = collisionSnapshot.positions[row];
+				    collisionCenter += Vec2f(collisionRect.left + collisionRect.width / 2.0f,
+							     collisionRect.top + collisionRect.height / 2.0f);
+				    tileMap->recanonicalize(collisionCenter);
+				    TILE_TYPE tileType = tileMap->getTileType(collisionCenter.worldPosition);
+
+				    SurfaceSample& surfaceSample = collisionSnapshot.surfaces[row];
+				    surfaceSample.frictionValue = getTileFrictionValue(tileType);
+				    surfaceSample.accelerationModifier = getTileAccelerationModifier(tileType);
+				    surfaceSample.isSampled = true;
+				  }
+				});
+}
 
+float
+Level::getFrictionValueAtPosition(EntityPosition& entityPosition) const
+{
   tileMap->recanonicalize(entityPosition);
-  TILE_TYPE tileType = tileMap->getTileType(entityPosition.worldPosition);
+  return getTileFrictionValue(tileMap->getTileType(entityPosition.worldPosition));
+}
 
-  switch(tileType)
-  {
-  case TILE_TYPE_STONE_SPEED_GROUND:
-    accelerationModifier = 2.0f;
-    break;
-  }
-  return accelerationModifier;
+float
+Level::getAccelerationModifierAtPosition(EntityPosition& entityPosition) const
+{
+  tileMap->recanonicalize(entityPosition);
+  return getTileAccelerationModifier(tileMap->getTileType(entityPosition.worldPosition));
 }
 
 int
-Level::getSurroundingTileData(const WorldPosition& worldPosition, TILE_TYPE tileType)
+Level::getSurroundingTileData(const WorldPosition& worldPosition, TILE_TYPE tileType) const
 {
   int result = 0;
 
@@ -321,11 +690,9 @@ Level::getSurroundingTileData(const WorldPosition& worldPosition, TILE_TYPE tile
   return result;
 }
 
-TileList
-Level::getAffectedTiles(const CollisionCheckData& collisionCheckData) const
+IntRect
+Level::getAffectedTileBounds(const CollisionCheckData& collisionCheckData, WorldPosition& originTile) const
 {
-  TileList affectedTiles;
-
   const Vec2i& tileChunkSize = tileMap->getTileChunkSize();
 
   EntityPosition cornerPosition = collisionCheckData.basePosition + collisionCheckData.collisionRect[0];
@@ -353,12 +720,24 @@ Level::getAffectedTiles(const CollisionCheckData& collisionCheckData) const
   int minX = std::min((float)tileDeltaVec.x, 0.0f);
   int maxX = std::max((float)tileDeltaVec.x, 0.0f);
 
-  for(int y = minY; y <= maxY; y++)
+  originTile = cornerPosition.worldPosition;
+  return IntRect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+}
+
+TileList
+Level::getAffectedTiles(const CollisionCheckData& collisionCheckData) const
+{
+  TileList affectedTiles;
+
+  WorldPosition originTile;
+  IntRect tileBounds = getAffectedTileBounds(collisionCheckData, originTile);
+
+  for(int y = tileBounds.top; y < tileBounds.top + tileBounds.height; y++)
   {
 
-    for(int x = minX; x <= maxX; x++)
+    for(int x = tileBounds.left; x < tileBounds.left + tileBounds.width; x++)
     {
-      affectedTiles.push_back(cornerPosition.worldPosition + Vec2i(x, y));
+      affectedTiles.push_back(originTile + Vec2i(x, y));
     }
 
   }
@@ -367,53 +746,79 @@ Level::getAffectedTiles(const CollisionCheckData& collisionCheckData) const
 }
 
 WorldCollisionResult
-Level::checkCollisionsWithTiles(TileList& tiles,
-				const CollisionCheckData& collisionCheckData) const
+Level::checkCollisionsWithWallRects(const WorldPosition& originTile, const IntRect& tileBounds,
+				    const CollisionCheckData& collisionCheckData) const
 {
 
   WorldCollisionResult collisionResult;
 
-  // Checking Each Tile
-  for(auto tileIt = tiles.begin(); tileIt != tiles.end(); tileIt++)
-  {
-
-    // Only Collide With Wall Tiles
-    if(tileMap->getTileType(*tileIt) == TILE_TYPE_WALL)
-    {
+  const Vec2i& tileChunkSize = tileMap->getTileChunkSize();
+  const TileChunkMap& tileChunkMap = tileMap->getTileChunkMap();
 
-      // Distance Of The Tile From The Position
-      Vec2f localTilePosition = EntityPosition::calculateDistanceInTiles(collisionCheckData.basePosition,
-									 EntityPosition(*tileIt),
-									 tileMap->getTileChunkSize());
+  // Preparing Objects for Minkowsy's Collision Checking
+  float halfWidth = collisionCheckData.collisionRect.width / 2.0f;
+  float halfHeight = collisionCheckData.collisionRect.height / 2.0f;
 
-      // Preparing Objects for Minkowsy's Collision Checking
-      float halfWidth = collisionCheckData.collisionRect.width / 2.0f;
-      float halfHeight = collisionCheckData.collisionRect.height / 2.0f;
+  static thread_local SweptRectBatch wallRects;
+  wallRects.clear();
 
-      FloatRect localTileRect(localTilePosition.x - halfWidth, localTilePosition.y - halfHeight,
-			      1.0f + collisionCheckData.collisionRect.width,
-			      1.0f + collisionCheckData.collisionRect.height);
+  // Chunks overlapped by the affected tiles
+  WorldPosition firstTile = originTile + Vec2i(tileBounds.left, tileBounds.top);
+  WorldPosition lastTile = originTile + Vec2i(tileBounds.left + tileBounds.width - 1,
+					      tileBounds.top + tileBounds.height - 1);
+  firstTile.recanonicalize(tileChunkSize);
+  lastTile.recanonicalize(tileChunkSize);
 
-      // Positioning Player Point In The Center of Previous Collision Rect
-      Vec2f playerPoint = collisionCheckData.collisionRect[0] + Vec2f(halfWidth, halfHeight);
+  for(int chunkY = firstTile.tileChunkPosition.y; chunkY <= lastTile.tileChunkPosition.y; chunkY++)
+  {
+    for(int chunkX = firstTile.tileChunkPosition.x; chunkX <= lastTile.tileChunkPosition.x; chunkX++)
+    {
+      Vec3i tileChunkPosition(chunkX, chunkY, firstTile.tileChunkPosition.z);
+      auto tileChunkIt = tileChunkMap.find(tileChunkPosition);
+      if(tileChunkIt == tileChunkMap.end()) continue;
 
-      // Checking Each of 4 walls and Getting The One That Collides First
-      for(int wallIndex=0; wallIndex < 4; wallIndex++)
+      const TileRectList& chunkWallRects = tileChunkIt->second->getWallRects();
+      for(auto wallRectIt = chunkWallRects.begin(); wallRectIt != chunkWallRects.end(); wallRectIt++)
       {
-	float tempT = localTileRect.getMaxTime(playerPoint, collisionCheckData.deltaVec, wallIndex);
+	// Merged rect relative to the origin tile, clipped to the affected tiles
+	// so walls far behind the movement are not hit with negative time
+	WorldPosition rectPosition(tileChunkPosition, Vec2i(wallRectIt->left, wallRectIt->top));
+	Vec2i rectOffset = WorldPosition::calculateDistanceInTilesInclusive(originTile, rectPosition, tileChunkSize);
+
+	int32 left = std::max(rectOffset.x, tileBounds.left);
+	int32 top = std::max(rectOffset.y, tileBounds.top);
+	int32 right = std::min(rectOffset.x + wallRectIt->width, tileBounds.left + tileBounds.width);
+	int32 bottom = std::min(rectOffset.y + wallRectIt->height, tileBounds.top + tileBounds.height);
+	if(left >= right || top >= bottom) continue;
+
+	// Distance Of The Rect From The Position
+	WorldPosition clippedTile = originTile + Vec2i(left, top);
+	EntityPosition clippedPosition(clippedTile);
+	Vec2f localRectPosition = EntityPosition::calculateDistanceInTiles(collisionCheckData.basePosition,
+									  clippedPosition,
+									  tileChunkSize);
+
+	FloatRect localWallRect(localRectPosition.x - halfWidth, localRectPosition.y - halfHeight,
+				(right - left) + collisionCheckData.collisionRect.width,
+				(bottom - top) + collisionCheckData.collisionRect.height);
+	wallRects.addRect(localWallRect);
+      }
+    }
+  }
 
-	if(tempT < collisionResult.maxAllowedT)
-	{
-	  collisionResult.maxAllowedT = tempT;
+  // Positioning Player Point In The Center of Previous Collision Rect
+  Vec2f playerPoint = collisionCheckData.collisionRect[0] + Vec2f(halfWidth, halfHeight);
 
-	  if(wallIndex%2 == 0)
-	    collisionResult.collisionPlane = COLLISION_PLANE_HORIZONTAL;
-	  else
-	    collisionResult.collisionPlane = COLLISION_PLANE_VERTICAL;
+  // Checking 4 walls of every rect at once and Getting The One That Collides First
+  SweptHit hit = wallRects.sweepPoint(playerPoint, collisionCheckData.deltaVec, false);
+  if(hit.rectIndex != -1)
+  {
+    collisionResult.maxAllowedT = hit.maxAllowedT;
 
-	}
-      }
-    }
+    if(hit.wallIndex%2 == 0)
+      collisionResult.collisionPlane = COLLISION_PLANE_HORIZONTAL;
+    else
+      collisionResult.collisionPlane = COLLISION_PLANE_VERTICAL;
   }
 
   return collisionResult;
@@ -422,19 +827,18 @@ Level::checkCollisionsWithTiles(TileList& tiles,
 WorldCollisionResult
 Level::checkWorldCollision(const CollisionCheckData& collisionCheckData) const
 {
-  TileList affectedTiles = getAffectedTiles(collisionCheckData);
-  WorldCollisionResult collisionResult = checkCollisionsWithTiles(affectedTiles, collisionCheckData);
+  WorldPosition originTile;
+  IntRect tileBounds = getAffectedTileBounds(collisionCheckData, originTile);
+  WorldCollisionResult collisionResult = checkCollisionsWithWallRects(originTile, tileBounds, collisionCheckData);
   return collisionResult;
 }
 
 EntityCollisionResult
 Level::checkEntityCollision(const Entity* entity,
-			    const CollisionCheckData& collisionCheckData) const
+			    const CollisionCheckData& collisionCheckData,
+			    bool onlyMovedRows) const
 {
 
-  float maxAllowedT = 1.0f;
-  int wallIndex = -1;
-
   float halfWidth = collisionCheckData.collisionRect.width / 2.0f;
   float halfHeight = collisionCheckData.collisionRect.height / 2.0f;
 
@@ -443,22 +847,31 @@ Level::checkEntityCollision(const Entity* entity,
 
   EntityCollisionResult collisionResult;
 
-  for(auto entity2 = entityList[0].begin(); entity2 != entityList[0].end(); entity2++)
+  static thread_local SweptRectBatch collidingRects;
+  static thread_local std::vector<Entity*> collidingEntities;
+  static thread_local std::vector<int32> sweptRows;
+  collidingRects.clear();
+  collidingEntities.clear();
+
+  // Only rows in the grid cells the sweep covers, they're all collidable
+  collisionSnapshot.getSweptRows(collisionCheckData.basePosition, collisionCheckData.collisionRect,
+				 collisionCheckData.deltaVec, sweptRows);
+  for(auto rowIt = sweptRows.begin(); rowIt != sweptRows.end(); rowIt++)
   {
+    int32 row = *rowIt;
+
     // If The Entities are The Same we don't check Collisions(Comparing Pointers)
-    if(entity == (*entity2).get()) continue;
-    if(!(*entity2)->isAlive() || !(*entity2)->canCollideWithEntities()) continue;
+    if(entity == collisionSnapshot.entities[row]) continue;
+    if(onlyMovedRows && !collisionSnapshot.hasMoved[row]) continue;
 
     // Check Collisions
     // Convert To Local Space By Subtracting deltaVec
 
-    EntityPtr entityPtr2 = *entity2;
-
     // Collision Rect For Second Object
-    FloatRect collisionRect2 = entityPtr2->getCollisionRect();
+    const FloatRect& collisionRect2 = collisionSnapshot.collisionRects[row];
 
     Vec2f localRectPosition = EntityPosition::calculateDistanceInTiles(collisionCheckData.basePosition,
-									  entityPtr2->getPosition(),
+									  collisionSnapshot.positions[row],
 									  tileMap->getTileChunkSize());
 
     if(localRectPosition.getLength() > 4.0f) continue;
@@ -469,22 +882,21 @@ Level::checkEntityCollision(const Entity* entity,
 			    collisionRect2.width + collisionCheckData.collisionRect.width,
 			    collisionRect2.height + collisionCheckData.collisionRect.height);
 
-    // Checking Each of 4 walls and Getting The One That Collides First
-    for(int wallIndex=0; wallIndex < 4; wallIndex++)
-    {
-      float tempT = collidingRect.getMaxTime(entityPosition, collisionCheckData.deltaVec, wallIndex);
+    collidingRects.addRect(collidingRect);
+    collidingEntities.push_back(collisionSnapshot.entities[row]);
+  }
 
-      if(tempT < collisionResult.maxAllowedT && tempT >= 0.0f)
-      {
-	collisionResult.maxAllowedT = tempT;
-	collisionResult.collidedEntity = (*entity2).get();
+  // Checking 4 walls of every rect at once, overlapping entities (negative time) are skipped
+  SweptHit hit = collidingRects.sweepPoint(entityPosition, collisionCheckData.deltaVec, true);
+  if(hit.rectIndex != -1)
+  {
+    collisionResult.maxAllowedT = hit.maxAllowedT;
+    collisionResult.collidedEntity = collidingEntities[hit.rectIndex];
 
-	if(wallIndex%2 == 0)
-	  collisionResult.collisionPlane = COLLISION_PLANE_HORIZONTAL;
-	else
-	  collisionResult.collisionPlane = COLLISION_PLANE_VERTICAL;
-      }
-    }
+    if(hit.wallIndex%2 == 0)
+      collisionResult.collisionPlane = COLLISION_PLANE_HORIZONTAL;
+    else
+      collisionResult.collisionPlane = COLLISION_PLANE_VERTICAL;
   }
 
   return collisionResult;
@@ -496,7 +908,10 @@ Level::addEntity(EntityPtr& entityPtr)
   if(!isCollidingWithLevel(entityPtr.get()))
   {
     entityPtr->setLevel(this);
-    pendingEntityList.push_back(entityPtr);
+
+    // Already checked, only adding it waits for the apply phase
+    LevelCommand command = { LC_ADD_ENTITY, NULL, entityPtr, Vec2f(), 0 };
+    queueCommand(command);
     return true;
   }
   else
@@ -510,7 +925,165 @@ void
 Level::addOverlayEntity(EntityPtr& entityPtr)
 {
   entityPtr->setLevel(this);
-  entityList[1].push_back(entityPtr);
+
+  LevelCommand command = { LC_SPAWN_OVERLAY, NULL, entityPtr, Vec2f(), 0 };
+  queueCommand(command);
+}
+
+void
+Level::queueSpawn(const EntityPtr& entityPtr)
+{
+  LevelCommand command = { LC_SPAWN, NULL, entityPtr, Vec2f(), 0 };
+  queueCommand(command);
+}
+
+void
+Level::queueHealthChange(Entity* entity, float amount)
+{
+  LevelCommand command = { LC_ADD_HEALTH, entity, EntityPtr(), Vec2f(), amount };
+  queueCommand(command);
+}
+
+void
+Level::queueImpulse(Entity* entity, const Vec2f& velocity)
+{
+  LevelCommand command = { LC_ADD_VELOCITY, entity, EntityPtr(), velocity, 0 };
+  queueCommand(command);
+}
+
+void
+Level::queueXp(Entity* entity, float amount)
+{
+  LevelCommand command = { LC_ADD_XP, entity, EntityPtr(), Vec2f(), amount };
+  queueCommand(command);
+}
+
+void
+Level::queueKill(Entity* entity)
+{
+  LevelCommand command = { LC_KILL, entity, EntityPtr(), Vec2f(), 0 };
+  queueCommand(command);
+}
+
+bool
+Level::spawnProjectile(const Projectile& projectile)
+{
+  if(currentEntityCommands || isRecordingCommands)
+  {
+    LevelCommand command = { LC_SPAWN_PROJECTILE, NULL, EntityPtr(), Vec2f(), 0, projectile };
+    queueCommand(command);
+    return true;
+  }
+
+  return addProjectile(projectile);
+}
+
+void
+Level::queueCommand(const LevelCommand& command)
+{
+  if(currentEntityCommands)
+  {
+    currentEntityCommands->push_back(command);
+  }
+  else if(isRecordingCommands)
+  {
+    levelCommands.push_back(command);
+  }
+  else
+  {
+    applyCommand(command);
+    addSpawnedEntities();
+  }
+}
+
+void
+Level::applyCommand(const LevelCommand& command)
+{
+  switch(command.type)
+  {
+  case LC_SPAWN:
+    spawnedEntities.push_back(command.entity);
+    break;
+  case LC_ADD_ENTITY:
+    pendingEntityList.push_back(command.entity);
+    break;
+  case LC_SPAWN_OVERLAY:
+    entityList[1].push_back(command.entity);
+    break;
+  case LC_ADD_HEALTH:
+    command.target->addHealth(command.amount);
+    break;
+  case LC_ADD_VELOCITY:
+    command.target->addVelocity(command.velocity);
+    break;
+  case LC_ADD_XP:
+    command.target->addXp(command.amount);
+    break;
+  case LC_KILL:
+    if(command.target->isAlive()) command.target->die();
+    break;
+  case LC_SPAWN_PROJECTILE:
+    addProjectile(command.projectile);
+    break;
+  }
+}
+
+void
+Level::applyCommands()
+{
+  // Entity buffers in entity order, so the outcome doesn't depend on which thread updated what
+  for(auto commands = entityCommands.begin(); commands != entityCommands.end(); commands++)
+  {
+    for(auto command = commands->begin(); command != commands->end(); command++)
+    {
+      applyCommand(*command);
+    }
+    commands->clear();
+  }
+
+  // Applying can record more commands (e.g. health change text), so indexing and copying
+  for(size_t i = 0; i < levelCommands.size(); i++)
+  {
+    LevelCommand command = levelCommands[i];
+    applyCommand(command);
+  }
+  levelCommands.clear();
+
+  addSpawnedEntities();
+  isRecordingCommands = false;
+}
+
+void
+Level::addSpawnedEntities()
+{
+  if(spawnedEntities.empty()) return;
+
+  // One grid for the whole batch instead of scanning every entity per spawn
+  bool needsEntityGrid = false;
+  for(auto entityPtr = spawnedEntities.begin(); entityPtr != spawnedEntities.end(); entityPtr++)
+  {
+    if((*entityPtr)->canCollideWithEntities()) needsEntityGrid = true;
+  }
+  if(needsEntityGrid) buildEntityGrid();
+
+  for(auto entityPtr = spawnedEntities.begin(); entityPtr != spawnedEntities.end(); entityPtr++)
+  {
+    Entity* entity = (*entityPtr).get();
+
+    // Dropped spawns never existed, so whoever kept them sees them despawned
+    if(isCollidingWithTiles(entity) ||
+       (entity->canCollideWithEntities() && isCollidingInEntityGrid(entity)))
+    {
+      entity->alive = false;
+      entity->isDespawned = true;
+      continue;
+    }
+
+    entity->setLevel(this);
+    pendingEntityList.push_back(*entityPtr);
+  }
+
+  spawnedEntities.clear();
 }
 
 EventNameList
@@ -539,11 +1112,55 @@ Level::onEvent(const std::string& eventName, EventArgumentDataMap eventDataMap)
 bool
 Level::isCollidingWithLevel(Entity* entity) const
 {
-  const EntityPosition& entityPosition = entity->getPosition();
-  const FloatRect& collisionRect = entity->getCollisionRect();
-
   // Checking Collisions with Tiles - Cause It's Faster
-  CollisionCheckData collisionCheckData = { entityPosition, collisionRect,  Vec2f() };
+  if(isCollidingWithTiles(entity)) return true;
+
+  if(entity->canCollideWithEntities())
+  {
+
+    for(auto entityIt = entityList[0].begin(); entityIt != entityList[0].end(); entityIt++)
+    {
+      Entity* entity2 = (*entityIt).get();
+      if(doEntitiesCollide(entity, entity2)) return true;
+    }
+
+  }
+
+  return false;
+}
+
+bool
+Level::addProjectile(const Projectile& projectile)
+{
+  FloatRect collisionRect(0, 0, projectile.dimensions.x, projectile.dimensions.y);
+  if(isCollidingWithTiles(projectile.position, collisionRect)) return false;
+
+  for(auto entityIt = entityList[0].begin(); entityIt != entityList[0].end(); entityIt++)
+  {
+    Entity* entity = (*entityIt).get();
+    if(!entity->isAlive() || !entity->canCollideWithEntities()) continue;
+
+    FloatRect entityCollisionRect = entity->getCollisionRect();
+    entityCollisionRect += EntityPosition::calculateDistanceInTiles(projectile.position,
+								    entity->getPosition(),
+								    tileMap->getTileChunkSize());
+    if(collisionRect.doesRectCollideWith(entityCollisionRect)) return false;
+  }
+
+  projectileManager.addProjectile(projectile);
+  return true;
+}
+
+bool
+Level::isCollidingWithTiles(const Entity* entity) const
+{
+  return isCollidingWithTiles(entity->getPosition(), entity->getCollisionRect());
+}
+
+bool
+Level::isCollidingWithTiles(const EntityPosition& position, const FloatRect& collisionRect) const
+{
+  CollisionCheckData collisionCheckData = { position, collisionRect,  Vec2f() };
 
   TileList affectedTiles = getAffectedTiles(collisionCheckData);
   for(auto tileIt = affectedTiles.begin(); tileIt != affectedTiles.end(); tileIt++)
@@ -555,28 +1172,74 @@ Level::isCollidingWithLevel(Entity* entity) const
     }
   }
 
-  if(entity->canCollideWithEntities())
+  return false;
+}
+
+bool
+Level::doEntitiesCollide(const Entity* entity, const Entity* entity2) const
+{
+  if(entity == entity2 || !entity2->isAlive() || !entity2->canCollideWithEntities()) return false;
+
+  FloatRect collisionRect2 = entity2->getCollisionRect();
+  Vec2f relativeDistance = EntityPosition::calculateDistanceInTiles(entity->getPosition(),
+								       entity2->getPosition(),
+								       tileMap->getTileChunkSize());
+  collisionRect2 += relativeDistance;
+
+  return entity->getCollisionRect().doesRectCollideWith(collisionRect2);
+}
+
+// First and last grid cell (absolute tile) covered by the collision rect, both inclusive
+static void
+getEntityGridCells(const Entity* entity, const Vec2i& tileChunkSize, Vec3i& firstCell, Vec3i& lastCell)
+{
+  CollisionSnapshot::getGridCells(entity->getPosition(), entity->getCollisionRect(), tileChunkSize,
+				  firstCell, lastCell);
+}
+
+void
+Level::buildEntityGrid()
+{
+  entityGrid.clear();
+
+  const Vec2i& tileChunkSize = tileMap->getTileChunkSize();
+  for(auto entityPtr = entityList[0].begin(); entityPtr != entityList[0].end(); entityPtr++)
   {
+    Entity* entity = (*entityPtr).get();
+    if(!entity->isAlive() || !entity->canCollideWithEntities()) continue;
 
-    for(auto entityIt = entityList[0].begin(); entityIt != entityList[0].end(); entityIt++)
+    Vec3i firstCell, lastCell;
+    getEntityGridCells(entity, tileChunkSize, firstCell, lastCell);
+
+    for(int32 y = firstCell.y; y <= lastCell.y; y++)
     {
-      Entity* entity2 = (*entityIt).get();
-      if(entity == entity2 || !entity2->isAlive() || !entity2->canCollideWithEntities()) continue;
+      for(int32 x = firstCell.x; x <= lastCell.x; x++)
+      {
+	entityGrid[Vec3i(x, y, firstCell.z)].push_back(entity);
+      }
+    }
+  }
+}
 
-      EntityPosition entityPosition2 = entity2->getPosition();
-      FloatRect collisionRect2 = entity2->getCollisionRect();
+bool
+Level::isCollidingInEntityGrid(const Entity* entity) const
+{
+  Vec3i firstCell, lastCell;
+  getEntityGridCells(entity, tileMap->getTileChunkSize(), firstCell, lastCell);
 
-      Vec2f relativeDistance = EntityPosition::calculateDistanceInTiles(entityPosition,
-									   entityPosition2,
-									   tileMap->getTileChunkSize());
-      collisionRect2 += relativeDistance;
+  // Rects touching at a cell border share that cell, so covered cells are enough
+  for(int32 y = firstCell.y; y <= lastCell.y; y++)
+  {
+    for(int32 x = firstCell.x; x <= lastCell.x; x++)
+    {
+      auto cell = entityGrid.find(Vec3i(x, y, firstCell.z));
+      if(cell == entityGrid.end()) continue;
 
-      if(collisionRect.doesRectCollideWith(collisionRect2))
+      for(auto entity2 = cell->second.begin(); entity2 != cell->second.end(); entity2++)
       {
-	return true;
+	if(doEntitiesCollide(entity, *entity2)) return true;
       }
     }
-
   }
 
   return false;
@@ -585,10 +1248,13 @@ Level::isCollidingWithLevel(Entity* entity) const
 void
 Level::killCollidingEntities()
 {
+  buildEntityGrid();
+
   for(auto entityPtr = entityList[0].begin(); entityPtr != entityList[0].end(); entityPtr++)
   {
     Entity* entity = (*entityPtr).get();
-    if(isCollidingWithLevel(entity))
+    if(isCollidingWithTiles(entity) ||
+       (entity->canCollideWithEntities() && isCollidingInEntityGrid(entity)))
     {
       entity->die();
     }
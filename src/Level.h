@@ -11,6 +11,10 @@
 #include "Mobs.h"
 #include "TileMap.h"
 #include "TileState.h"
+#include "FlowField.h"
+#include "RoomGraph.h"
+#include "CollisionSnapshot.h"
+#include "ProjectileManager.h"
 
 typedef std::list<EntityPtr> EntityList;
 typedef std::list<WorldPosition> TileList;
@@ -23,6 +27,84 @@ struct CollisionCheckData {
 
 const int numbOfEntityLayers = 2;
 
+// Chebyshev distance in chunks from the player's chunk, entities further away are frozen
+const int32 activeChunkRadius = 1;
+const int32 reducedChunkRadius = 3;
+
+// Reduced rate entities are updated every n-th tick with the time they skipped
+const int32 reducedUpdatePeriod = 4;
+
+// Seconds until behaviours that came due while frozen check again
+const float frozenBehaviourDelay = 1.0f;
+
+enum ACTIVITY_TIER{
+  AT_ACTIVE,
+  AT_REDUCED,
+  AT_FROZEN
+};
+
+enum LEVEL_COMMAND_TYPE{
+  LC_SPAWN,           // Collision with the level is checked in bulk when applied
+  LC_ADD_ENTITY,      // Already checked by addEntity
+  LC_SPAWN_OVERLAY,
+  LC_ADD_HEALTH,
+  LC_ADD_VELOCITY,
+  LC_ADD_XP,
+  LC_KILL,
+  LC_SPAWN_PROJECTILE
+};
+
+// Intent recorded while the level updates, applied together with the rest after it
+struct LevelCommand {
+  LEVEL_COMMAND_TYPE type;
+  Entity* target;
+  EntityPtr entity;
+  Vec2f velocity;
+  float amount;
+  Projectile projectile;
+};
+
+typedef std::vector<LevelCommand> LevelCommandBuffer;
+
+enum SPAWN_ENTITY_TYPE{
+  SE_RAT,
+  SE_SNAKE,
+  SE_FOLLOWER,
+  SE_CANNON,
+  SE_RAT_SPAWNER,
+  SE_HEALTH_ITEM,
+  SE_NONE
+};
+
+// Entity of a room that isn't simulated while the player is far away
+struct SpawnDescriptor {
+  SPAWN_ENTITY_TYPE type;
+  EntityPosition position;
+  int32 mobLevel;
+  float value;
+
+  // Random values of the entity, drawn by the generator in the order the entities used
+  // to draw them, so the level doesn't depend on when the rooms get populated
+  Vec2f direction;
+  float time;
+};
+
+struct RoomPopulation {
+  std::vector<SpawnDescriptor> spawnDescriptors;
+
+  // Same order as spawnDescriptors while the room is populated
+  std::vector<EntityPtr> spawnedEntities;
+  bool isPopulated;
+};
+
+// Rooms get populated when the player comes within the first radius (tiles)
+// and released back to descriptors once he's beyond the second one
+const float defaultPopulateRadius = 24.0f;
+const float defaultReleaseRadius = 40.0f;
+
+// Collidable entities by every tile their collision rect touches, key is the absolute tile position
+typedef std::unordered_map<Vec3i, std::vector<Entity*>> EntityGrid;
+
 class Level : public ILevel{
 public:
   Level(); 
@@ -39,6 +121,16 @@ public:
   // Overlay Entities Won't be registered with EventManager
   // Adds to the second layer of entities 
   void addOverlayEntity(EntityPtr& entityPtr);
+
+  // Command Buffer
+  void queueSpawn(const EntityPtr& entityPtr);
+  void queueHealthChange(Entity* entity, float amount);
+  void queueImpulse(Entity* entity, const Vec2f& velocity);
+  void queueXp(Entity* entity, float amount);
+  void queueKill(Entity* entity);
+
+  bool spawnProjectile(const Projectile& projectile);
+  const ProjectileManager& getProjectileManager() const { return projectileManager; }
   
   Player* getPlayer() const { return player; }
   void setPlayer(Player* player) { this->player = player; }
@@ -47,14 +139,31 @@ public:
 
   // Checks collision between two entities and returns collision results 
   EntityCollisionResult checkCollisions(const Entity* entity, Vec2f deltaVec) const ;
+  // Entity is skipped when checking against other entities, can be NULL
+  EntityCollisionResult checkCollisions(const CollisionCheckData& collisionCheckData, const Entity* entity,
+					bool canCollideWithEntities) const;
+  void clampToMovedEntities(const Entity* entity, const Vec2f& deltaVec,
+			    EntityCollisionResult& collisionResult) const;
   bool canSeeEachOther(const Entity* entity1, const Entity* entity2, float maxRange) const ;
   Vec2f canSeeEachOtherCardinal(const Entity* entity1, const Entity* entity2, float maxRange) const ; 
 
+  FlowFieldSample samplePlayerFlowField(const EntityPosition& entityPosition) const;
+
+  // Filled in by the level generator
+  const RoomGraphPtr& getRoomGraph() const { return roomGraph; }
+  void addRoomSpawn(int32 roomIndex, const SpawnDescriptor& spawnDescriptor);
+  void setRoomPopulationRadius(float populateRadius, float releaseRadius);
+
+  AIScheduler& getAIScheduler() { return aiScheduler; }
+  bool findPath(const EntityPosition& start, const EntityPosition& goal, TilePath& path) const;
+
+  SurfaceSample getSurfaceSample(const Entity* entity) const;
+
   float getFrictionValueAtPosition(EntityPosition& entityPosition) const; 
   float getAccelerationModifierAtPosition(EntityPosition& entityPosition) const;
 
   // Returns state of the tile value where 
-  int getSurroundingTileData(const WorldPosition& worldPosition, TILE_TYPE tileType);
+  int getSurroundingTileData(const WorldPosition& worldPosition, TILE_TYPE tileType) const;
   
   // Event Operator
   EventNameList getEntityEvents();
@@ -62,28 +171,105 @@ public:
   
 private:
   TileMapPtr tileMap;
+  RoomGraphPtr roomGraph;
   EntityList entityList[numbOfEntityLayers];
   
   // Entities That Are Not Yet Registered By The Event Manager
   EntityList pendingEntityList;
   Player* player;
+
+  // Radiates from the tile of the player's collision center
+  FlowField playerFlowField;
+
+  // By room graph index
+  std::vector<RoomPopulation> roomPopulations;
+  float populateRadius;
+  float releaseRadius;
+
+  void updateRoomPopulations();
+  void populateRoom(RoomPopulation& roomPopulation);
+  void releaseRoom(RoomPopulation& roomPopulation);
+
+  // Removes the entity without its death action, e.g. when its room is released
+  void despawnEntity(Entity* entity);
+
+  // Entities of both layers in update order and commands each of them recorded
+  std::vector<Entity*> updatedEntities;
+  std::vector<float> updateDeltas;
+
+  // Time since the last decision for entities that think this tick, -1 for the rest
+  AIScheduler aiScheduler;
+  std::vector<float> thinkTimes;
+
+  // Layer 0 taken at the start of the update, collision checks query its grid
+  CollisionSnapshot collisionSnapshot;
+
+  // Snapshot rows of collidable entities updated this tick, their surfaces get sampled
+  std::vector<int32> movingRows;
+
+  // Swept after entities update against the same frozen world
+  ProjectileManager projectileManager;
+
+  BehaviourScheduler behaviourScheduler;
+  std::vector<EntityPtr> dueBehaviourEntities;
+  std::vector<LevelCommandBuffer> entityCommands;
+
+  // Staggers reduced rate updates
+  uint32 tickIndex;
+
+  // Commands recorded outside of the parallel update, e.g. by collision reactions
+  LevelCommandBuffer levelCommands;
+  bool isRecordingCommands;
+
+  // Spawns waiting for the bulk collision check
+  std::vector<EntityPtr> spawnedEntities;
+  EntityGrid entityGrid;
+
+  void queueCommand(const LevelCommand& command);
+  void applyCommand(const LevelCommand& command);
+
+  // Applies recorded commands in entity order, then the level ones, then adds spawns
+  void applyCommands();
+  void addSpawnedEntities();
+
+  void buildEntityGrid();
+  bool isCollidingWithTiles(const Entity* entity) const;
+  bool isCollidingWithTiles(const EntityPosition& position, const FloatRect& collisionRect) const;
+  bool isCollidingInEntityGrid(const Entity* entity) const;
+  bool doEntitiesCollide(const Entity* entity, const Entity* entity2) const;
   
+  // Updates entities in parallel against a frozen world, then applies
+  // their movement and collision reactions in entity order
+  // Only entities near the player run every tick, see ACTIVITY_TIER
   void updateEntities(const float lastDelta);
+
+  ACTIVITY_TIER getActivityTier(const Entity* entity, const Vec3i& playerChunk) const;
+
+  // Friction lookup for every moving row at once
+  void sampleSurfaces();
   
+  // Tiles swept by collisionCheckData as offsets from originTile, width and height count tiles
+  IntRect getAffectedTileBounds(const CollisionCheckData& collisionCheckData, WorldPosition& originTile) const;
+
   // Returns the list of tiles that are affected depending on collisionCheckData
   TileList getAffectedTiles(const CollisionCheckData& collisionCheckData) const;
   
-  WorldCollisionResult checkCollisionsWithTiles(TileList& tiles,
-						const CollisionCheckData& collisionCheckData) const;
+  // Tests merged wall rects of chunks instead of every wall tile
+  WorldCollisionResult checkCollisionsWithWallRects(const WorldPosition& originTile, const IntRect& tileBounds,
+						    const CollisionCheckData& collisionCheckData) const;
   
   WorldCollisionResult checkWorldCollision(const CollisionCheckData& collisionCheckData) const;
   
-  // Checks Collisions with the whole level 
+  // Checks Collisions with the snapshot rows near the sweep, or only with those already moved this tick
   EntityCollisionResult checkEntityCollision(const Entity* entity,
-					     const CollisionCheckData& collisionCheckData) const;
+					     const CollisionCheckData& collisionCheckData,
+					     bool onlyMovedRows = false) const;
   
   bool isCollidingWithLevel(Entity* entity) const;
 
+  // Adds the projectile unless it collides with tiles or entities
+  bool addProjectile(const Projectile& projectile);
+
   // For Debugging purposes - when testing collision checks 
   void killCollidingEntities();
 };
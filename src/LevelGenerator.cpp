@@ -91,8 +91,10 @@ LevelGenerator::fillRectangle(WorldPosition startPosition, Vec2i dimensions, TIL
 }
 
 void
-SimpleLevelGenerator::placeRoom(const Room& room)
+SimpleLevelGenerator::placeRoom(Room& room)
 {
+  room.graphIndex = level->getRoomGraph()->addRoom(room.topLeftCorner, room.dimensions);
+
   // Horizontal Walls
   placeLine(room.topLeftCorner, Vec2i(room.dimensions.x, 0), TILE_TYPE_WALL );
   placeLine(room.topLeftCorner + Vec2i(0, room.dimensions.y - 1), Vec2i(room.dimensions.x, 0), TILE_TYPE_WALL);
@@ -122,8 +124,8 @@ SimpleLevelGenerator::placeRoomEntities(const Room& room, bool immediateMode)
     {
       entityPosition = room.topLeftCorner + Vec2i(1, 1);
       entityPosition += Vec2i(rand()%(room.dimensions.x-2), rand()%(room.dimensions.y-2));
-      Entity* entity = new HealthItem(EntityPosition(entityPosition), (float)room.depth / 15);
-      level->addEntity(EntityPtr(entity));
+      SpawnDescriptor spawnDescriptor = { SE_HEALTH_ITEM, EntityPosition(entityPosition), 0, (float)room.depth / 15 };
+      level->addRoomSpawn(room.graphIndex, spawnDescriptor);
     }
     
   }
@@ -139,9 +141,12 @@ SimpleLevelGenerator::placeRoomEntities(const Room& room, bool immediateMode)
     {
       for(int x = 0; x < dimensions.x; x++)
       {
-	Entity* entity = NULL;
-	EntityPosition entityPosition = EntityPosition(room.topLeftCorner + Vec2i(x, y));
-	int mobLevel = (roomDifficulty * 20.0f) + 1;
+	SpawnDescriptor spawnDescriptor;
+	spawnDescriptor.type = SE_NONE;
+	spawnDescriptor.position = EntityPosition(room.topLeftCorner + Vec2i(x, y));
+	spawnDescriptor.mobLevel = (roomDifficulty * 20.0f) + 1;
+	spawnDescriptor.value = 0;
+	spawnDescriptor.time = 0;
 	
 	if(roomDifficulty < 0.2f)
 	{
@@ -152,18 +157,27 @@ SimpleLevelGenerator::placeRoomEntities(const Room& room, bool immediateMode)
 	    {
 	      
 	      if(rand()%5)
-		entity = new Rat(entityPosition, mobLevel);
+	      {
+		spawnDescriptor.type = SE_RAT;
+		spawnDescriptor.direction = Vec2f::directionVector();
+		spawnDescriptor.time = Rat::getRandomWanderTime();
+	      }
 	      else
-		entity = new HealthItem(entityPosition, roomDifficulty * 20.0f + 0.01f);
+	      {
+		spawnDescriptor.type = SE_HEALTH_ITEM;
+		spawnDescriptor.value = roomDifficulty * 20.0f + 0.01f;
+	      }
 	    }
 	    else
 	    {
-	      entity = new Snake(entityPosition, mobLevel);
+	      spawnDescriptor.type = SE_SNAKE;
+	      spawnDescriptor.direction = Snake::getRandomDirection();
 	    }
 	  }
 	  else if(rand()%1000 < 4)
 	  {
-	    entity = new MobSpawner(entityPosition, mobLevel, MT_RAT);
+	    spawnDescriptor.type = SE_RAT_SPAWNER;
+	    spawnDescriptor.time = MobSpawner::getRandomSpawnTime();
 	  }
 	}
 	else// if(roomDifficulty < 0.4f)
@@ -173,22 +187,28 @@ SimpleLevelGenerator::placeRoomEntities(const Room& room, bool immediateMode)
 	    if(rand()%4)
 	    {
 	      if(rand()%3)
-		entity = new Follower(entityPosition, mobLevel);
+		spawnDescriptor.type = SE_FOLLOWER;
 	      else
-		entity = new HealthItem(entityPosition, roomDifficulty * 20.0f + 0.01f);
+	      {
+		spawnDescriptor.type = SE_HEALTH_ITEM;
+		spawnDescriptor.value = roomDifficulty * 20.0f + 0.01f;
+	      }
 	    }
 	    else
 	    {
 	      if(rand()%3)
-		entity = new Cannon(entityPosition, mobLevel);
+		spawnDescriptor.type = SE_CANNON;
 	      else
-		entity = new Snake(entityPosition, mobLevel);
+	      {
+		spawnDescriptor.type = SE_SNAKE;
+		spawnDescriptor.direction = Snake::getRandomDirection();
+	      }
 	    }
 	    
 	  }
 	}
 	
-	if(entity) level->addEntity(EntityPtr(entity));
+	if(spawnDescriptor.type != SE_NONE) level->addRoomSpawn(room.graphIndex, spawnDescriptor);
       }
     }
   }
@@ -220,6 +240,7 @@ void
 SimpleLevelGenerator::placeCorridor(const Room& srcRoom, const Room& dstRoom, const DIRECTION direction)
 {
   TileMapPtr tileMap = level->getTileMap();
+  WorldPosition corridorPosition;
   
   if(direction == DIRECTION_UP)
   {
@@ -229,7 +250,7 @@ SimpleLevelGenerator::placeCorridor(const Room& srcRoom, const Room& dstRoom, co
     possibleCorridorPlacements -= 2;
     int horizontalOffset = (rand()%possibleCorridorPlacements) + 1;
     
-    WorldPosition corridorPosition = srcRoom.topLeftCorner + Vec2i(horizontalOffset, 0);
+    corridorPosition = srcRoom.topLeftCorner + Vec2i(horizontalOffset, 0);
     
     tileMap->setTileType(corridorPosition, srcRoom.floorType);
   }
@@ -241,7 +262,7 @@ SimpleLevelGenerator::placeCorridor(const Room& srcRoom, const Room& dstRoom, co
     possibleCorridorPlacements -= 2;
     int verticalOffset = (rand()%possibleCorridorPlacements) + 1;
     
-    WorldPosition corridorPosition = dstRoom.topLeftCorner + Vec2i(0, verticalOffset);
+    corridorPosition = dstRoom.topLeftCorner + Vec2i(0, verticalOffset);
     
     tileMap->setTileType(corridorPosition, srcRoom.floorType);
   }
@@ -253,7 +274,7 @@ SimpleLevelGenerator::placeCorridor(const Room& srcRoom, const Room& dstRoom, co
     possibleCorridorPlacements -= 2;
     int horizontalOffset = (rand()%possibleCorridorPlacements) + 1;
     
-    WorldPosition corridorPosition = dstRoom.topLeftCorner + Vec2i(horizontalOffset, 0);
+    corridorPosition = dstRoom.topLeftCorner + Vec2i(horizontalOffset, 0);
     
     tileMap->setTileType(corridorPosition, srcRoom.floorType);
   }
@@ -265,11 +286,12 @@ SimpleLevelGenerator::placeCorridor(const Room& srcRoom, const Room& dstRoom, co
     possibleCorridorPlacements -= 2;
     int verticalOffset = (rand()%possibleCorridorPlacements) + 1;
     
-    WorldPosition corridorPosition = srcRoom.topLeftCorner + Vec2i(0, verticalOffset);
+    corridorPosition = srcRoom.topLeftCorner + Vec2i(0, verticalOffset);
     
     tileMap->setTileType(corridorPosition, srcRoom.floorType);
   }
-  
+
+  level->getRoomGraph()->addPortal(srcRoom.graphIndex, dstRoom.graphIndex, corridorPosition);
 }
 
 void
@@ -278,6 +300,9 @@ SimpleLevelGenerator::openWall(const Room& srcRoom, const Room& dstRoom, const D
   
   TileMapPtr tileMap = level->getTileMap();
 
+  // Middle of the opening connects the rooms in the graph
+  WorldPosition portalPosition;
+
   if(direction == DIRECTION_UP)
   {
     int possibleCorridorPlacements = std::min(srcRoom.dimensions.x, dstRoom.dimensions.x);
@@ -288,6 +313,7 @@ SimpleLevelGenerator::openWall(const Room& srcRoom, const Room& dstRoom, const D
     {
       WorldPosition corridorPosition = srcRoom.topLeftCorner + Vec2i(offset + 1, 0);
       tileMap->setTileType(corridorPosition, srcRoom.floorType);
+      if(offset == possibleCorridorPlacements / 2) portalPosition = corridorPosition;
     }
   }
   else if(direction == DIRECTION_RIGHT)
@@ -301,6 +327,7 @@ SimpleLevelGenerator::openWall(const Room& srcRoom, const Room& dstRoom, const D
       
       WorldPosition wallTilePosition = dstRoom.topLeftCorner + Vec2i(0, offset + 1);
       tileMap->setTileType(wallTilePosition, srcRoom.floorType);
+      if(offset == possibleCorridorPlacements / 2) portalPosition = wallTilePosition;
     }
     
   }
@@ -316,6 +343,7 @@ SimpleLevelGenerator::openWall(const Room& srcRoom, const Room& dstRoom, const D
 
       WorldPosition corridorPosition = dstRoom.topLeftCorner + Vec2i(offset + 1, 0);
       tileMap->setTileType(corridorPosition, srcRoom.floorType);
+      if(offset == possibleCorridorPlacements / 2) portalPosition = corridorPosition;
     }
   }
   else if(direction == DIRECTION_LEFT )
@@ -329,9 +357,11 @@ SimpleLevelGenerator::openWall(const Room& srcRoom, const Room& dstRoom, const D
     {
       WorldPosition corridorPosition = srcRoom.topLeftCorner + Vec2i(0, offset + 1);
       tileMap->setTileType(corridorPosition, srcRoom.floorType);
+      if(offset == possibleCorridorPlacements / 2) portalPosition = corridorPosition;
     }
   }
-  
+
+  level->getRoomGraph()->addPortal(srcRoom.graphIndex, dstRoom.graphIndex, portalPosition);
 }
 
 void
@@ -10,12 +10,15 @@ class Room{
   Vec2i dimensions;
   int depth;
   TILE_TYPE floorType;
+
+  // Index in the level's room graph, -1 until it's placed
+  int32 graphIndex;
   
   bool isColliding(TileMapPtr tileMap);
   
   Room(const WorldPosition& topLeftCorner=WorldPosition(), const Vec2i& dimensions=Vec2i(),
        int32 depth=0, TILE_TYPE floorType = TILE_TYPE_STONE_GROUND) :
-    topLeftCorner(topLeftCorner), dimensions(dimensions), depth(depth), floorType(floorType) {}
+    topLeftCorner(topLeftCorner), dimensions(dimensions), depth(depth), floorType(floorType), graphIndex(-1) {}
 };
 
 enum DIRECTION{
@@ -85,7 +88,9 @@ class SimpleLevelGenerator : public LevelGenerator{
   // Set after level is generated completely
   int maxRoomDepth = -1;
   
-  void placeRoom(const Room& room);
+  // Also adds the room to the room graph
+  void placeRoom(Room& room);
+  // Entities become spawn descriptors of the room, the level creates them once the player comes close
   void placeRoomEntities(const Room& room, bool immediateMode = true);
 
   // Places Room entities in non immediate modein all
@@ -95,6 +100,7 @@ class SimpleLevelGenerator : public LevelGenerator{
   int getMaxRoomDepth() const ;
   
   // Places Corridor When The Rooms Are Touching
+  // Both of them connect the rooms in the room graph
   void placeCorridor(const Room& srcRoom, const Room& dstRoom, DIRECTION direction);
   
   // Removes The Wall Between Rooms 
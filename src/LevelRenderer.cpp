@@ -2,6 +2,7 @@
 #include <iostream>
 #include <jpb/Profiler.h>
 #include <jpb/Noise.h>
+#include "JobSystem.h"
 
 void EntityRenderThing::render(LevelRenderer* levelRenderer)
 {
@@ -18,23 +19,49 @@ bool compareEntityRenderThing(const RenderThingPtr& ent1, const RenderThingPtr&
   return ent1->bottomY < ent2->bottomY;
 }
 
+void appendSpriteQuad(sf::VertexArray& vertexArray, const sf::Sprite& sprite,
+		      const sf::Vector2f& position, float scale, const sf::Color& color)
+{
+  const sf::IntRect& textureRect = sprite.getTextureRect();
+
+  float width = textureRect.width * scale;
+  float height = textureRect.height * scale;
+
+  float u1 = (float)textureRect.left;
+  float v1 = (float)textureRect.top;
+  float u2 = (float)(textureRect.left + textureRect.width);
+  float v2 = (float)(textureRect.top + textureRect.height);
+
+  vertexArray.append(sf::Vertex(position, color, sf::Vector2f(u1, v1)));
+  vertexArray.append(sf::Vertex(position + sf::Vector2f(width, 0), color, sf::Vector2f(u2, v1)));
+  vertexArray.append(sf::Vertex(position + sf::Vector2f(width, height), color, sf::Vector2f(u2, v2)));
+  vertexArray.append(sf::Vertex(position + sf::Vector2f(0, height), color, sf::Vector2f(u1, v2)));
+}
+
 LevelRenderer::LevelRenderer() : window(NULL), tileSizeInPixels(0)
 {
   bool loadedFont = font.loadFromFile("../resources/fonts/chiller.ttf");
   assert(loadedFont);
+
+  textCache.setFont(&font);
 }
 
 void
-LevelRenderer::renderLevel(const LevelPtr& level, EntityPosition& cameraPosition)
+LevelRenderer::renderLevel(const RenderSnapshot& renderSnapshot)
 {
   assert(window);
 
-  this->level = level.get();
+  this->level = renderSnapshot.level.get();
+  tileSizeInPixels = renderSnapshot.tileSizeInPixels;
+  textCache.nextFrame();
 
   const TileMapPtr& tileMap = level->getTileMap();
+  EntityPosition cameraPosition = renderSnapshot.cameraPosition;
 
   Profiler::get()->start("GetEntForRender");
-  EntityListForRendering entitiesForRendering = getEntityListForRendering(level->getEntityList(0), cameraPosition,
+  EntityListForRendering entitiesForRendering = getEntityListForRendering(renderSnapshot,
+									  renderSnapshot.getEntityList(0),
+									  cameraPosition,
 									  tileMap->getTileChunkSize());
   Profiler::get()->end("GetEntForRender");
 
@@ -54,9 +81,14 @@ LevelRenderer::renderLevel(const LevelPtr& level, EntityPosition& cameraPosition
 
   // Overlay Layer
   Profiler::get()->start("OverlayRender");
-  renderEntities(level->getEntityList(1), cameraPosition,
+  renderEntities(renderSnapshot, renderSnapshot.getEntityList(1), cameraPosition,
 		 tileMap->getTileChunkSize());
   Profiler::get()->end("OverlayRender");
+
+  // Captions and overlay texts are batched, so they end up on top
+  Profiler::get()->start("TextRender");
+  textCache.flush(*window);
+  Profiler::get()->end("TextRender");
 }
 
 int LevelRenderer::getSpriteIndex(TILE_STATE tileState, int tileHash)
@@ -168,7 +200,7 @@ int LevelRenderer::getSpriteIndex(TILE_STATE tileState, int tileHash)
 }
 
 Vec2f
-LevelRenderer::getEntityPositionOnScreen(const EntityPtr& entity, EntityPosition& cameraPosition,
+LevelRenderer::getEntityPositionOnScreen(const EntityPosition& position, EntityPosition& cameraPosition,
 					 const Vec2i& tileChunkSize) const
 {
   const sf::Vector2u windowDimensions = window->getSize();
@@ -191,7 +223,6 @@ LevelRenderer::getEntityPositionOnScreen(const EntityPtr& entity, EntityPosition
   Vec2f cameraOffset((float) topLeftViewport.worldPosition.tilePosition.x * tileSizeInPixels,
 		     (float) topLeftViewport.worldPosition.tilePosition.y * tileSizeInPixels);
 
-  const EntityPosition& position = entity->getPosition();
   Vec2f entityPositionOnScreen = EntityPosition::calculateDistanceInTiles(topLeftViewport,
 									  position,
 									  tileChunkSize);
@@ -202,7 +233,8 @@ LevelRenderer::getEntityPositionOnScreen(const EntityPtr& entity, EntityPosition
 }
 
 EntityListForRendering
-LevelRenderer::getEntityListForRendering(const EntityList& entityList,
+LevelRenderer::getEntityListForRendering(const RenderSnapshot& renderSnapshot,
+					 const EntitySnapshotList& entityList,
 					 EntityPosition& cameraPosition,
 					 const Vec2i& tileChunkSize)
 {
@@ -212,9 +244,9 @@ LevelRenderer::getEntityListForRendering(const EntityList& entityList,
 
   for(auto entityIt = entityList.begin() ; entityIt != entityList.end() ; entityIt++)
   {
-    const EntityRenderData* entityRenderData = (*entityIt)->getRenderData();
-    Vec2f entityPositionOnScreen = getEntityPositionOnScreen(*entityIt, cameraPosition, tileChunkSize);
-    Vec2f dimensions = (*entityIt)->getDimensions() * tileSizeInPixels;
+    const EntityRenderData* entityRenderData = renderSnapshot.getRenderData(*entityIt);
+    Vec2f entityPositionOnScreen = getEntityPositionOnScreen(entityIt->position, cameraPosition, tileChunkSize);
+    Vec2f dimensions = entityIt->dimensions * tileSizeInPixels;
 
     if(entityPositionOnScreen.y > windowDimensions.y || entityPositionOnScreen.x > windowDimensions.x ||
        entityPositionOnScreen.y + (dimensions.y * tileSizeInPixels) < 0 ||
@@ -245,16 +277,21 @@ LevelRenderer::renderSortedEntities(EntityListForRendering& entityListForRenderi
   entityListForRendering.clear();
 }
 
-EntityListForRendering
-LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& screenChunkPosition,
-			       const Vec3i& tileChunkPosition)
+void
+LevelRenderer::buildTileChunk(TileChunkRenderData& tileChunkRenderData, const sf::Vector2u& windowDimensions)
 {
-  EntityListForRendering tilesForSortedInChunk;
+  const TileChunkPtr& tileChunk = tileChunkRenderData.tileChunk;
+  const Vec2f& screenChunkPosition = tileChunkRenderData.screenChunkPosition;
+  const Vec3i& tileChunkPosition = tileChunkRenderData.tileChunkPosition;
+
+  EntityListForRendering& tilesForSortedInChunk = tileChunkRenderData.tilesForSorting;
+  sf::VertexArray& floorVertices = tileChunkRenderData.floorVertices;
 
-  sf::RectangleShape rectangleShape = sf::RectangleShape(sf::Vector2f(tileSizeInPixels, tileSizeInPixels));
+  tilesForSortedInChunk.clear();
+  floorVertices.clear();
+  floorVertices.setPrimitiveType(sf::Quads);
 
   const TileChunkData& tileChunkData = tileChunk->getTileChunkData();
-  const sf::Vector2u windowDimensions = window->getSize();
 
   static const float wallHeight = 2.0f;
 
@@ -277,7 +314,6 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
     maxY -= (screenChunkPosition.y - windowDimensions.y) / tileSizeInPixels;
 
   sf::Vector2f screenTilePosition = sf::Vector2f(screenChunkPosition.x, screenChunkPosition.y);
-  rectangleShape.setPosition(screenTilePosition);
 
   for(int y = minY; y < maxY; ++y)
   {
@@ -293,8 +329,6 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
       screenTilePosition = sf::Vector2f(screenChunkPosition.x + (x * tileSizeInPixels),
 					screenChunkPosition.y + (y * tileSizeInPixels));
 
-      rectangleShape.setPosition(screenTilePosition);
-
 
       NoiseParams noiseParams = {0.05f, 3, 2.0f, 0.5f};
       Vec2f globalTilePosition(x + tileChunkPosition.x * tileChunkWidth,
@@ -320,7 +354,6 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
 	  float finalScale = tileSizeInPixels / 16.0f;
 
 	  WorldPosition tempWorldPosition(tileChunkPosition, Vec2i(x, y));
-	  std::string spriteName = "wallTop1_";
 
 	  TILE_STATE tileState = (TILE_STATE)level->getSurroundingTileData(tempWorldPosition, TILE_TYPE_WALL);
 
@@ -331,8 +364,7 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
 	  }
 	  else spriteIndex = 1;
 
-	  spriteName += std::to_string(spriteIndex);
-	  tileSprite = spriteManager->getSprite(spriteName);
+	  tileSprite = spriteManager->getSprite(getSpriteSetHandle(SPRITE_WALLTOP1, spriteIndex));
 
 	  tileSprite.setScale(finalScale, finalScale);
 	  tileSprite.setPosition(screenTilePosition - sf::Vector2f(0, tileSizeInPixels));
@@ -344,8 +376,6 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
 
 	  if(!(tileState & ST_SOUTH))
 	  {
-	    std::string spriteName = "wall1_";
-
 	    static const float commonWallPercentage = 65.0f;
 	    int tileKind;
 
@@ -362,8 +392,7 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
 	      if(tileKind != 2) tileKind ++;
 	    }
 
-	    spriteName += std::to_string(tileKind);
-	    tileSprite = spriteManager->getSprite(spriteName);
+	    tileSprite = spriteManager->getSprite(getSpriteSetHandle(SPRITE_WALL1, tileKind));
 
 	    tileSprite.setScale(finalScale, finalScale);
 	    tileSprite.setPosition(screenTilePosition);
@@ -383,10 +412,6 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
       case TILE_TYPE_STONE_ICE_GROUND:
       case TILE_TYPE_STONE_GROUND:
 	{
-	  rectangleShape.setSize(sf::Vector2f(tileSizeInPixels, tileSizeInPixels));
-	  rectangleShape.setFillColor(sf::Color(128, 128, 128));
-
-	  std::string spriteName = "floor1_";
 	  WorldPosition tempWorldPosition(tileChunkPosition, Vec2i(x, y));
 
 	  TILE_STATE tileState = (TILE_STATE)level->getSurroundingTileData(tempWorldPosition, tileType);
@@ -434,33 +459,29 @@ LevelRenderer::renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& scree
 #endif
 	  }
 
-	  spriteName += std::to_string(spriteIndex);
-	  sf::Sprite tileSprite = spriteManager->getSprite(spriteName);
+	  const sf::Sprite& tileSprite = spriteManager->getSprite(getSpriteSetHandle(SPRITE_FLOOR1, spriteIndex));
+	  sf::Color tileColor = sf::Color::White;
 
-	  if(tileType == TILE_TYPE_STONE_ICE_GROUND) tileSprite.setColor(sf::Color(165, 242, 243));
-	  if(tileType == TILE_TYPE_STONE_SPEED_GROUND) tileSprite.setColor(sf::Color(250,128,114));
+	  if(tileType == TILE_TYPE_STONE_ICE_GROUND) tileColor = sf::Color(165, 242, 243);
+	  if(tileType == TILE_TYPE_STONE_SPEED_GROUND) tileColor = sf::Color(250,128,114);
 
 	  sf::Color maxColor = sf::Color::Red;
 	  sf::Color minColor = sf::Color::Green;
 
 	  // Hash visualisation thingy
-	  // if(tileHash > 65) tileSprite.setColor(maxColor);
-	  // else tileSprite.setColor(minColor);
+	  // if(tileHash > 65) tileColor = maxColor;
+	  // else tileColor = minColor;
 
 	  float finalScale = tileSizeInPixels / 16.0f;
 
-	  tileSprite.setScale(finalScale, finalScale);
-	  tileSprite.setPosition(screenTilePosition);
-
-	  window->draw(tileSprite);
+	  // Floors are never sorted, so they go straight into chunk vertices
+	  appendSpriteQuad(floorVertices, tileSprite, screenTilePosition, finalScale, tileColor);
 
 	} break;
 
       } // switch
     }
   }
-
-  return tilesForSortedInChunk;
 }
 
 EntityListForRendering
@@ -501,6 +522,9 @@ LevelRenderer::renderTileMap(const TileMapPtr& tileMap, EntityPosition& cameraPo
   Vec3i bottomRightChunkPosition = topLeftChunkPosition +
     Vec3i(ceil(chunksPerScreenWidth) + 1, ceil(chunksPerScreenHeight) + 1, 0);
 
+  // Vertex arrays of chunks are kept between frames to reuse their memory
+  uint32 visibleChunkCount = 0;
+
   //Vec2f cameraPositionInPixels =
 
   for(int y = topLeftChunkPosition.y; y < bottomRightChunkPosition.y; y++)
@@ -531,17 +555,46 @@ LevelRenderer::renderTileMap(const TileMapPtr& tileMap, EntityPosition& cameraPo
       Vec3i tileChunkPosition(x, y, cameraPosition.worldPosition.tileChunkPosition.z);
 
       // If The Chunk Doesn't Exist We don't render anything
-      if(tileChunkMap.count(tileChunkPosition))
+      auto tileChunkIt = tileChunkMap.find(tileChunkPosition);
+      if(tileChunkIt != tileChunkMap.end())
       {
-	EntityListForRendering tilesForSortedInChunk = renderTileChunk(tileChunkMap.at(tileChunkPosition),
-								       screenChunkPosition, tileChunkPosition);
+	if(visibleChunkCount == visibleTileChunks.size()) visibleTileChunks.resize(visibleChunkCount + 1);
 
-	// It Moves Data
-	tilesForSortedRendering.splice(tilesForSortedRendering.end(), tilesForSortedInChunk);
+	TileChunkRenderData& tileChunkRenderData = visibleTileChunks[visibleChunkCount++];
+	tileChunkRenderData.tileChunk = tileChunkIt->second;
+	tileChunkRenderData.tileChunkPosition = tileChunkPosition;
+	tileChunkRenderData.screenChunkPosition = screenChunkPosition;
       }
     }
   }
 
+  // Chunks don't depend on each other, so every chunk is a separate job
+  Profiler::get()->start("BuildTileChunks");
+  JobSystem::get()->parallelFor(visibleChunkCount, 1,
+				[this, &windowDimensions](int32 begin, int32 end)
+				{
+				  for(int32 i = begin; i < end; i++)
+				  {
+				    buildTileChunk(visibleTileChunks[i], windowDimensions);
+				  }
+				});
+  Profiler::get()->end("BuildTileChunks");
+
+  // Submitting is done only from this thread
+  sf::RenderStates atlasRenderStates(&spriteManager->getAtlasTexture());
+
+  for(uint32 i = 0; i < visibleChunkCount; i++)
+  {
+    TileChunkRenderData& tileChunkRenderData = visibleTileChunks[i];
+    window->draw(tileChunkRenderData.floorVertices, atlasRenderStates);
+
+    // It Moves Data
+    tilesForSortedRendering.splice(tilesForSortedRendering.end(), tileChunkRenderData.tilesForSorting);
+
+    // Chunk isn't kept alive after it's drawn
+    tileChunkRenderData.tileChunk.reset();
+  }
+
   return tilesForSortedRendering;
 }
 
@@ -612,7 +665,7 @@ LevelRenderer::renderEntity(const EntityRenderData* entityRenderData, Vec2f enti
       // this should be read from the sprite object
       sf::Vector2f entityDimensions;
 
-      sf::Sprite mobSprite = spriteManager->getSprite(mobRenderData.spriteName);
+      sf::Sprite mobSprite = spriteManager->getSprite(mobRenderData.spriteHandle);
 
       // CONSTANT ALERT !!!
 
@@ -687,20 +740,16 @@ LevelRenderer::renderEntity(const EntityRenderData* entityRenderData, Vec2f enti
       float textHeightInTiles = 0.5f;
       float textDistanceFromLifeBar = 0.1f;
 
-      sf::Text entityText;
-      entityText.setFont(font);
-      entityText.setString(mobRenderData.caption);
-      entityText.setCharacterSize(textHeightInTiles * tileSizeInPixels);
+      uint32 characterSize = (uint32)(textHeightInTiles * tileSizeInPixels);
+      const TextLayout& textLayout = textCache.getLayout(mobRenderData.caption, characterSize);
 
-      sf::FloatRect localTextBounds = entityText.getLocalBounds();
-      float widthLeft = entityDimensionsInPixels.x - localTextBounds.width;
+      float widthLeft = entityDimensionsInPixels.x - textLayout.localBounds.width;
 
-      entityText.setPosition(lifeBarPosition + sf::Vector2f(widthLeft/ 2.0f,
-							    -(textDistanceFromLifeBar + textHeightInTiles) *
-							    tileSizeInPixels));
-      entityText.setColor(sf::Color::Black);
+      Vec2f textPosition(lifeBarPosition.x + widthLeft / 2.0f,
+			 lifeBarPosition.y - (textDistanceFromLifeBar + textHeightInTiles) *
+			 tileSizeInPixels);
 
-      window->draw(entityText);
+      textCache.queueText(textLayout, characterSize, textPosition, sf::Color::Black);
 
     } break;
   case ER_OVERLAYTEXT:
@@ -722,20 +771,16 @@ LevelRenderer::renderEntity(const EntityRenderData* entityRenderData, Vec2f enti
 
       //window->draw(rectangleShape);
 
-      sf::Text entityText;
-      entityText.setFont(font);
-      entityText.setString(overlayTextRenderData.text);
       float textHeightInTiles = overlayTextRenderData.fontSize;
-      entityText.setCharacterSize(textHeightInTiles * tileSizeInPixels);
+      uint32 characterSize = (uint32)(textHeightInTiles * tileSizeInPixels);
 
       sf::Color textColor = sf::Color(overlayTextRenderData.textColor.x,
 				      overlayTextRenderData.textColor.y,
 				      overlayTextRenderData.textColor.z,
 				      255 - overlayTextRenderData.textFadeValue);
 
-      sf::FloatRect localTextBounds = entityText.getLocalBounds();
-      entityText.setPosition(entityPositionOnScreen.x, entityPositionOnScreen.y);
-      entityText.setColor(textColor);
+      const TextLayout& textLayout = textCache.getLayout(overlayTextRenderData.text, characterSize);
+      const sf::FloatRect& localTextBounds = textLayout.localBounds;
 
       if(entityPositionOnScreen.x > windowDimensions.x ||
 	 entityPositionOnScreen.y > windowDimensions.y ||
@@ -745,7 +790,7 @@ LevelRenderer::renderEntity(const EntityRenderData* entityRenderData, Vec2f enti
 	return;
       }
 
-      window->draw(entityText);
+      textCache.queueText(textLayout, characterSize, entityPositionOnScreen, textColor);
 
 
     } break;
@@ -753,7 +798,7 @@ LevelRenderer::renderEntity(const EntityRenderData* entityRenderData, Vec2f enti
     {
       const BasicSpriteRenderData& basicSpriteRenderData = *((BasicSpriteRenderData*)entityRenderData);
 
-      sf::Sprite mobSprite = spriteManager->getSprite(basicSpriteRenderData.basicSpriteName);
+      sf::Sprite mobSprite = spriteManager->getSprite(basicSpriteRenderData.basicSpriteHandle);
       // if(basicSpriteRenderData.colorAlpha != 1.0f)
       // {
       //	const Vector3f& color = basicSpriteRenderData.color;
@@ -774,13 +819,13 @@ LevelRenderer::renderEntity(const EntityRenderData* entityRenderData, Vec2f enti
 }
 
 void
-LevelRenderer::renderEntities(const EntityList& entityList, EntityPosition& cameraPosition,
-			      const Vec2i& tileChunkSize)
+LevelRenderer::renderEntities(const RenderSnapshot& renderSnapshot, const EntitySnapshotList& entityList,
+			      EntityPosition& cameraPosition, const Vec2i& tileChunkSize)
 {
   for(auto entityIt = entityList.begin(); entityIt != entityList.end(); entityIt++)
   {
-    Vec2f entityPositionOnScreen = getEntityPositionOnScreen(*entityIt, cameraPosition, tileChunkSize);
-    const EntityRenderData* entityRenderData = (*entityIt)->getRenderData();
+    Vec2f entityPositionOnScreen = getEntityPositionOnScreen(entityIt->position, cameraPosition, tileChunkSize);
+    const EntityRenderData* entityRenderData = renderSnapshot.getRenderData(*entityIt);
     renderEntity(entityRenderData, entityPositionOnScreen);
   }
 }
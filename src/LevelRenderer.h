@@ -2,7 +2,9 @@
 
 #include <SFML/Graphics.hpp>
 #include "Level.h"
+#include "RenderSnapshot.h"
 #include "SpriteManager.h"
+#include "TextCache.h"
 
 typedef std::list<sf::Sprite> SpriteList;
 
@@ -52,6 +54,21 @@ typedef std::list<RenderThingPtr> EntityListForRendering;
 // Comparison function for sorting
 bool compareEntityRenderThing(const RenderThingPtr& ent1, const RenderThingPtr& ent2);
 
+// Appends textured quad of the sprite, sprite's own transform is ignored
+void appendSpriteQuad(sf::VertexArray& vertexArray, const sf::Sprite& sprite,
+		      const sf::Vector2f& position, float scale, const sf::Color& color);
+
+// Everything needed to draw one visible chunk, filled by render jobs
+struct TileChunkRenderData {
+  TileChunkPtr tileChunk;
+  Vec3i tileChunkPosition;
+  Vec2f screenChunkPosition;
+
+  // Floors aren't sorted with entities, so they are drawn at once
+  sf::VertexArray floorVertices;
+  EntityListForRendering tilesForSorting;
+};
+
 // ----------------------
 
 
@@ -63,17 +80,19 @@ public:
   LevelRenderer();
 
   void setWindow(sf::RenderWindow* window) { this->window = window; }
-  void setTileSize(const float tileSizeInPixels) { this->tileSizeInPixels = tileSizeInPixels; }
   void setSpriteManager(SpriteManager* spriteManager) { this->spriteManager = spriteManager; }
 
-  void renderLevel(const LevelPtr& level, EntityPosition& cameraPosition);
+  // Snapshot has to stay untouched until the frame is drawn
+  void renderLevel(const RenderSnapshot& renderSnapshot);
   sf::Font* getFont() { return &font;}
+  TextCache* getTextCache() { return &textCache; }
 
   // returns index of sprite that should rendered for given tileState
   int getSpriteIndex(TILE_STATE tileState, int tileHash);
 
 private:
   sf::Font font;
+  TextCache textCache;
 
   float tileSizeInPixels;
   sf::RenderWindow* window;
@@ -81,27 +100,31 @@ private:
   Level* level;
 
   // Gets the position of an entity in the world
-  Vec2f getEntityPositionOnScreen(const EntityPtr& entity, EntityPosition& cameraPosition,
+  Vec2f getEntityPositionOnScreen(const EntityPosition& position, EntityPosition& cameraPosition,
 				  const Vec2i& tileChunkSize) const;
 
   // Getting the list of entities containing all the information to render them as well
   // as sort by their bottomY value
-  EntityListForRendering getEntityListForRendering(const EntityList& entityList,
+  EntityListForRendering getEntityListForRendering(const RenderSnapshot& renderSnapshot,
+						   const EntitySnapshotList& entityList,
 						   EntityPosition& cameraPosition,
 						   const Vec2i& tileChunkSize);
 
   // Renders Entities that are in bounds of a chunk that is rendered
   void renderSortedEntities(EntityListForRendering& entityListForRendering);
 
-  // Returns List Of RenderObjects For Tiles that have to be sorted for rendering and renders those who don't
-  EntityListForRendering renderTileChunk(const TileChunkPtr& tileChunk, const Vec2f& screenChunkPosition,
-					 const Vec3i& tileChunkPosition);
+  // Chunks visible in the last frame
+  std::vector<TileChunkRenderData> visibleTileChunks;
+
+  // Fills floor vertices and RenderObjects for tiles that have to be sorted,
+  // runs on job threads so it must not touch the window
+  void buildTileChunk(TileChunkRenderData& tileChunkRenderData, const sf::Vector2u& windowDimensions);
 
   EntityListForRendering renderTileMap(const TileMapPtr& tileMap, EntityPosition& cameraPosition);
 
   void renderEntity(const EntityRenderData* entityRenderData, Vec2f entityPositionOnScreen);
-  void renderEntities(const EntityList& entityList, EntityPosition& cameraPosition,
-		      const Vec2i& tileChunkSize);
+  void renderEntities(const RenderSnapshot& renderSnapshot, const EntitySnapshotList& entityList,
+		      EntityPosition& cameraPosition, const Vec2i& tileChunkSize);
 
   // Render list of previously filled spriteObjects
   void renderSprites(const SpriteList& spriteList);
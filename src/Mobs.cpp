@@ -1,4 +1,5 @@
 #include "Mobs.h"
+#include "ProjectileManager.h"
 #include <sstream>
 #include <iomanip>
 #include <iostream>
@@ -63,7 +64,7 @@ Mob::spawnXp(int xpToSpawn) const
     if(value > 50) value = 50;
     
     Entity* entity = new XpOrb(getCollisionCenter(), Vec2f::directionVector() * (1.0f + 0.25f * ((rand()%12) + 1)), value);
-    level->addEntity(EntityPtr(entity));
+    level->queueSpawn(EntityPtr(entity));
 
     //std::cout << "Spawning: " << value << " xp \n";
     xpToSpawn -= value;
@@ -84,10 +85,11 @@ Mob::getRenderData()
   return &renderData;
 }
 
-MobSpawner::MobSpawner(const EntityPosition& position, int level, MOB_TYPE mobType) : Mob(position, level), mobType(mobType)
+MobSpawner::MobSpawner(const EntityPosition& position, int level, MOB_TYPE mobType, float spawnTime) :
+  Mob(position, level), mobType(mobType), localTime(spawnTime)
 {
   dimensions = Vec2f(1.0f, 1.0f);
-  renderData.spriteName = "cannonBase";
+  renderData.spriteHandle = SPRITE_CANNON_BASE;
   
   std::stringstream caption;
   caption << "MobSpawner";
@@ -115,73 +117,86 @@ MobSpawner::MobSpawner(const EntityPosition& position, int level, MOB_TYPE mobTy
   health = maxHealth;
   damageValue = (level + 1.0f) / 5.0f;
 
-  localTime = (rand()%100000) / 100.0f;
-  
   renderData.spriteColor = Vec3f(138, 7, 7);
 }
 
-void
-MobSpawner::update(const float lastDelta)
+float
+MobSpawner::resumeBehaviour()
 {
+  // Distance to the player doesn't have to be checked every frame
+  static const float pollPeriod = 0.25f;
   float spawnPeriod = 10.0f - (mobLevel * 0.5f);
-  renderData.spriteColorAlpha = 0.2f + (localTime / spawnPeriod) * 0.8f;
-  
-  Player* player = level->getPlayer();
 
-  if(localTime < 0) localTime = 0;
-    
-  if(player)
+  BEHAVIOUR_BEGIN(spawnBehaviour);
+
+  while(true)
   {
-    
-    EntityPosition playerPosition = player->getCollisionCenter();
-    Vec2f distanceVec = EntityPosition::calculateDistanceInTiles(position, playerPosition,
-								       level->getTileMap()->getTileChunkSize());
-    // If There's Player in Radius of given length 
-    if(distanceVec.getLength() < 15.0f)
+    BEHAVIOUR_SLEEP(spawnBehaviour, pollPeriod);
+
+    Player* player = level->getPlayer();
+    bool isPlayerClose = false;
+    if(player)
     {
-      localTime += lastDelta;
-      if(localTime >= spawnPeriod)
-      {      
-	localTime = fmodf(localTime, spawnPeriod);
-	distanceVec.normalize();
-	
-	Entity* entity;
-	do {
-	  Vec2f directionVec = Vec2f::directionVector();
-	  switch(mobType)
-	  {
-	  case MT_RAT:
-	    entity = new Rat(position + directionVec * 2.0f,
-			     mobLevel);
-	    break;
-	  case MT_SNAKE:
-	    entity = new Snake(position + directionVec * 2.0f,
-			       mobLevel);
-	    break;
-	  case MT_FOLLOWER:
-	    entity = new Follower(position + directionVec * 2.0f,
-				  mobLevel);
-	    break;
-	  case MT_VARIOUS:
-	    if(rand()%3 == 0)
-	      entity = new Rat(position + directionVec * 2.0f, mobLevel);
-	    else if(rand()%3 == 1)
-	      entity = new Snake(position + directionVec * 2.0f, mobLevel);
-	    else
-	      entity = new Follower(position + directionVec * 2.0f, mobLevel);
-	    break;
-	  }
-	  
-	} while(!level->addEntity(EntityPtr(entity)));
-	
-      }
+      EntityPosition playerPosition = player->getCollisionCenter();
+      Vec2f distanceVec = EntityPosition::calculateDistanceInTiles(position, playerPosition,
+								   level->getTileMap()->getTileChunkSize());
+      // If There's Player in Radius of given length
+      isPlayerClose = distanceVec.getLength() < 15.0f;
     }
-    else localTime -= lastDelta;
-    
+
+    // Charge is lost while he's away
+    localTime += isPlayerClose ? pollPeriod : -pollPeriod;
+    if(localTime < 0) localTime = 0;
+
+    if(localTime >= spawnPeriod)
+    {
+      localTime = fmodf(localTime, spawnPeriod);
+      spawnMob();
+    }
+
+    renderData.spriteColorAlpha = 0.2f + (localTime / spawnPeriod) * 0.8f;
   }
-  else localTime -= lastDelta;
-} 
 
+  BEHAVIOUR_END(spawnBehaviour);
+}
+
+void
+MobSpawner::spawnMob()
+{
+  Entity* entity;
+  do {
+    Vec2f directionVec = Vec2f::directionVector();
+    EntityPosition spawnPosition = position + directionVec * 2.0f;
+
+    MOB_TYPE spawnedType = mobType;
+    if(mobType == MT_VARIOUS)
+    {
+      if(rand()%3 == 0)
+	spawnedType = MT_RAT;
+      else if(rand()%3 == 1)
+	spawnedType = MT_SNAKE;
+      else
+	spawnedType = MT_FOLLOWER;
+    }
+
+    switch(spawnedType)
+    {
+    case MT_RAT:
+      {
+	Vec2f wanderDirection = Vec2f::directionVector();
+	float wanderTime = Rat::getRandomWanderTime();
+	entity = new Rat(spawnPosition, mobLevel, wanderDirection, wanderTime);
+      } break;
+    case MT_SNAKE:
+      entity = new Snake(spawnPosition, mobLevel, Snake::getRandomDirection());
+      break;
+    default:
+      entity = new Follower(spawnPosition, mobLevel);
+      break;
+    }
+
+  } while(!level->addEntity(EntityPtr(entity)));
+}
 
 void
 MobSpawner::performDeathAction()
@@ -193,7 +208,7 @@ MobSpawner::performDeathAction()
 Cannon::Cannon(const EntityPosition& position, int level) : Mob(position, level)
 {
   dimensions = Vec2f(1.0f, 1.0f);
-  renderData.spriteName = "cannonBase";
+  renderData.spriteHandle = SPRITE_CANNON_BASE;
   
   std::stringstream caption;
   caption << "Cannon lvl: " << level;  
@@ -205,49 +220,60 @@ Cannon::Cannon(const EntityPosition& position, int level) : Mob(position, level)
 }
 
 void
-Cannon::update(const float lastDelta)
+Cannon::think(const float elapsedTime)
+{
+  Player* player = level->getPlayer();
+  canSeePlayer = player && level->canSeeEachOther(this, player, 15.0f);
+}
+
+float
+Cannon::resumeBehaviour()
 {
   float shootPeriod = 5.0f / mobLevel;
-  localTime += lastDelta;
 
-  if(localTime >= shootPeriod)
+  BEHAVIOUR_BEGIN(shootBehaviour);
+
+  while(true)
   {
-    localTime = fmodf(localTime, shootPeriod);
-    Player* player = level->getPlayer();
-    
-    if(player && level->canSeeEachOther(this, player, 15.0f))
-    {
-      
-      EntityPosition playerPosition = player->getCollisionCenter();
-      Vec2f distanceVec = EntityPosition::calculateDistanceInTiles(position, playerPosition,
-									 level->getTileMap()->getTileChunkSize());
-      // If There's Player in Radius of given length 
-      if(distanceVec.getLength() < 15.0f)
-      {
-	distanceVec.normalize();
-	Vec2f directionVec = distanceVec;
-	
-	float bulletRadius = 0.7f + mobLevel / 10;
-	
-	float bulletSpeedModifier = (mobLevel / 10.0f) + 1.0f; 
-	
-	Entity* bullet;
-	bullet = new Bullet(position + directionVec * 2.0f,
-			    directionVec * 10.0f * bulletSpeedModifier,
-			    Vec2f(bulletRadius, bulletRadius),
-			    damageValue);
-	
-	level->addEntity(EntityPtr(bullet));
-      }
-      
-    }
-  } 
+    BEHAVIOUR_SLEEP(shootBehaviour, shootPeriod);
+    shoot();
+  }
+
+  BEHAVIOUR_END(shootBehaviour);
+}
+
+void
+Cannon::shoot()
+{
+  Player* player = level->getPlayer();
+  if(!player || !canSeePlayer) return;
+
+  EntityPosition playerPosition = player->getCollisionCenter();
+  Vec2f distanceVec = EntityPosition::calculateDistanceInTiles(position, playerPosition,
+							       level->getTileMap()->getTileChunkSize());
+  // If There's Player in Radius of given length
+  if(distanceVec.getLength() < 15.0f)
+  {
+    distanceVec.normalize();
+    Vec2f directionVec = distanceVec;
+
+    float bulletRadius = 0.7f + mobLevel / 10;
+
+    float bulletSpeedModifier = (mobLevel / 10.0f) + 1.0f;
+
+    Projectile bullet(position + directionVec * 2.0f,
+		      directionVec * 10.0f * bulletSpeedModifier,
+		      Vec2f(bulletRadius, bulletRadius),
+		      damageValue);
+
+    level->spawnProjectile(bullet);
+  }
 }
 
 Follower::Follower(const EntityPosition& position, int level) : Mob(position, level)
 {
   dimensions = Vec2f(1.0f, 2.0f);
-  renderData.spriteName = "followerBase";
+  renderData.spriteHandle = SPRITE_FOLLOWER_BASE;
   
   std::stringstream caption;
   caption << "Follower lvl: " << level;  
@@ -259,11 +285,24 @@ Follower::Follower(const EntityPosition& position, int level) : Mob(position, le
 }
 
 void
-Follower::update(const float lastDelta)
+Follower::think(const float elapsedTime)
 {
-
   Player* player = level->getPlayer();
-  if(player && level->canSeeEachOther(this, player, 15.0f))
+  FlowFieldSample pathSample = level->samplePlayerFlowField(getCollisionCenter());
+
+  // Walking around walls along the shared field, straight at him once he's next to me
+  if(player && pathSample.distance > 1 && pathSample.distance < 15)
+  {
+    acceleration = pathSample.direction;
+    isChasing = true;
+    roomPath.clear();
+  }
+  // He's out of the field's reach, the rooms lead to him
+  else if(player && isChasing && pathSample.distance == -1)
+  {
+    isChasing = followRoomPath(player->getCollisionCenter(), elapsedTime);
+  }
+  else if(player && level->canSeeEachOther(this, player, 15.0f))
   {
     EntityPosition playerPosition = player->getCollisionCenter();
     EntityPosition followerPosition = getCollisionCenter();
@@ -276,17 +315,60 @@ Follower::update(const float lastDelta)
       distanceVec.normalize();
       Vec2f directionVec = distanceVec;
       acceleration = directionVec;
+      isChasing = true;
     }
   }
+}
 
-  EntityPosition collisionCenter = getCollisionCenter();
-  float friction = level->getFrictionValueAtPosition(collisionCenter);
-  float accelerationModifier  = level->getAccelerationModifierAtPosition(collisionCenter);
-  
-  Vec2f positionDeltaVec = getPositionDeltaVec(lastDelta, friction, accelerationModifier);
+bool
+Follower::followRoomPath(const EntityPosition& playerPosition, float elapsedTime)
+{
+  // He keeps moving, but searching the rooms every decision isn't needed
+  static const float repathPeriod = 2.0f;
+  // Gives up when he got too far away
+  static const int32 maxPathLength = 80;
+
+  timeSinceRoomPath += elapsedTime;
+  if(roomPath.empty() || timeSinceRoomPath >= repathPeriod)
+  {
+    timeSinceRoomPath = 0;
+    roomPathIndex = 0;
+
+    if(!level->findPath(getCollisionCenter(), playerPosition, roomPath) ||
+       (int32)roomPath.size() > maxPathLength)
+    {
+      roomPath.clear();
+      return false;
+    }
+  }
+
+  // Skipping tiles whose center was already reached
+  EntityPosition followerPosition = getCollisionCenter();
+  Vec2f tileCenterOffset(0.5f, 0.5f);
+  Vec2f tileVec;
+  for(; roomPathIndex < (int32)roomPath.size(); roomPathIndex++)
+  {
+    EntityPosition tileCenter(roomPath[roomPathIndex], tileCenterOffset);
+    tileVec = EntityPosition::calculateDistanceInTiles(followerPosition, tileCenter,
+						       level->getTileMap()->getTileChunkSize());
+    if(tileVec.getLength() > 0.5f) break;
+  }
+
+  if(roomPathIndex == (int32)roomPath.size())
+  {
+    roomPath.clear();
+    return false;
+  }
+
+  tileVec.normalize();
+  acceleration = tileVec;
+  return true;
+}
 
-  EntityCollisionResult collisionResult = level->checkCollisions(this, positionDeltaVec);
-  handleCollisionResult(collisionResult, positionDeltaVec);
+void
+Follower::update(const float lastDelta)
+{
+  integrateMovement(lastDelta);
 }
 
 FloatRect
@@ -308,18 +390,19 @@ Follower::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
 {
   if(entity->isPlayer())
   {
-    entity->addHealth(-damageValue);
-    entity->addVelocity(velocity * 2.5f);
+    level->queueHealthChange(entity, -damageValue);
+    level->queueImpulse(entity, velocity * 2.5f);
   }
-  else entity->addVelocity(velocity * 0.5f);
+  else level->queueImpulse(entity, velocity * 0.5f);
 
   velocity = getReflectedVelocity(collisionPlane, 0.5f);
 }
 
-Snake::Snake(const EntityPosition& position, int level) : Mob(position, level)
+Snake::Snake(const EntityPosition& position, int level, const Vec2f& direction) :
+  Mob(position, level), currentDirection(direction)
 {
   dimensions = Vec2f(1.0f, 1.0f);
-  renderData.spriteName = "snakeBase";
+  renderData.spriteHandle = SPRITE_SNAKE_BASE;
   
   std::stringstream caption;
   caption << "Snake lvl: " << level;  
@@ -329,15 +412,12 @@ Snake::Snake(const EntityPosition& position, int level) : Mob(position, level)
   health = maxHealth;
   damageValue = (level + 1.0f) / 5.0f;
   
-  currentDirection = Vec2f::cardinalDirection((CARDINAL_DIRECTION)(rand()%4));
   metersPerSecondSquared = idleSpeedValue;
-  localAttackingTime = 0;
 }
 
 void
-Snake::update(const float lastDelta)
+Snake::think(const float elapsedTime)
 {
-
   Player* player = level->getPlayer();
   if(player && metersPerSecondSquared != attackSpeedValue)
   {
@@ -347,31 +427,40 @@ Snake::update(const float lastDelta)
       velocity = 0;
       currentDirection = checkResult;
       metersPerSecondSquared = attackSpeedValue;
+      attackCount++;
     }
   }
+}
 
-  if(metersPerSecondSquared == attackSpeedValue)
-  {
-    localAttackingTime += lastDelta;
-  }
-
+float
+Snake::resumeBehaviour()
+{
   static const float maxAttackingTime = 2.0f;
-  if(localAttackingTime > maxAttackingTime)
+  // Think notices the player at most this often anyway
+  static const float attackPollPeriod = 0.1f;
+
+  BEHAVIOUR_BEGIN(attackBehaviour);
+
+  while(true)
   {
-    localAttackingTime = 0;
-    metersPerSecondSquared = idleSpeedValue;
+    BEHAVIOUR_WAIT_UNTIL(attackBehaviour, metersPerSecondSquared == attackSpeedValue, attackPollPeriod);
+
+    timedAttack = attackCount;
+    BEHAVIOUR_SLEEP(attackBehaviour, maxAttackingTime);
+
+    // A hit may have ended it already, an attack started since then is timed from here
+    if(attackCount == timedAttack) metersPerSecondSquared = idleSpeedValue;
   }
-  
+
+  BEHAVIOUR_END(attackBehaviour);
+}
+
+void
+Snake::update(const float lastDelta)
+{
   acceleration = currentDirection;
   
-  EntityPosition collisionCenter = getCollisionCenter();
-  float friction = level->getFrictionValueAtPosition(collisionCenter);
-  float accelerationModifier  = level->getAccelerationModifierAtPosition(collisionCenter);
-  
-  Vec2f positionDeltaVec = getPositionDeltaVec(lastDelta, friction, accelerationModifier);
-
-  EntityCollisionResult collisionResult = level->checkCollisions(this, positionDeltaVec);
-  handleCollisionResult(collisionResult, positionDeltaVec);
+  integrateMovement(lastDelta);
 }
 
 FloatRect
@@ -399,8 +488,8 @@ Snake::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
 {
 
   if(entity->isPlayer())
-    entity->addHealth(-damageValue);
-  entity->addVelocity(velocity * 2.5f);
+    level->queueHealthChange(entity, -damageValue);
+  level->queueImpulse(entity, velocity * 2.5f);
   
   //velocity = getReflectedVelocity(collisionPlane, 0.5f);
   velocity = 0;
@@ -414,10 +503,11 @@ Snake::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
 }
 
 
-Rat::Rat(const EntityPosition& position, int level) : Mob(position, level)
+Rat::Rat(const EntityPosition& position, int level, const Vec2f& wanderDirection, float wanderTime) :
+  Mob(position, level), wanderDirection(wanderDirection), firstWanderTime(wanderTime)
 {
   dimensions = Vec2f(1.0f, 1.0f);
-  renderData.spriteName = "ratBase";
+  renderData.spriteHandle = SPRITE_RAT_BASE;
   
   std::stringstream caption;
   caption << "Rat lvl: " << level;  
@@ -427,19 +517,14 @@ Rat::Rat(const EntityPosition& position, int level) : Mob(position, level)
   health = maxHealth;
   damageValue = 1.0f + ((mobLevel - 1.0f) * 2.0f);
   
-  currentDirection = Vec2f::directionVector();
-  
   metersPerSecondSquared = 10.0f;
-  ratState = RS_SNIFFING;
-  localStateTime = 2.0f + (rand()%5) * 0.5f;
-  
 }
 
 void
-Rat::update(const float lastDelta)
+Rat::think(const float elapsedTime)
 {
   bool dying = (health / maxHealth)  < 0.2f;
-  bool shouldUpdateState = true;
+  isReactingToPlayer = false;
   
   Player* player = level->getPlayer();
   // If There's player in close Proximity
@@ -453,61 +538,56 @@ Rat::update(const float lastDelta)
     // I either move towards him
     if(distanceVec.getLength() < 4.0f + (mobLevel * 0.5f) && !dying)
     {
-      distanceVec.normalize();
-      currentDirection = distanceVec;
-      shouldUpdateState = false;
+      // Going around corners along the shared field until he's next to me
+      FlowFieldSample pathSample = level->samplePlayerFlowField(followerPosition);
+      if(pathSample.distance > 1) currentDirection = pathSample.direction;
+      else
+      {
+	distanceVec.normalize();
+	currentDirection = distanceVec;
+      }
+      isReactingToPlayer = true;
     }
     // Or go Away from him if I'm dying
     else if(dying)
     {
       distanceVec.normalize();
       currentDirection = distanceVec * -1.0f;
-      shouldUpdateState = false;
+      isReactingToPlayer = true;
     }
   }
-  
-  if(shouldUpdateState)
+}
+
+float
+Rat::resumeBehaviour()
+{
+  BEHAVIOUR_BEGIN(wanderBehaviour);
+
+  // Direction it was created with comes first
+  BEHAVIOUR_SLEEP(wanderBehaviour, firstWanderTime);
+
+  while(true)
   {
-    localStateTime -= lastDelta;
-    if(localStateTime < 0)
+    // Sniffing in new directions until it's time to think
+    while(rand()%3 != 0)
     {
-      switch(ratState)
-      {
-      case RS_SNIFFING:
-	{
-	  // Going into thinking state
-	  if(rand()%3 == 0)
-	  {
-	    localStateTime = 0.5f + (rand()%5) * 0.2f;
-	    ratState = RS_THINKING;
-	    currentDirection = Vec2f();
-	  }
-	  // Still Sniffing
-	  else
-	  {
-	    localStateTime = 2.0f + (rand()%5) * 0.5f;
-	    currentDirection = Vec2f::directionVector();
-	  }
-	} break;
-      case RS_THINKING:
-	{
-	  localStateTime = 2.0f + (rand()%5) * 0.5f;
-	  ratState = RS_SNIFFING;
-	} break;
-      }
+      wanderDirection = Vec2f::directionVector();
+      BEHAVIOUR_SLEEP(wanderBehaviour, getRandomWanderTime());
     }
+
+    wanderDirection = Vec2f();
+    BEHAVIOUR_SLEEP(wanderBehaviour, 0.5f + (rand()%5) * 0.2f);
   }
 
-  acceleration = currentDirection;
-  
-  EntityPosition collisionCenter = getCollisionCenter();
-  float friction = level->getFrictionValueAtPosition(collisionCenter);
-  float accelerationModifier  = level->getAccelerationModifierAtPosition(collisionCenter);
-  
-  Vec2f positionDeltaVec = getPositionDeltaVec(lastDelta, friction, accelerationModifier);
+  BEHAVIOUR_END(wanderBehaviour);
+}
 
-  EntityCollisionResult collisionResult = level->checkCollisions(this, positionDeltaVec);
-  handleCollisionResult(collisionResult, positionDeltaVec);
+void
+Rat::update(const float lastDelta)
+{
+  acceleration = isReactingToPlayer ? currentDirection : wanderDirection;
+  
+  integrateMovement(lastDelta);
 }
 
 FloatRect
@@ -522,11 +602,18 @@ void
 Rat::onWorldCollision(COLLISION_PLANE collisionPlane)
 {
   velocity = getReflectedVelocity(collisionPlane, 1.0f);
+
+  // Both bounce off, otherwise a wandering rat keeps walking into the wall
   if(collisionPlane == COLLISION_PLANE_VERTICAL)
   {
     currentDirection.x *= -1.0f;
+    wanderDirection.x *= -1.0f;
+  }
+  else
+  {
+    currentDirection.y *= -1.0f;
+    wanderDirection.y *= -1.0f;
   }
-  else currentDirection.y *= -1.0f;
 }
 
 void
@@ -535,12 +622,12 @@ Rat::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
 
   if(entity->isPlayer())
   {
-    entity->addHealth(-damageValue);
-    entity->addVelocity(velocity * 2.5f);
+    level->queueHealthChange(entity, -damageValue);
+    level->queueImpulse(entity, velocity * 2.5f);
   }
   else
   {
-    entity->addVelocity(velocity * 1.5f);
+    level->queueImpulse(entity, velocity * 1.5f);
   }
   
   //velocity = getReflectedVelocity(collisionPlane, 0.5f);
@@ -551,7 +638,7 @@ Rat::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
 Player::Player(const EntityPosition& position) : Mob(position, 1, 1.0f)
 {
   dimensions = Vec2f(1.0f, 2.0f);
-  renderData.spriteName = "playerBase";
+  renderData.spriteHandle = SPRITE_PLAYER_BASE;
   renderData.caption = "Player";
   
   damageValue = 1.0f;
@@ -560,14 +647,7 @@ Player::Player(const EntityPosition& position) : Mob(position, 1, 1.0f)
 void
 Player::update(const float lastDelta)
 {
-  EntityPosition collisionCenter = getCollisionCenter();
-  float friction = level->getFrictionValueAtPosition(collisionCenter);
-  float accelerationModifier  = level->getAccelerationModifierAtPosition(collisionCenter);
-  
-  Vec2f positionDeltaVec = getPositionDeltaVec(lastDelta, friction, accelerationModifier);
-  
-  EntityCollisionResult collisionResult = level->checkCollisions(this, positionDeltaVec);
-  handleCollisionResult(collisionResult, positionDeltaVec);
+  integrateMovement(lastDelta);
   
   if(xpAmount >= getNextLevelXp()) levelUp();
   
@@ -588,7 +668,7 @@ void
 Player::onEntityCollision(COLLISION_PLANE collisionPlane, Entity* entity)
 {
   static const float speedIncrease = 1.05f;
-  entity->addVelocity(velocity * 0.01f);
+  level->queueImpulse(entity, velocity * 0.01f);
   
   velocity = getReflectedVelocity(collisionPlane, speedIncrease);
 }
@@ -690,12 +770,12 @@ Player::handlePlayerInput(const PlayerInput& playerInput)
     if(playerInput.actionRight || playerInput.actionLeft)
       bulletPosition -= Vec2f(0, 1.0f);
     
-    Entity* bullet = new Bullet(bulletPosition,
-				velocity + tempDirectionVec * bulletVelocity,
-				Vec2f(bulletRadius, bulletRadius),
-				damageValue);
+    Projectile bullet(bulletPosition,
+		      velocity + tempDirectionVec * bulletVelocity,
+		      Vec2f(bulletRadius, bulletRadius),
+		      damageValue);
       
-    if(stamina > 20 && level->addEntity(EntityPtr(bullet))) stamina -= 20;
+    if(stamina > 20 && level->spawnProjectile(bullet)) stamina -= 20;
 
     //spawnDustParticles(getCollisionCenter(), 10, 10);
   }
@@ -37,38 +37,83 @@ enum MOB_TYPE{
 
 class MobSpawner : public Mob {
 public:
-  MobSpawner(const EntityPosition& position, int level, MOB_TYPE mobType);
-  void update(const float lastDelta);
+  // Random values are passed in, so whoever creates the mob decides when they're drawn
+  MobSpawner(const EntityPosition& position, int level, MOB_TYPE mobType, float spawnTime);
+
+  static float getRandomSpawnTime() { return (rand()%100000) / 100.0f; }
+
+  // Everything it does happens in its behaviour
+  void update(const float lastDelta) {}
+
+  // Charging up while the player is close and spawning once it's charged
+  bool hasBehaviour() const { return true; }
+  float resumeBehaviour();
 
   void performDeathAction();
 private:
   MOB_TYPE mobType;
   float localTime = 0;
+
+  BehaviourState spawnBehaviour;
+  void spawnMob();
 };
 
 class Cannon : public Mob {
 public:
   Cannon(const EntityPosition& position, int level);
-  void update(const float lastDelta);
+
+  // Everything it does happens in think and its behaviour
+  void update(const float lastDelta) {}
+
+  void think(const float elapsedTime);
+  AI_TYPE getAIType() const { return AI_CANNON; }
+
+  // Shooting at the player every shoot period while it can see him
+  bool hasBehaviour() const { return true; }
+  float resumeBehaviour();
 
 private:
-  float localTime = 0;
+  bool canSeePlayer = false;
+
+  BehaviourState shootBehaviour;
+  void shoot();
 };
 
 class Follower : public Mob {
 public:
   Follower(const EntityPosition& position, int level);
   void update(const float lastDelta);
+
+  void think(const float elapsedTime);
+  AI_TYPE getAIType() const { return AI_FOLLOWER; }
   FloatRect getCollisionRect() const;
 
   void onWorldCollision(COLLISION_PLANE worldCollisionType);
   void onEntityCollision(COLLISION_PLANE worldCollisionType, Entity* entity);
+private:
+  // Once it noticed the player it follows him through the rooms when he leaves the flow field
+  bool isChasing = false;
+  TilePath roomPath;
+  int32 roomPathIndex = 0;
+  float timeSinceRoomPath = 0;
+
+  // Sets acceleration towards the next tile of the path, false when there's no path to him
+  bool followRoomPath(const EntityPosition& playerPosition, float elapsedTime);
 };
 
 class Snake : public Mob {
 public:
-  Snake(const EntityPosition& position, int level);
+  Snake(const EntityPosition& position, int level, const Vec2f& direction);
+
+  static Vec2f getRandomDirection() { return Vec2f::cardinalDirection((CARDINAL_DIRECTION)(rand()%4)); }
   void update(const float lastDelta);
+
+  void think(const float elapsedTime);
+  AI_TYPE getAIType() const { return AI_SNAKE; }
+
+  // Calms down some time after think started an attack
+  bool hasBehaviour() const { return true; }
+  float resumeBehaviour();
   FloatRect getCollisionRect() const;
 
   void onWorldCollision(COLLISION_PLANE worldCollisionType);
@@ -77,27 +122,38 @@ private:
   Vec2f currentDirection;
   const float attackSpeedValue = 50.0f;
   const float idleSpeedValue = 10.0f;
-  float localAttackingTime;
-};
 
-enum RAT_STATE {
-  RS_SNIFFING,
-  RS_THINKING,
-  RS_ATTACKING
+  BehaviourState attackBehaviour;
+  // Counts attacks started by think, so the behaviour knows if the one it timed is still going
+  int32 attackCount = 0;
+  int32 timedAttack = 0;
 };
 
 class Rat : public Mob {
 public:
-  Rat(const EntityPosition& position, int level);
+  Rat(const EntityPosition& position, int level, const Vec2f& wanderDirection, float wanderTime);
+
+  static float getRandomWanderTime() { return 2.0f + (rand()%5) * 0.5f; }
   void update(const float lastDelta);
+
+  void think(const float elapsedTime);
+  AI_TYPE getAIType() const { return AI_RAT; }
+
+  // Sniffing around in random directions with pauses for thinking
+  bool hasBehaviour() const { return true; }
+  float resumeBehaviour();
   FloatRect getCollisionRect() const;
 
   void onWorldCollision(COLLISION_PLANE worldCollisionType);
   void onEntityCollision(COLLISION_PLANE worldCollisionType, Entity* entity);
 private:
-  RAT_STATE ratState;
+  // Set by think while the player makes me chase him or run away
+  bool isReactingToPlayer = false;
   Vec2f currentDirection;
-  float localStateTime;
+
+  BehaviourState wanderBehaviour;
+  Vec2f wanderDirection;
+  float firstWanderTime;
 };
 
 enum PLAYER_UPGRADE {
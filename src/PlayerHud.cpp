@@ -3,149 +3,237 @@
 #include <sstream>
 #include <iomanip>
 
+static void
+appendRectangle(sf::VertexArray& vertexArray, const Vec2f& position, const Vec2f& dimensions,
+		const sf::Color& color)
+{
+  vertexArray.append(sf::Vertex(sf::Vector2f(position.x, position.y), color));
+  vertexArray.append(sf::Vertex(sf::Vector2f(position.x + dimensions.x, position.y), color));
+  vertexArray.append(sf::Vertex(sf::Vector2f(position.x + dimensions.x, position.y + dimensions.y), color));
+  vertexArray.append(sf::Vertex(sf::Vector2f(position.x, position.y + dimensions.y), color));
+}
+
+// Outline grows outwards like in sf::RectangleShape
+static void
+appendOutline(sf::VertexArray& vertexArray, const Vec2f& position, const Vec2f& dimensions,
+	      float thickness, const sf::Color& color)
+{
+  appendRectangle(vertexArray, position - Vec2f(thickness, thickness),
+		  Vec2f(dimensions.x + thickness * 2, thickness), color);
+  appendRectangle(vertexArray, position + Vec2f(-thickness, dimensions.y),
+		  Vec2f(dimensions.x + thickness * 2, thickness), color);
+  appendRectangle(vertexArray, position - Vec2f(thickness, 0),
+		  Vec2f(thickness, dimensions.y), color);
+  appendRectangle(vertexArray, position + Vec2f(dimensions.x, 0),
+		  Vec2f(thickness, dimensions.y), color);
+}
+
+void PlayerHudStats::capture(const Player* player)
+{
+  mobLevel = player->getMobLevel();
+  skillPoints = player->getSkillPoints();
+
+  shieldValue = player->getShieldValue();
+  damageValue = player->getDamageValue();
+  movementSpeed = player->getMovementSpeed();
+  bulletVelocity = player->getBulletVelocity();
+
+  health = player->getHealth();
+  maxHealth = player->getMaxHealth();
+  stamina = player->getStamina();
+  maxStamina = player->getMaxStamina();
+
+  xp = player->getXp();
+  currentLevelXp = player->getCurrentLevelXp();
+  nextLevelXp = player->getNextLevelXp();
+}
+
 void PlayerHud::render(const Player* player)
+{
+  PlayerHudStats playerHudStats;
+  playerHudStats.capture(player);
+  render(playerHudStats);
+}
+
+void PlayerHud::render(const PlayerHudStats& stats)
 {
   const sf::Vector2u windowDimensions = window->getSize();
+  
+  // Everything is positioned relative to the window
+  bool rebuildAll = !isBuilt || windowDimensions != lastWindowDimensions;
 
-  Vec2f panelDimensions(windowDimensions.x * 0.20f, windowDimensions.y * 0.6f);
-  Vec2f panelPosition(windowDimensions.x - panelDimensions.x - 2.0f, 2.0f);
+  if(rebuildAll ||
+     stats.mobLevel != lastStats.mobLevel ||
+     stats.skillPoints != lastStats.skillPoints ||
+     stats.shieldValue != lastStats.shieldValue ||
+     stats.damageValue != lastStats.damageValue ||
+     stats.movementSpeed != lastStats.movementSpeed ||
+     stats.bulletVelocity != lastStats.bulletVelocity ||
+     stats.health != lastStats.health ||
+     stats.stamina != lastStats.stamina)
+  {
+    rebuildPanel(stats, windowDimensions);
+  }
+
+  Vec2f renderBarDimensions = getBarDimensions(windowDimensions);
+  std::stringstream tempText;
   
-  sf::RectangleShape rectangleShape(sf::Vector2f(panelDimensions.x, panelDimensions.y));
-  rectangleShape.setPosition(panelPosition.x, panelPosition.y);
-  rectangleShape.setOutlineThickness(2.0f);
-  rectangleShape.setFillColor(sf::Color(255, 255, 255, 128));
-  rectangleShape.setOutlineColor(sf::Color(0,0,0, 128));
+  if(rebuildAll ||
+     stats.health != lastStats.health ||
+     stats.maxHealth != lastStats.maxHealth)
+  {
+    tempText << stats.health << " / " << stats.maxHealth;
+    rebuildBar(HS_HEALTH_BAR, stats.health / stats.maxHealth, sf::Color::Red,
+	       getBarPosition(HS_HEALTH_BAR, windowDimensions), renderBarDimensions, tempText.str());
+  }
+
+  if(rebuildAll ||
+     stats.stamina != lastStats.stamina ||
+     stats.maxStamina != lastStats.maxStamina)
+  {
+    tempText.str("");
+    tempText << stats.stamina << " / " << stats.maxStamina;
+    rebuildBar(HS_STAMINA_BAR, stats.stamina / stats.maxStamina, sf::Color::Yellow,
+	       getBarPosition(HS_STAMINA_BAR, windowDimensions), renderBarDimensions, tempText.str());
+  }
+
+  if(rebuildAll ||
+     stats.xp != lastStats.xp ||
+     stats.currentLevelXp != lastStats.currentLevelXp ||
+     stats.nextLevelXp != lastStats.nextLevelXp)
+  {
+    float fillPercentage = (stats.xp - stats.currentLevelXp);
+    fillPercentage /= (stats.nextLevelXp - stats.currentLevelXp);
+    
+    tempText.str("");
+    tempText << stats.xp << " / " << stats.nextLevelXp;
+    rebuildBar(HS_XP_BAR, fillPercentage, sf::Color::Green,
+	       getBarPosition(HS_XP_BAR, windowDimensions), renderBarDimensions, tempText.str());
+  }
+
+  lastStats = stats;
+  lastWindowDimensions = windowDimensions;
+  isBuilt = true;
+
+  for(int i = 0; i < HS_COUNT; i++)
+  {
+    const HudSection& hudSection = hudSections[i];
+    window->draw(hudSection.shapeVertices);
+    
+    if(hudSection.textVertices.getVertexCount())
+    {
+      window->draw(hudSection.textVertices, &textCache->getTexture(hudSection.characterSize));
+    }
+  }
+}
+
+void PlayerHud::rebuildPanel(const PlayerHudStats& stats, const sf::Vector2u& windowDimensions)
+{
+  HudSection& hudSection = hudSections[HS_PANEL];
+  hudSection.shapeVertices.clear();
+  hudSection.textVertices.clear();
+  hudSection.characterSize = 24;
+  rebuildCount++;
   
-  window->draw(rectangleShape);
+  Vec2f panelDimensions(windowDimensions.x * 0.20f, windowDimensions.y * 0.6f);
+  Vec2f panelPosition(windowDimensions.x - panelDimensions.x - 2.0f, 2.0f);
+
+  appendRectangle(hudSection.shapeVertices, panelPosition, panelDimensions, sf::Color(255, 255, 255, 128));
+  appendOutline(hudSection.shapeVertices, panelPosition, panelDimensions, 2.0f, sf::Color(0, 0, 0, 128));
   
   Vec2f textPos = panelPosition + Vec2f(20.0f, 20.0f);
-  int skillPoints = player->getSkillPoints();
+  int skillPoints = stats.skillPoints;
 
   std::stringstream tempText;
   tempText << std::fixed << std::setw(11) << std::setprecision(2);
   
-  tempText << "Level " << player->getMobLevel();
-  textPos = renderText(tempText.str(), textPos, sf::Color::Black);
+  tempText << "Level " << stats.mobLevel;
+  textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
   
   tempText.str(""); 
-  tempText << "Shield: " << player->getShieldValue();
+  tempText << "Shield: " << stats.shieldValue;
   if(skillPoints) tempText << " (1 - ^)";
-  textPos = renderText(tempText.str(), textPos, sf::Color::Black);
+  textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
   
   tempText.str(""); 
-  tempText << "DamageValue: " << player->getDamageValue();
+  tempText << "DamageValue: " << stats.damageValue;
   if(skillPoints) tempText << " (2 - ^)";
-  textPos = renderText(tempText.str(), textPos,  sf::Color::Black);
+  textPos = appendText(hudSection, tempText.str(), textPos,  sf::Color::Black);
   
   tempText.str(""); 
-  tempText << "MoveSpeed: " << player->getMovementSpeed();
+  tempText << "MoveSpeed: " << stats.movementSpeed;
   if(skillPoints) tempText << " (3 - ^)";
-  textPos = renderText(tempText.str(), textPos, sf::Color::Black);
+  textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
     
   tempText.str(""); 
-  tempText << "BulletSpeed: " << player->getBulletVelocity();
+  tempText << "BulletSpeed: " << stats.bulletVelocity;
   if(skillPoints) tempText << " (4 - ^)";
-  textPos = renderText(tempText.str(), textPos, sf::Color::Black);
+  textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
       
   tempText.str(""); 
-  tempText << "Health: " << player->getHealth();
+  tempText << "Health: " << stats.health;
   if(skillPoints) tempText << " (5 - ^)";
-  textPos = renderText(tempText.str(), textPos, sf::Color::Black);
-        
+  textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
+	
   tempText.str(""); 
-  tempText << "Stamina: " << player->getStamina();
+  tempText << "Stamina: " << stats.stamina;
   if(skillPoints) tempText << " (6 - ^)";
-  textPos = renderText(tempText.str(), textPos, sf::Color::Black);
+  textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
   
   if(skillPoints != 0)
   {
     tempText.str(""); 
     tempText << "SkillPoints: " << skillPoints;
-    textPos = renderText(tempText.str(), textPos, sf::Color::Black);
+    textPos = appendText(hudSection, tempText.str(), textPos, sf::Color::Black);
   }
-  
-  Vec2f renderBarDimensions(windowDimensions.x * 0.3f, 25.0f);
-  Vec2f renderBarPosition(windowDimensions.x - renderBarDimensions.x - 2.0f,
-			     windowDimensions.y - (renderBarDimensions.y * 5));
-  
-  float fillPercentage = player->getHealth()/player->getMaxHealth();
-  tempText.str("");
-  tempText << player->getHealth() << " / " << player->getMaxHealth();
-  renderBarPosition = renderBar(fillPercentage, sf::Color::Red, renderBarPosition,
-				renderBarDimensions, tempText.str());
-
-  fillPercentage = player->getStamina()/player->getMaxStamina();
-  tempText.str("");
-  tempText << player->getStamina() << " / " << player->getMaxStamina();
-  renderBarPosition = renderBar(fillPercentage, sf::Color::Yellow, renderBarPosition,
-				renderBarDimensions, tempText.str());
-  
-  fillPercentage = (player->getXp() - player->getCurrentLevelXp());
-  fillPercentage /= (player->getNextLevelXp() - player->getCurrentLevelXp());
-  
-  tempText.str("");
-  tempText << player->getXp() << " / " << player->getNextLevelXp();
-  renderBarPosition = renderBar(fillPercentage, sf::Color::Green, renderBarPosition,
-				renderBarDimensions, tempText.str());
-  
 }
 
-Vec2f PlayerHud::renderText(const std::string& text, const Vec2f& textPos, const sf::Color& color,
-			       bool nextLine)
+void PlayerHud::rebuildBar(HUD_SECTION hudSectionIndex, float fillPercentage, const sf::Color& baseColor,
+			   const Vec2f& position, const Vec2f& dimensions, const std::string& text)
 {
-  
-  sf::Text tempText;
-  tempText.setFont(*font);
-  tempText.setString(text);
-  tempText.setCharacterSize(24.0f);
-  tempText.setPosition(textPos.x, textPos.y);
-  tempText.setColor(color);
-  
-  window->draw(tempText);
+  HudSection& hudSection = hudSections[hudSectionIndex];
+  hudSection.shapeVertices.clear();
+  hudSection.textVertices.clear();
+  hudSection.characterSize = 20;
+  rebuildCount++;
 
-  sf::FloatRect localTextBounds = tempText.getLocalBounds();
-  return textPos + Vec2f(0, localTextBounds.height * 2);
-}
-
-Vec2f PlayerHud::renderBar(float fillPercentage, const sf::Color& baseColor, const Vec2f& position,
-			      const Vec2f& dimensions, const std::string& text)
-{
-    
-  sf::RectangleShape rectangleShape(sf::Vector2f(dimensions.x, dimensions.y));
-  rectangleShape.setPosition(position.x, position.y);
-  rectangleShape.setOutlineThickness(2.0f);
-  rectangleShape.setFillColor(sf::Color(255, 255, 255, 128));
-  rectangleShape.setOutlineColor(sf::Color(0, 0, 0));
-  
-  window->draw(rectangleShape);
+  appendRectangle(hudSection.shapeVertices, position, dimensions, sf::Color(255, 255, 255, 128));
+  appendOutline(hudSection.shapeVertices, position, dimensions, 2.0f, sf::Color(0, 0, 0));
 
   if(fillPercentage > 1.0f) fillPercentage = 1.0f;
   
-  sf::Vector2f lifeBarDimensions((dimensions.x - 2)  * fillPercentage, dimensions.y - 2);
-  rectangleShape.setSize(lifeBarDimensions);
-  rectangleShape.setPosition(position.x + 1, position.y + 1);
-  rectangleShape.setOutlineThickness(0);
-  rectangleShape.setFillColor(baseColor);
-  
-  window->draw(rectangleShape);
+  Vec2f lifeBarDimensions((dimensions.x - 2)  * fillPercentage, dimensions.y - 2);
+  appendRectangle(hudSection.shapeVertices, position + Vec2f(1, 1), lifeBarDimensions, baseColor);
   
-  sf::Text tempText;
-  tempText.setFont(*font);
-  tempText.setString(text);
-  tempText.setCharacterSize(20.0f);
+  const TextLayout& textLayout = textCache->getLayout(text, hudSection.characterSize);
   
-  sf::FloatRect localTextBounds = tempText.getLocalBounds();
   Vec2f textPos = position + Vec2f(1, 1);
-  textPos.x += ((dimensions.x - 2) / 2.0f) - (localTextBounds.width / 2.0f) ;
-  
-  tempText.setPosition(textPos.x, textPos.y);
-  tempText.setColor(sf::Color::Black);
-  
-  window->draw(tempText);
+  textPos.x += ((dimensions.x - 2) / 2.0f) - (textLayout.localBounds.width / 2.0f) ;
   
-  Vec2f nextPosition = position;
-  nextPosition.y += dimensions.y * 1.5f ;
-  
-  return nextPosition;
+  textCache->appendText(hudSection.textVertices, textLayout, textPos, sf::Color::Black);
+}
+
+Vec2f PlayerHud::getBarDimensions(const sf::Vector2u& windowDimensions) const
+{
+  return Vec2f(windowDimensions.x * 0.3f, 25.0f);
 }
 
+Vec2f PlayerHud::getBarPosition(HUD_SECTION hudSection, const sf::Vector2u& windowDimensions) const
+{
+  Vec2f renderBarDimensions = getBarDimensions(windowDimensions);
+  Vec2f renderBarPosition(windowDimensions.x - renderBarDimensions.x - 2.0f,
+			  windowDimensions.y - (renderBarDimensions.y * 5));
+
+  // Bars are stacked from the health bar downwards
+  renderBarPosition.y += (hudSection - HS_HEALTH_BAR) * renderBarDimensions.y * 1.5f;
+  return renderBarPosition;
+}
+
+Vec2f PlayerHud::appendText(HudSection& hudSection, const std::string& text, const Vec2f& textPos,
+			    const sf::Color& color)
+{
+  const TextLayout& textLayout = textCache->getLayout(text, hudSection.characterSize);
+  textCache->appendText(hudSection.textVertices, textLayout, textPos, color);
+
+  return textPos + Vec2f(0, textLayout.localBounds.height * 2);
+}
@@ -2,20 +2,80 @@
 
 #include <SFML/Graphics.hpp>
 #include "Entity.h"
+#include "TextCache.h"
+
+class Player;
+
+// Player values shown on the hud, compared every frame to find what changed
+struct PlayerHudStats {
+  void capture(const Player* player);
+  
+  int mobLevel;
+  int skillPoints;
+
+  float shieldValue;
+  float damageValue;
+  float movementSpeed;
+  float bulletVelocity;
+
+  float health;
+  float maxHealth;
+  float stamina;
+  float maxStamina;
+
+  float xp;
+  float currentLevelXp;
+  float nextLevelXp;
+};
+
+enum HUD_SECTION {
+  HS_PANEL,
+  HS_HEALTH_BAR,
+  HS_STAMINA_BAR,
+  HS_XP_BAR,
+  HS_COUNT
+};
+
+// Retained vertex data of one part of the hud
+struct HudSection {
+  HudSection() : shapeVertices(sf::Quads), textVertices(sf::Quads), characterSize(0) {}
+  
+  sf::VertexArray shapeVertices;
+  sf::VertexArray textVertices;
+  uint32 characterSize;
+};
 
 class PlayerHud {
 public:
+  PlayerHud() : window(NULL), textCache(NULL), isBuilt(false), rebuildCount(0) {}
+  
   void setWindow(sf::RenderWindow* window) { this->window = window; }
-  void setFont(sf::Font* font) { this->font = font; }
+  void setTextCache(TextCache* textCache) { this->textCache = textCache; }
   
   void render(const Player* player);
-  Vec2f renderText(const std::string& text, const Vec2f& textPos, const sf::Color& color,
-		      bool nextLine = true);
+  void render(const PlayerHudStats& playerHudStats);
+
+  // How many times hud sections had to be regenerated
+  uint32 getRebuildCount() const { return rebuildCount; }
   
-  Vec2f renderBar(float fillPercentage, const sf::Color& baseColor, const Vec2f& position,
-		     const Vec2f& dimensions, const std::string& text); 
-		     
 private:
   sf::RenderWindow* window;
-  sf::Font* font;
+  TextCache* textCache;
+
+  HudSection hudSections[HS_COUNT];
+  PlayerHudStats lastStats;
+  sf::Vector2u lastWindowDimensions;
+  bool isBuilt;
+  
+  uint32 rebuildCount;
+
+  void rebuildPanel(const PlayerHudStats& stats, const sf::Vector2u& windowDimensions);
+  void rebuildBar(HUD_SECTION hudSection, float fillPercentage, const sf::Color& baseColor,
+		  const Vec2f& position, const Vec2f& dimensions, const std::string& text);
+
+  Vec2f getBarPosition(HUD_SECTION hudSection, const sf::Vector2u& windowDimensions) const;
+  Vec2f getBarDimensions(const sf::Vector2u& windowDimensions) const;
+  
+  Vec2f appendText(HudSection& hudSection, const std::string& text, const Vec2f& textPos,
+		   const sf::Color& color);
 };
@@ -0,0 +1,128 @@
+#include "ProjectileManager.h"
+
+#include <stdlib.h>
+
+#include "Level.h"
+#include "JobSystem.h"
+
+Projectile::Projectile(const EntityPosition& position, const Vec2f& velocity,
+		       const Vec2f& dimensions, float damageValue) :
+  position(position), velocity(velocity), dimensions(dimensions), damageValue(damageValue)
+{
+  bouncesLeft = 2;
+}
+
+void
+ProjectileManager::addProjectile(const Projectile& projectile)
+{
+  positions.push_back(projectile.position);
+  velocities.push_back(projectile.velocity);
+  dimensions.push_back(projectile.dimensions);
+  damageValues.push_back(projectile.damageValue);
+  bouncesLeft.push_back(projectile.bouncesLeft);
+  colors.push_back(Vec3f(rand()%256, rand()%256, rand()%256));
+}
+
+void
+ProjectileManager::sweep(const Level& level, const float lastDelta)
+{
+  int32 count = getCount();
+  collisionResults.resize(count);
+  positionDeltaVecs.resize(count);
+  isDead.assign(count, 0);
+
+  JobSystem::get()->parallelFor(count, 64,
+				[this, &level, lastDelta](int32 begin, int32 end)
+				{
+				  for(int32 i = begin; i < end; i++)
+				  {
+				    Vec2f& velocity = velocities[i];
+				    positionDeltaVecs[i] = velocity * lastDelta;
+				    velocity -= velocity * projectileFriction * lastDelta;
+
+				    // Still moves and hits this tick, it's removed after that
+				    if(velocity.getLength() < minProjectileSpeed) isDead[i] = 1;
+
+				    CollisionCheckData collisionCheckData = { positions[i],
+									      FloatRect(0, 0, dimensions[i].x, dimensions[i].y),
+									      positionDeltaVecs[i] };
+				    collisionResults[i] = level.checkCollisions(collisionCheckData, NULL, true);
+				  }
+				});
+}
+
+void
+ProjectileManager::resolve(ILevel* level)
+{
+  static const float speedIncrease = 1.0f;
+  const Vec2i& tileChunkSize = level->getTileMap()->getTileChunkSize();
+
+  int32 count = getCount();
+  for(int32 i = 0; i < count; i++)
+  {
+    EntityCollisionResult& collisionResult = collisionResults[i];
+    positions[i] += positionDeltaVecs[i] * collisionResult.maxAllowedT;
+    positions[i].recanonicalize(tileChunkSize);
+
+    if(collisionResult.maxAllowedT == 1.0f) continue;
+
+    Vec2f& velocity = velocities[i];
+    Vec2f reflectedVelocity = velocity;
+    if(collisionResult.collisionPlane == COLLISION_PLANE_VERTICAL) reflectedVelocity.x *= -speedIncrease;
+    if(collisionResult.collisionPlane == COLLISION_PLANE_HORIZONTAL) reflectedVelocity.y *= -speedIncrease;
+
+    // Colliding With Entities
+    if(collisionResult.collidedEntity != NULL)
+    {
+      Entity* entity = collisionResult.collidedEntity;
+      level->queueHealthChange(entity, -damageValues[i]);
+      level->queueImpulse(entity, velocity * 0.5f);
+
+      Entity::spawnBloodParticles(level, entity->getCollisionCenter(), 10,
+				  reflectedVelocity.getLength() / 4.0f);
+      isDead[i] = 1;
+    }
+    // Colliding With Tiles
+    else if(bouncesLeft[i]-- == 0)
+    {
+      EntityPosition center = positions[i] + dimensions[i] / 2.0f;
+      Entity::spawnDustParticles(level, center, 10, velocity.getLength() / 4.0f);
+      isDead[i] = 1;
+    }
+
+    velocity = reflectedVelocity;
+  }
+
+  // Swapping with the last one, order of projectiles doesn't matter
+  int32 i = 0;
+  while(i < count)
+  {
+    if(isDead[i])
+    {
+      isDead[i] = isDead[count - 1];
+      removeProjectile(i);
+      count--;
+    }
+    else i++;
+  }
+}
+
+void
+ProjectileManager::removeProjectile(int32 index)
+{
+  int32 last = getCount() - 1;
+
+  positions[index] = positions[last];
+  velocities[index] = velocities[last];
+  dimensions[index] = dimensions[last];
+  damageValues[index] = damageValues[last];
+  bouncesLeft[index] = bouncesLeft[last];
+  colors[index] = colors[last];
+
+  positions.pop_back();
+  velocities.pop_back();
+  dimensions.pop_back();
+  damageValues.pop_back();
+  bouncesLeft.pop_back();
+  colors.pop_back();
+}
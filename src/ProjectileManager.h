@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include <jpb/Vector.h>
+#include "EntityPosition.h"
+#include "ILevel.h"
+#include "Types.h"
+
+class Level;
+
+// Fired by cannons and the player, collision rect covers the whole dimensions
+// Color is picked when it's added, shooters construct them while updating in parallel
+struct Projectile {
+  Projectile() {}
+  Projectile(const EntityPosition& position, const Vec2f& velocity,
+	     const Vec2f& dimensions, float damageValue);
+
+  EntityPosition position;
+  Vec2f velocity;
+  Vec2f dimensions;
+  float damageValue;
+  int32 bouncesLeft;
+};
+
+// If projectileFriction Is 1.0f velocity will be reduced to 0 in 1 second
+const float projectileFriction = 0.001f;
+
+// Slower projectiles fall apart after their last move
+const float minProjectileSpeed = 1.0f;
+
+// Projectiles in flat arrays instead of entities, so there's no virtual update,
+// friction lookup, list node or event registration for every one of them
+class ProjectileManager{
+public:
+  void addProjectile(const Projectile& projectile);
+  int32 getCount() const { return (int32)positions.size(); }
+
+  // Integrates all of them and sweeps them against tiles and the CollisionSnapshot rows in the
+  // grid cells each sweep covers, only reads the level so it runs while the world is frozen
+  void sweep(const Level& level, const float lastDelta);
+
+  // Moves them by the allowed part of the sweep, damages hit entities, bounces off
+  // walls and removes the dead ones
+  void resolve(ILevel* level);
+
+  const std::vector<EntityPosition>& getPositions() const { return positions; }
+  const std::vector<Vec2f>& getDimensions() const { return dimensions; }
+  const std::vector<Vec3f>& getColors() const { return colors; }
+
+private:
+  std::vector<EntityPosition> positions;
+  std::vector<Vec2f> velocities;
+  std::vector<Vec2f> dimensions;
+  std::vector<float> damageValues;
+  std::vector<int32> bouncesLeft;
+  std::vector<Vec3f> colors;
+
+  // Written by sweep, read by resolve
+  std::vector<EntityCollisionResult> collisionResults;
+  std::vector<Vec2f> positionDeltaVecs;
+  std::vector<uint8> isDead;
+
+  void removeProjectile(int32 index);
+};
@@ -0,0 +1,83 @@
+#include "RenderSnapshot.h"
+
+void
+RenderSnapshot::captureEntities(Level* level)
+{
+  primitiveRenderData.clear();
+  mobRenderData.clear();
+  overlayTextRenderData.clear();
+  basicSpriteRenderData.clear();
+
+  for(int layerIndex = 0; layerIndex < numbOfEntityLayers; layerIndex++)
+  {
+    const EntityList& entityList = level->getEntityList(layerIndex);
+    EntitySnapshotList& entitySnapshotList = entityLayers[layerIndex];
+    entitySnapshotList.clear();
+
+    for(auto entityIt = entityList.begin(); entityIt != entityList.end(); entityIt++)
+    {
+      const EntityRenderData* entityRenderData = (*entityIt)->getRenderData();
+
+      EntitySnapshot entitySnapshot;
+      entitySnapshot.position = (*entityIt)->getPosition();
+      entitySnapshot.dimensions = (*entityIt)->getDimensions();
+      entitySnapshot.renderDataType = entityRenderData->type;
+
+      switch(entityRenderData->type)
+      {
+      case ER_PRIMITIVE:
+	entitySnapshot.renderDataIndex = (uint32)primitiveRenderData.size();
+	primitiveRenderData.push_back(*((const PrimitiveRenderData*)entityRenderData));
+	break;
+      case ER_MOB:
+	entitySnapshot.renderDataIndex = (uint32)mobRenderData.size();
+	mobRenderData.push_back(*((const MobRenderData*)entityRenderData));
+	break;
+      case ER_OVERLAYTEXT:
+	entitySnapshot.renderDataIndex = (uint32)overlayTextRenderData.size();
+	overlayTextRenderData.push_back(*((const OverlayTextRenderData*)entityRenderData));
+	break;
+      case ER_BASICSPRITE:
+	entitySnapshot.renderDataIndex = (uint32)basicSpriteRenderData.size();
+	basicSpriteRenderData.push_back(*((const BasicSpriteRenderData*)entityRenderData));
+	break;
+      }
+
+      entitySnapshotList.push_back(entitySnapshot);
+    }
+  }
+
+  // Drawn like the entities they used to be
+  const ProjectileManager& projectileManager = level->getProjectileManager();
+  for(int32 i = 0; i < projectileManager.getCount(); i++)
+  {
+    PrimitiveRenderData renderData;
+    renderData.primitiveType = PT_CIRCLE;
+    renderData.dimensionsInTiles = projectileManager.getDimensions()[i];
+    renderData.color = projectileManager.getColors()[i];
+
+    EntitySnapshot entitySnapshot;
+    entitySnapshot.position = projectileManager.getPositions()[i];
+    entitySnapshot.dimensions = projectileManager.getDimensions()[i];
+    entitySnapshot.renderDataType = ER_PRIMITIVE;
+    entitySnapshot.renderDataIndex = (uint32)primitiveRenderData.size();
+    primitiveRenderData.push_back(renderData);
+
+    entityLayers[0].push_back(entitySnapshot);
+  }
+}
+
+const EntityRenderData*
+RenderSnapshot::getRenderData(const EntitySnapshot& entitySnapshot) const
+{
+  switch(entitySnapshot.renderDataType)
+  {
+  case ER_PRIMITIVE: return &primitiveRenderData[entitySnapshot.renderDataIndex];
+  case ER_MOB: return &mobRenderData[entitySnapshot.renderDataIndex];
+  case ER_OVERLAYTEXT: return &overlayTextRenderData[entitySnapshot.renderDataIndex];
+  case ER_BASICSPRITE: return &basicSpriteRenderData[entitySnapshot.renderDataIndex];
+  }
+
+  assert(0);
+  return NULL;
+}
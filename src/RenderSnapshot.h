@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "Level.h"
+#include "PlayerHud.h"
+
+// Copy of entity state needed for drawing
+struct EntitySnapshot {
+  EntityPosition position;
+  Vec2f dimensions;
+
+  // Index into render data array of matching type
+  ENTITY_RENDER_DATA_TYPE renderDataType;
+  uint32 renderDataIndex;
+};
+
+typedef std::vector<EntitySnapshot> EntitySnapshotList;
+
+// Everything renderer needs for one frame, written by the simulation and
+// only read afterwards, so it can be drawn while next tick is simulated
+class RenderSnapshot {
+public:
+  RenderSnapshot() : tileSizeInPixels(0), isGenerationFinished(false), hasPlayer(false) {}
+
+  // Copies entities of the level, render data arrays keep their memory
+  void captureEntities(Level* level);
+
+  const EntitySnapshotList& getEntityList(int layerIndex) const { return entityLayers[layerIndex]; }
+  const EntityRenderData* getRenderData(const EntitySnapshot& entitySnapshot) const;
+
+  // Tile map isn't copied, it's only modified while level is being generated
+  LevelPtr level;
+  EntityPosition cameraPosition;
+  float tileSizeInPixels;
+  bool isGenerationFinished;
+
+  bool hasPlayer;
+  PlayerHudStats playerHudStats;
+
+private:
+  EntitySnapshotList entityLayers[numbOfEntityLayers];
+
+  std::vector<PrimitiveRenderData> primitiveRenderData;
+  std::vector<MobRenderData> mobRenderData;
+  std::vector<OverlayTextRenderData> overlayTextRenderData;
+  std::vector<BasicSpriteRenderData> basicSpriteRenderData;
+};
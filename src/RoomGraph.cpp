@@ -0,0 +1,324 @@
+#include "RoomGraph.h"
+
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <assert.h>
+
+// Rounds toward negative infinity so negative tiles end up in the right chunk
+static int32
+floorDivide(int32 value, int32 divisor)
+{
+  int32 result = value / divisor;
+  if(value % divisor != 0 && value < 0) result--;
+  return result;
+}
+
+static float
+getDistance(const Vec2f& position1, const Vec2f& position2)
+{
+  return (position2 - position1).getLength();
+}
+
+static Vec2f
+getRoomCenter(const RoomNode& room)
+{
+  return Vec2f(room.bounds.left + room.bounds.width / 2.0f, room.bounds.top + room.bounds.height / 2.0f);
+}
+
+int32
+RoomGraph::addRoom(const WorldPosition& topLeftCorner, const Vec2i& dimensions)
+{
+  Vec2i absoluteCorner = toAbsoluteTile(topLeftCorner);
+
+  RoomNode room;
+  room.bounds = IntRect(absoluteCorner.x, absoluteCorner.y, dimensions.x, dimensions.y);
+  room.z = topLeftCorner.tileChunkPosition.z;
+
+  int32 roomIndex = (int32)rooms.size();
+  rooms.push_back(room);
+
+  int32 firstChunkX = floorDivide(room.bounds.left, tileChunkSize.x);
+  int32 firstChunkY = floorDivide(room.bounds.top, tileChunkSize.y);
+  int32 lastChunkX = floorDivide(room.bounds.left + room.bounds.width - 1, tileChunkSize.x);
+  int32 lastChunkY = floorDivide(room.bounds.top + room.bounds.height - 1, tileChunkSize.y);
+
+  for(int32 chunkY = firstChunkY; chunkY <= lastChunkY; chunkY++)
+  {
+    for(int32 chunkX = firstChunkX; chunkX <= lastChunkX; chunkX++)
+    {
+      chunkRooms[Vec3i(chunkX, chunkY, room.z)].push_back(roomIndex);
+    }
+  }
+
+  return roomIndex;
+}
+
+void
+RoomGraph::addPortal(int32 roomIndex1, int32 roomIndex2, const WorldPosition& tile)
+{
+  assert(roomIndex1 >= 0 && roomIndex1 < (int32)rooms.size());
+  assert(roomIndex2 >= 0 && roomIndex2 < (int32)rooms.size());
+
+  RoomPortal portal = { { roomIndex1, roomIndex2 }, toAbsoluteTile(tile) };
+
+  int32 portalIndex = (int32)portals.size();
+  portals.push_back(portal);
+  rooms[roomIndex1].portalIndices.push_back(portalIndex);
+  rooms[roomIndex2].portalIndices.push_back(portalIndex);
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  portalPathCache.clear();
+}
+
+int32
+RoomGraph::getRoomIndex(const WorldPosition& tile) const
+{
+  Vec2i absoluteTile = toAbsoluteTile(tile);
+  Vec3i chunkPosition(floorDivide(absoluteTile.x, tileChunkSize.x),
+		      floorDivide(absoluteTile.y, tileChunkSize.y),
+		      tile.tileChunkPosition.z);
+
+  auto chunkRoomsIt = chunkRooms.find(chunkPosition);
+  if(chunkRoomsIt == chunkRooms.end()) return -1;
+
+  // Floors don't overlap, walls are shared so they are only checked after the floors
+  int32 wallRoomIndex = -1;
+  for(auto roomIndex = chunkRoomsIt->second.begin(); roomIndex != chunkRoomsIt->second.end(); roomIndex++)
+  {
+    const IntRect& bounds = rooms[*roomIndex].bounds;
+    if(absoluteTile.x < bounds.left || absoluteTile.x >= bounds.left + bounds.width ||
+       absoluteTile.y < bounds.top || absoluteTile.y >= bounds.top + bounds.height) continue;
+
+    if(absoluteTile.x > bounds.left && absoluteTile.x < bounds.left + bounds.width - 1 &&
+       absoluteTile.y > bounds.top && absoluteTile.y < bounds.top + bounds.height - 1) return *roomIndex;
+
+    if(wallRoomIndex == -1) wallRoomIndex = *roomIndex;
+  }
+
+  return wallRoomIndex;
+}
+
+float
+RoomGraph::getDistanceToRoom(const WorldPosition& tile, int32 roomIndex) const
+{
+  const RoomNode& room = rooms[roomIndex];
+  Vec2i absoluteTile = toAbsoluteTile(tile);
+
+  int32 deltaX = 0;
+  if(absoluteTile.x < room.bounds.left) deltaX = room.bounds.left - absoluteTile.x;
+  else if(absoluteTile.x >= room.bounds.left + room.bounds.width) deltaX = absoluteTile.x - (room.bounds.left + room.bounds.width - 1);
+
+  int32 deltaY = 0;
+  if(absoluteTile.y < room.bounds.top) deltaY = room.bounds.top - absoluteTile.y;
+  else if(absoluteTile.y >= room.bounds.top + room.bounds.height) deltaY = absoluteTile.y - (room.bounds.top + room.bounds.height - 1);
+
+  return Vec2f((float)deltaX, (float)deltaY).getLength();
+}
+
+bool
+RoomGraph::findPath(const TileMap& tileMap, const WorldPosition& start, const WorldPosition& goal,
+		    TilePath& path) const
+{
+  path.clear();
+
+  int32 srcRoomIndex = getRoomIndex(start);
+  int32 dstRoomIndex = getRoomIndex(goal);
+  if(srcRoomIndex == -1 || dstRoomIndex == -1) return false;
+
+  std::vector<int32> portalPath;
+  if(!findPortalPath(srcRoomIndex, dstRoomIndex, portalPath)) return false;
+
+  path.push_back(start);
+
+  // Portals are in the walls both rooms share, so a room is left and the next one entered on them
+  int32 roomIndex = srcRoomIndex;
+  Vec2i entryTile = toAbsoluteTile(start);
+  for(auto portalIndex = portalPath.begin(); portalIndex != portalPath.end(); portalIndex++)
+  {
+    const RoomPortal& portal = portals[*portalIndex];
+    if(!findRoomPath(tileMap, roomIndex, entryTile, portal.tile, path)) return false;
+
+    roomIndex = portal.roomIndices[0] == roomIndex ? portal.roomIndices[1] : portal.roomIndices[0];
+    entryTile = portal.tile;
+  }
+
+  return findRoomPath(tileMap, roomIndex, entryTile, toAbsoluteTile(goal), path);
+}
+
+bool
+RoomGraph::findPortalPath(int32 srcRoomIndex, int32 dstRoomIndex, std::vector<int32>& portalPath) const
+{
+  portalPath.clear();
+  if(srcRoomIndex == dstRoomIndex) return true;
+
+  uint64 cacheKey = ((uint64)(uint32)srcRoomIndex << 32) | (uint32)dstRoomIndex;
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto cachedPath = portalPathCache.find(cacheKey);
+    if(cachedPath != portalPathCache.end())
+    {
+      portalPath = cachedPath->second;
+      return true;
+    }
+  }
+
+  int32 roomCount = (int32)rooms.size();
+  std::vector<float> costs(roomCount, -1.0f);
+  std::vector<int32> cameThroughPortal(roomCount, -1);
+
+  // Cost of a room is the walk between room centers through the portals,
+  // straight distance between the centers never overestimates it
+  typedef std::pair<float, int32> OpenRoom;
+  std::priority_queue<OpenRoom, std::vector<OpenRoom>, std::greater<OpenRoom>> openRooms;
+
+  Vec2f dstCenter = getRoomCenter(rooms[dstRoomIndex]);
+  costs[srcRoomIndex] = 0;
+  openRooms.push(OpenRoom(getDistance(getRoomCenter(rooms[srcRoomIndex]), dstCenter), srcRoomIndex));
+
+  bool isFound = false;
+  while(!openRooms.empty())
+  {
+    OpenRoom openRoom = openRooms.top();
+    openRooms.pop();
+
+    int32 roomIndex = openRoom.second;
+    if(roomIndex == dstRoomIndex)
+    {
+      isFound = true;
+      break;
+    }
+
+    const RoomNode& room = rooms[roomIndex];
+    Vec2f roomCenter = getRoomCenter(room);
+
+    // Skipping stale entries of rooms that were reached cheaper since
+    if(openRoom.first > costs[roomIndex] + getDistance(roomCenter, dstCenter) + 0.001f) continue;
+
+    for(auto portalIndex = room.portalIndices.begin(); portalIndex != room.portalIndices.end(); portalIndex++)
+    {
+      const RoomPortal& portal = portals[*portalIndex];
+      int32 nextRoomIndex = portal.roomIndices[0] == roomIndex ? portal.roomIndices[1] : portal.roomIndices[0];
+
+      Vec2f portalPosition((float)portal.tile.x, (float)portal.tile.y);
+      Vec2f nextRoomCenter = getRoomCenter(rooms[nextRoomIndex]);
+      float cost = costs[roomIndex] + getDistance(roomCenter, portalPosition) + getDistance(portalPosition, nextRoomCenter);
+
+      if(costs[nextRoomIndex] >= 0 && costs[nextRoomIndex] <= cost) continue;
+
+      costs[nextRoomIndex] = cost;
+      cameThroughPortal[nextRoomIndex] = *portalIndex;
+      openRooms.push(OpenRoom(cost + getDistance(nextRoomCenter, dstCenter), nextRoomIndex));
+    }
+  }
+
+  if(!isFound) return false;
+
+  // Walking back from the destination
+  int32 roomIndex = dstRoomIndex;
+  while(roomIndex != srcRoomIndex)
+  {
+    const RoomPortal& portal = portals[cameThroughPortal[roomIndex]];
+    portalPath.push_back(cameThroughPortal[roomIndex]);
+    roomIndex = portal.roomIndices[0] == roomIndex ? portal.roomIndices[1] : portal.roomIndices[0];
+  }
+  std::reverse(portalPath.begin(), portalPath.end());
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  portalPathCache[cacheKey] = portalPath;
+  return true;
+}
+
+bool
+RoomGraph::findRoomPath(const TileMap& tileMap, int32 roomIndex, const Vec2i& startTile,
+			const Vec2i& goalTile, TilePath& path) const
+{
+  const RoomNode& room = rooms[roomIndex];
+  const IntRect& bounds = room.bounds;
+
+  auto isInside = [&bounds](const Vec2i& tile)
+    {
+      return tile.x >= bounds.left && tile.y >= bounds.top &&
+	tile.x < bounds.left + bounds.width && tile.y < bounds.top + bounds.height;
+    };
+  if(!isInside(startTile) || !isInside(goalTile)) return false;
+
+  // Tile the search came from, -2 for blocked tiles and -1 for the ones not reached yet
+  static const int32 blockedTile = -2;
+  static const int32 unreachedTile = -1;
+
+  static thread_local std::vector<int32> cameFrom;
+  static thread_local std::vector<int32> openTiles;
+  cameFrom.resize(bounds.width * bounds.height);
+  openTiles.clear();
+
+  for(int32 y = 0; y < bounds.height; y++)
+  {
+    for(int32 x = 0; x < bounds.width; x++)
+    {
+      WorldPosition tile = toWorldPosition(Vec2i(bounds.left + x, bounds.top + y), room.z);
+      TILE_TYPE tileType = tileMap.getTileType(tile);
+
+      bool isWalkable = tileType != TILE_TYPE_WALL && tileType != TILE_TYPE_VOID;
+      cameFrom[y * bounds.width + x] = isWalkable ? unreachedTile : blockedTile;
+    }
+  }
+
+  // Entities can stand partly in walls, so both ends are walkable no matter what they're on
+  int32 startIndex = (startTile.y - bounds.top) * bounds.width + startTile.x - bounds.left;
+  int32 goalIndex = (goalTile.y - bounds.top) * bounds.width + goalTile.x - bounds.left;
+  cameFrom[goalIndex] = unreachedTile;
+  cameFrom[startIndex] = startIndex;
+  openTiles.push_back(startIndex);
+
+  static const Vec2i neighbours[4] = { Vec2i(1, 0), Vec2i(-1, 0), Vec2i(0, 1), Vec2i(0, -1) };
+
+  for(size_t i = 0; i < openTiles.size() && cameFrom[goalIndex] == unreachedTile; i++)
+  {
+    int32 index = openTiles[i];
+    int32 x = index % bounds.width;
+    int32 y = index / bounds.width;
+
+    for(int32 j = 0; j < 4; j++)
+    {
+      int32 neighbourX = x + neighbours[j].x;
+      int32 neighbourY = y + neighbours[j].y;
+      if(neighbourX < 0 || neighbourY < 0 || neighbourX >= bounds.width || neighbourY >= bounds.height) continue;
+
+      int32 neighbourIndex = neighbourY * bounds.width + neighbourX;
+      if(cameFrom[neighbourIndex] != unreachedTile) continue;
+
+      cameFrom[neighbourIndex] = index;
+      openTiles.push_back(neighbourIndex);
+    }
+  }
+
+  if(cameFrom[goalIndex] < 0) return false;
+
+  // Walking back from the goal, then appending in the walking order
+  size_t firstTile = path.size();
+  for(int32 index = goalIndex; index != startIndex; index = cameFrom[index])
+  {
+    Vec2i tile(bounds.left + index % bounds.width, bounds.top + index / bounds.width);
+    path.push_back(toWorldPosition(tile, room.z));
+  }
+  std::reverse(path.begin() + firstTile, path.end());
+
+  return true;
+}
+
+Vec2i
+RoomGraph::toAbsoluteTile(const WorldPosition& tile) const
+{
+  return Vec2i(tile.tileChunkPosition.x * tileChunkSize.x + tile.tilePosition.x,
+	       tile.tileChunkPosition.y * tileChunkSize.y + tile.tilePosition.y);
+}
+
+WorldPosition
+RoomGraph::toWorldPosition(const Vec2i& absoluteTile, int32 z) const
+{
+  Vec3i chunkPosition(floorDivide(absoluteTile.x, tileChunkSize.x), floorDivide(absoluteTile.y, tileChunkSize.y), z);
+  Vec2i tilePosition(absoluteTile.x - chunkPosition.x * tileChunkSize.x,
+		     absoluteTile.y - chunkPosition.y * tileChunkSize.y);
+  return WorldPosition(chunkPosition, tilePosition);
+}
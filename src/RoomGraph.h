@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <jpb/Rect.h>
+#include "EntityPosition.h"
+#include "TileMap.h"
+#include "Types.h"
+
+// Every tile from the start to the goal, consecutive ones are neighbours
+typedef std::vector<WorldPosition> TilePath;
+
+// Opening in the wall shared by two rooms, tile is the middle of the opening
+struct RoomPortal {
+  int32 roomIndices[2];
+  Vec2i tile;
+};
+
+struct RoomNode {
+  // Absolute tile coordinates including the walls
+  IntRect bounds;
+  int32 z;
+  std::vector<int32> portalIndices;
+};
+
+// Rooms and openings emitted by the level generator, used to plan long paths
+// room to room instead of searching the whole tile grid
+class RoomGraph{
+public:
+  RoomGraph(const Vec2i& tileChunkSize) : tileChunkSize(tileChunkSize) {}
+
+  int32 addRoom(const WorldPosition& topLeftCorner, const Vec2i& dimensions);
+  void addPortal(int32 roomIndex1, int32 roomIndex2, const WorldPosition& tile);
+
+  // -1 if the tile isn't in any room, tiles of shared walls go to the first room containing them
+  int32 getRoomIndex(const WorldPosition& tile) const;
+  int32 getRoomCount() const { return (int32)rooms.size(); }
+
+  // Distance in tiles from the tile to the closest tile of the room, 0 inside of it
+  float getDistanceToRoom(const WorldPosition& tile, int32 roomIndex) const;
+
+  // A* over rooms, each room on the way is then searched on tiles from where it's entered
+  // to where it's left, so whatever stands inside of the rooms is walked around
+  // Safe to call from entity updates
+  bool findPath(const TileMap& tileMap, const WorldPosition& start, const WorldPosition& goal,
+		TilePath& path) const;
+
+private:
+  Vec2i tileChunkSize;
+
+  std::vector<RoomNode> rooms;
+  std::vector<RoomPortal> portals;
+
+  // Rooms overlapping every chunk, for finding the room of a tile
+  std::unordered_map<Vec3i, std::vector<int32>> chunkRooms;
+
+  // Portals between two rooms, shared by every request between the same pair
+  mutable std::mutex cacheMutex;
+  mutable std::unordered_map<uint64, std::vector<int32>> portalPathCache;
+
+  bool findPortalPath(int32 srcRoomIndex, int32 dstRoomIndex, std::vector<int32>& portalPath) const;
+
+  // Breadth first over walkable tiles of the room, appends the tiles after startTile up to goalTile
+  bool findRoomPath(const TileMap& tileMap, int32 roomIndex, const Vec2i& startTile,
+		    const Vec2i& goalTile, TilePath& path) const;
+
+  Vec2i toAbsoluteTile(const WorldPosition& tile) const;
+  WorldPosition toWorldPosition(const Vec2i& absoluteTile, int32 z) const;
+};
+
+typedef std::shared_ptr<RoomGraph> RoomGraphPtr;
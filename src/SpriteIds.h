@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Types.h"
+
+// Index into SpriteManager sprite array, returned on sprite registration
+typedef uint32 SpriteHandle;
+
+// Handles of built-in sprites, they follow the registration order from
+// PlayGameState::enter, sprite sets are numbered from 1 like their names
+enum SPRITE_ID {
+  SPRITE_FLOOR1 = 0,                        // floor1_1 - floor1_69
+  SPRITE_WALLTOP1 = SPRITE_FLOOR1 + 69,     // wallTop1_1 - wallTop1_59
+  SPRITE_WALL1 = SPRITE_WALLTOP1 + 59,      // wall1_1 - wall1_7
+
+  SPRITE_FIRST = SPRITE_WALL1 + 7,
+  SPRITE_HEALTH_POTION,
+  SPRITE_PLAYER_BASE,
+  SPRITE_FOLLOWER_BASE,
+  SPRITE_CANNON_BASE,
+  SPRITE_RAT_BASE,
+  SPRITE_SNAKE_BASE,
+
+  SPRITE_GOBLIN,                            // goblin_1 - goblin_4
+  SPRITE_BUILTIN_COUNT = SPRITE_GOBLIN + 4
+};
+
+// Handle of n-th sprite from sprite set, setIndex starts from 1
+inline SpriteHandle
+getSpriteSetHandle(SPRITE_ID spriteSet, int setIndex)
+{
+  return spriteSet + setIndex - 1;
+}
@@ -1,47 +1,61 @@
 #include "SpriteManager.h"
 
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 
 void
 SpriteManager::loadTexture(const std::string& filename)
 {
-  sf::Texture texture; 
-  bool result = texture.loadFromFile("../resources/gfx/" + filename);
+  sf::Image image; 
+  bool result = image.loadFromFile("../resources/gfx/" + filename);
   if(!result)
   {
     std::cout << "Couldn't locate file:" + filename + " \n\n";
     assert(0);
   }
   std::cout << "Loaded File: " << filename << std::endl;
-  textureVector.push_back(texture);
+  imageVector.push_back(image);
 }
 
-void
+SpriteHandle
 SpriteManager::loadSprite(const std::string& spriteName,
 			  const IntRect& spriteRect,
 			  int textureIndex)
 {
   assert(textureIndex == - 1 ||
-	 textureIndex <= textureVector.size());
-  
-  sf::Sprite& sprite = spriteMap[spriteName];
-  sprite.setTextureRect(sf::IntRect(spriteRect.left, spriteRect.top,
-				    spriteRect.width, spriteRect.height));
-  
-  std::cout << "Loaded Sprite: " << spriteName << std::endl;
+	 textureIndex < imageVector.size());
+  assert(imageVector.size() > 0);
   
-  if(textureIndex != -1)
+  // Sprites loaded after packing wouldn't be in the atlas
+  assert(!atlasBuilt);
+
+  SpriteSource spriteSource;
+  spriteSource.textureIndex = textureIndex != -1 ? textureIndex : (int)imageVector.size() - 1;
+  spriteSource.spriteRect = spriteRect;
+
+  // Reloading sprite with the same name keeps its handle
+  SpriteHandle spriteHandle;
+  auto handleIt = spriteHandleMap.find(spriteName);
+  if(handleIt != spriteHandleMap.end())
   {
-    sprite.setTexture(textureVector[textureIndex]);
+    spriteHandle = handleIt->second;
+    spriteSourceVector[spriteHandle] = spriteSource;
   }
   else
   {
-    sprite.setTexture(textureVector.back());
+    spriteHandle = (SpriteHandle)spriteVector.size();
+    spriteHandleMap[spriteName] = spriteHandle;
+    
+    spriteVector.push_back(sf::Sprite());
+    spriteSourceVector.push_back(spriteSource);
   }
+  
+  std::cout << "Loaded Sprite: " << spriteName << std::endl;
+  return spriteHandle;
 }
 
-void
+SpriteHandle
 SpriteManager::loadSpriteSet(const std::string& spriteName,
 			     const IntRect& spriteRect,
 			     int numbOfSprites,
@@ -50,6 +64,7 @@ SpriteManager::loadSpriteSet(const std::string& spriteName,
 {
   IntRect currentSpriteRect = spriteRect;
   std::string currentSpriteName;
+  SpriteHandle firstSpriteHandle = 0;
   
   for(int i = 0; i < numbOfSprites; i++)
   {
@@ -59,20 +74,119 @@ SpriteManager::loadSpriteSet(const std::string& spriteName,
     if(currentSpriteIndex > 9) currentSpriteName += char((currentSpriteIndex/10) + '0');
     currentSpriteName += char(((currentSpriteIndex)%10) + '0');
     
-    loadSprite(currentSpriteName, currentSpriteRect, textureIndex);
+    SpriteHandle spriteHandle = loadSprite(currentSpriteName, currentSpriteRect, textureIndex);
+    if(i == 0) firstSpriteHandle = spriteHandle;
+    
     currentSpriteRect.left += currentSpriteRect.width;
   }
+
+  return firstSpriteHandle;
 }
 
-const sf::Sprite&
-SpriteManager::getSprite(std::string spriteName) const
+void
+SpriteManager::buildAtlas()
+{
+  assert(!atlasBuilt);
+  
+  // One pixel gap between sprites so filtering doesn't pick neighbours
+  static const int spritePadding = 1;
+  static const unsigned int atlasWidth = 512;
+
+  // Shelf packing, tallest sprites first so the rows are tight
+  std::vector<SpriteHandle> packingOrder(spriteVector.size());
+  for(SpriteHandle i = 0; i < packingOrder.size(); i++) packingOrder[i] = i;
+
+  std::stable_sort(packingOrder.begin(), packingOrder.end(),
+		   [this](SpriteHandle first, SpriteHandle second)
+		   {
+		     return spriteSourceVector[first].spriteRect.height >
+		       spriteSourceVector[second].spriteRect.height;
+		   });
+
+  std::vector<Vec2i> atlasPositions(spriteVector.size());
+  int currentX = 0, currentY = 0, shelfHeight = 0;
+  
+  for(auto i = packingOrder.begin(); i != packingOrder.end(); i++)
+  {
+    const IntRect& spriteRect = spriteSourceVector[*i].spriteRect;
+    assert(spriteRect.width + spritePadding <= atlasWidth);
+    
+    if(currentX + spriteRect.width + spritePadding > atlasWidth)
+    {
+      currentX = 0;
+      currentY += shelfHeight;
+      shelfHeight = 0;
+    }
+
+    atlasPositions[*i] = Vec2i(currentX, currentY);
+    currentX += spriteRect.width + spritePadding;
+    shelfHeight = std::max(shelfHeight, spriteRect.height + spritePadding);
+  }
+
+  unsigned int atlasHeight = currentY + shelfHeight;
+  if(atlasHeight > sf::Texture::getMaximumSize())
+  {
+    std::cout << "Sprites don't fit into the atlas: " << atlasHeight << std::endl;
+    assert(0);
+  }
+
+  sf::Image atlasImage;
+  atlasImage.create(atlasWidth, std::max(atlasHeight, 1u), sf::Color::Transparent);
+
+  for(SpriteHandle i = 0; i < spriteVector.size(); i++)
+  {
+    const SpriteSource& spriteSource = spriteSourceVector[i];
+    const IntRect& spriteRect = spriteSource.spriteRect;
+    const Vec2i& atlasPosition = atlasPositions[i];
+    
+    sf::IntRect sourceRect(spriteRect.left, spriteRect.top, spriteRect.width, spriteRect.height);
+    atlasImage.copy(imageVector[spriteSource.textureIndex], atlasPosition.x, atlasPosition.y, sourceRect);
+  }
+
+  atlasTexture.loadFromImage(atlasImage);
+
+  for(SpriteHandle i = 0; i < spriteVector.size(); i++)
+  {
+    const IntRect& spriteRect = spriteSourceVector[i].spriteRect;
+    const Vec2i& atlasPosition = atlasPositions[i];
+    
+    spriteVector[i].setTexture(atlasTexture);
+    spriteVector[i].setTextureRect(sf::IntRect(atlasPosition.x, atlasPosition.y,
+					       spriteRect.width, spriteRect.height));
+  }
+
+  // Source images aren't needed anymore
+  imageVector.clear();
+  atlasBuilt = true;
+  
+  std::cout << "Built Atlas: " << atlasWidth << "x" << atlasHeight
+	    << " Sprites: " << spriteVector.size() << std::endl;
+}
+
+SpriteHandle
+SpriteManager::getSpriteHandle(const std::string& spriteName) const
 {
-  if(spriteMap.count(spriteName))
+  auto handleIt = spriteHandleMap.find(spriteName);
+  if(handleIt != spriteHandleMap.end())
   {
-    return spriteMap.at(spriteName);
+    return handleIt->second;
   }
 
   std::cout << "Couldn't find sprite: " << spriteName << std::endl;
   assert(0);
-  return spriteMap.begin()->second;
+  return 0;
+}
+
+const sf::Sprite&
+SpriteManager::getSprite(SpriteHandle spriteHandle) const
+{
+  assert(atlasBuilt);
+  assert(spriteHandle < spriteVector.size());
+  return spriteVector[spriteHandle];
+}
+
+const sf::Sprite&
+SpriteManager::getSprite(const std::string& spriteName) const
+{
+  return getSprite(getSpriteHandle(spriteName));
 }
@@ -6,25 +6,52 @@
 #include <jpb\Vector.h>
 #include <jpb\Rect.h>
 
-typedef std::unordered_map<std::string, sf::Sprite> SpriteMap;
+#include "SpriteIds.h"
+
+typedef std::unordered_map<std::string, SpriteHandle> SpriteHandleMap;
 
 class SpriteManager {
 public:
+  SpriteManager() : atlasBuilt(false) {}
+  
   void loadTexture(const std::string& filename);
   
-  // Texture has to be loaded before loading sprite
-  void loadSprite(const std::string& spriteName,
-		  const IntRect& spriteRect,
-		  int textureIndex = -1);
+  // Texture has to be loaded before loading sprite,
+  // returns handle which should be used for rendering
+  SpriteHandle loadSprite(const std::string& spriteName,
+			  const IntRect& spriteRect,
+			  int textureIndex = -1);
+  
+  // Returns handle of the first sprite, rest of the set follows it
+  SpriteHandle loadSpriteSet(const std::string& spriteName,
+			     const IntRect& spriteRect,
+			     int numbOfSprites,
+			     int startValue = 0,
+			     int textureIndex = -1);
+
+  // Packs every loaded sprite into single texture,
+  // has to be called after last sprite is loaded
+  void buildAtlas();
+  
+  SpriteHandle getSpriteHandle(const std::string& spriteName) const;
   
-  void loadSpriteSet(const std::string& spriteName,
-		     const IntRect& spriteRect,
-		     int numbOfSprites,
-		     int startValue = 0,
-		     int textureIndex = -1);
+  const sf::Sprite& getSprite(SpriteHandle spriteHandle) const;
+  const sf::Sprite& getSprite(const std::string& spriteName) const;
   
-  const sf::Sprite& getSprite(std::string spriteName) const;
+  const sf::Texture& getAtlasTexture() const { return atlasTexture; }
 private:
-  std::vector<sf::Texture> textureVector;
-  SpriteMap spriteMap;
+  // Where sprite lives before the atlas is built
+  struct SpriteSource {
+    int textureIndex;
+    IntRect spriteRect;
+  };
+
+  std::vector<sf::Image> imageVector;
+  
+  std::vector<sf::Sprite> spriteVector;
+  std::vector<SpriteSource> spriteSourceVector;
+  SpriteHandleMap spriteHandleMap;
+
+  sf::Texture atlasTexture;
+  bool atlasBuilt;
 };
@@ -0,0 +1,110 @@
+#include "SweptCollision.h"
+
+#include <xmmintrin.h>
+
+void
+SweptRectBatch::addRect(const FloatRect& rect)
+{
+  if(count == (int32)left.size())
+  {
+    int32 paddedSize = count + 4;
+    left.resize(paddedSize);
+    top.resize(paddedSize);
+    right.resize(paddedSize);
+    bottom.resize(paddedSize);
+  }
+
+  left[count] = rect.left;
+  top[count] = rect.top;
+  right[count] = rect.left + rect.width;
+  bottom[count] = rect.top + rect.height;
+  count++;
+}
+
+// Lanes that hit earlier than their current best take the new time and wall
+static inline void
+keepEarlierHit(__m128 t, __m128 hitMask, float wallIndex, __m128& bestT, __m128& bestWall)
+{
+  __m128 earlier = _mm_and_ps(hitMask, _mm_cmplt_ps(t, bestT));
+  bestT = _mm_or_ps(_mm_and_ps(earlier, t), _mm_andnot_ps(earlier, bestT));
+  bestWall = _mm_or_ps(_mm_and_ps(earlier, _mm_set1_ps(wallIndex)), _mm_andnot_ps(earlier, bestWall));
+}
+
+SweptHit
+SweptRectBatch::sweepPoint(const Vec2f& point, const Vec2f& deltaVec, bool onlyForward) const
+{
+  SweptHit result = { 1.0f, -1, -1 };
+
+  // getMaxTime never hits walls parallel to the movement
+  const bool checkHorizontalWalls = deltaVec.y != 0;
+  const bool checkVerticalWalls = deltaVec.x != 0;
+  if(!checkHorizontalWalls && !checkVerticalWalls) return result;
+
+  const __m128 pointX = _mm_set1_ps(point.x);
+  const __m128 pointY = _mm_set1_ps(point.y);
+  const __m128 deltaX = _mm_set1_ps(deltaVec.x);
+  const __m128 deltaY = _mm_set1_ps(deltaVec.y);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 allLanes = _mm_cmpeq_ps(zero, zero);
+
+  for(int32 i = 0; i < count; i += 4)
+  {
+    __m128 rectLeft = _mm_loadu_ps(&left[i]);
+    __m128 rectTop = _mm_loadu_ps(&top[i]);
+    __m128 rectRight = _mm_loadu_ps(&right[i]);
+    __m128 rectBottom = _mm_loadu_ps(&bottom[i]);
+
+    __m128 bestT = _mm_set1_ps(1.0f);
+    __m128 bestWall = _mm_set1_ps(-1.0f);
+
+    for(int wallIndex = 0; wallIndex < 4; wallIndex++)
+    {
+      __m128 t;
+      __m128 hitMask;
+
+      if(wallIndex%2 == 0)
+      {
+	if(!checkHorizontalWalls) continue;
+
+	// Upper and Lower Wall, lower one excludes the corners
+	t = _mm_div_ps(_mm_sub_ps(wallIndex == 0 ? rectTop : rectBottom, pointY), deltaY);
+	__m128 newPositionX = _mm_add_ps(pointX, _mm_mul_ps(t, deltaX));
+	if(wallIndex == 0)
+	  hitMask = _mm_and_ps(_mm_cmpge_ps(newPositionX, rectLeft), _mm_cmple_ps(newPositionX, rectRight));
+	else
+	  hitMask = _mm_and_ps(_mm_cmpgt_ps(newPositionX, rectLeft), _mm_cmplt_ps(newPositionX, rectRight));
+      }
+      else
+      {
+	if(!checkVerticalWalls) continue;
+
+	// Right and Left Wall
+	t = _mm_div_ps(_mm_sub_ps(wallIndex == 1 ? rectRight : rectLeft, pointX), deltaX);
+	__m128 newPositionY = _mm_add_ps(pointY, _mm_mul_ps(t, deltaY));
+	hitMask = _mm_and_ps(_mm_cmpge_ps(newPositionY, rectTop), _mm_cmple_ps(newPositionY, rectBottom));
+      }
+
+      hitMask = _mm_and_ps(hitMask, onlyForward ? _mm_cmpge_ps(t, zero) : allLanes);
+      keepEarlierHit(t, hitMask, (float)wallIndex, bestT, bestWall);
+    }
+
+    // Lanes are reduced in candidate order so ties go to the first rect like in the scalar loop
+    float laneT[4];
+    float laneWall[4];
+    _mm_storeu_ps(laneT, bestT);
+    _mm_storeu_ps(laneWall, bestWall);
+
+    int32 laneCount = count - i < 4 ? count - i : 4;
+    for(int32 lane = 0; lane < laneCount; lane++)
+    {
+      if(laneWall[lane] >= 0 && laneT[lane] < result.maxAllowedT)
+      {
+	result.maxAllowedT = laneT[lane];
+	result.rectIndex = i + lane;
+	result.wallIndex = (int32)laneWall[lane];
+      }
+    }
+  }
+
+  return result;
+}
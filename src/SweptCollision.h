@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include <jpb\Rect.h>
+#include "Types.h"
+
+// Earliest hit of a swept point, wallIndex follows FloatRect::getMaxTime (Top Right Down Left)
+struct SweptHit {
+  float maxAllowedT;
+  int32 rectIndex;
+  int32 wallIndex;
+};
+
+// Minkowski expanded candidate rects kept in structure of arrays layout,
+// swept against 4 candidates at once with SSE
+class SweptRectBatch {
+public:
+  SweptRectBatch() : count(0) {}
+
+  void clear() { count = 0; }
+  void addRect(const FloatRect& rect);
+  int32 getCount() const { return count; }
+
+  // Gives the same result as calling getMaxTime for every rect and wall in order
+  // and keeping the first strictly smaller time, misses leave maxAllowedT at 1.0
+  // onlyForward ignores hits with negative time (entities that already overlap)
+  SweptHit sweepPoint(const Vec2f& point, const Vec2f& deltaVec, bool onlyForward) const;
+
+private:
+  int32 count;
+
+  // Padded to a multiple of 4
+  std::vector<float> left;
+  std::vector<float> top;
+  std::vector<float> right;
+  std::vector<float> bottom;
+};
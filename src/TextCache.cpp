@@ -0,0 +1,168 @@
+#include "TextCache.h"
+
+#include <algorithm>
+#include <assert.h>
+
+void
+TextCache::setFont(sf::Font* font)
+{
+  this->font = font;
+  layoutMap.clear();
+  batchMap.clear();
+}
+
+void
+TextCache::nextFrame()
+{
+  // Damage numbers come and go, so it's enough to sweep once in a while
+  static const uint64 sweepPeriod = 60;
+  static const uint64 maxUnusedFrames = 120;
+  
+  currentFrame++;
+  if(currentFrame % sweepPeriod != 0) return;
+  
+  for(auto sizeIt = layoutMap.begin(); sizeIt != layoutMap.end(); sizeIt++)
+  {
+    TextLayoutMap& textLayoutMap = sizeIt->second;
+    for(auto layoutIt = textLayoutMap.begin(); layoutIt != textLayoutMap.end();)
+    {
+      if(layoutIt->second.lastUsedFrame + maxUnusedFrames < currentFrame)
+      {
+	layoutIt = textLayoutMap.erase(layoutIt);
+      }
+      else layoutIt++;
+    }
+  }
+}
+
+const TextLayout&
+TextCache::getLayout(const std::string& text, uint32 characterSize)
+{
+  assert(font);
+  
+  TextLayoutMap& textLayoutMap = layoutMap[characterSize];
+  auto layoutIt = textLayoutMap.find(text);
+
+  if(layoutIt == textLayoutMap.end())
+  {
+    TextLayout& textLayout = textLayoutMap[text];
+    layoutText(textLayout, text, characterSize);
+    textLayout.lastUsedFrame = currentFrame;
+    return textLayout;
+  }
+
+  layoutIt->second.lastUsedFrame = currentFrame;
+  return layoutIt->second;
+}
+
+void
+TextCache::queueText(const TextLayout& textLayout, uint32 characterSize,
+		     const Vec2f& position, const sf::Color& color)
+{
+  sf::VertexArray& vertexArray = batchMap[characterSize];
+  vertexArray.setPrimitiveType(sf::Quads);
+  
+  appendText(vertexArray, textLayout, position, color);
+}
+
+void
+TextCache::appendText(sf::VertexArray& vertexArray, const TextLayout& textLayout,
+		      const Vec2f& position, const sf::Color& color) const
+{
+  const sf::Vector2f offset(position.x, position.y);
+  
+  for(auto i = textLayout.vertices.begin(); i != textLayout.vertices.end(); i++)
+  {
+    vertexArray.append(sf::Vertex(i->position + offset, color, i->texCoords));
+  }
+}
+
+void
+TextCache::flush(sf::RenderTarget& renderTarget)
+{
+  for(auto i = batchMap.begin(); i != batchMap.end(); i++)
+  {
+    sf::VertexArray& vertexArray = i->second;
+    if(vertexArray.getVertexCount() == 0) continue;
+    
+    // Texture has to be fetched now, glyphs could have been added to it
+    sf::RenderStates renderStates(&font->getTexture(i->first));
+    renderTarget.draw(vertexArray, renderStates);
+    
+    vertexArray.clear();
+  }
+}
+
+void
+TextCache::layoutText(TextLayout& textLayout, const std::string& text, uint32 characterSize) const
+{
+  // Same placement as sf::Text without styles
+  float horizontalSpace = font->getGlyph(L' ', characterSize, false).advance;
+  float verticalSpace = font->getLineSpacing(characterSize);
+  
+  float x = 0.0f;
+  float y = (float)characterSize;
+
+  float minX = (float)characterSize;
+  float minY = (float)characterSize;
+  float maxX = 0.0f;
+  float maxY = 0.0f;
+
+  textLayout.vertices.clear();
+  textLayout.localBounds = sf::FloatRect();
+  if(text.empty()) return;
+  
+  textLayout.vertices.reserve(text.size() * 4);
+  sf::Uint32 previousCharacter = 0;
+  
+  for(auto i = text.begin(); i != text.end(); i++)
+  {
+    sf::Uint32 currentCharacter = (unsigned char)*i;
+
+    x += font->getKerning(previousCharacter, currentCharacter, characterSize);
+    previousCharacter = currentCharacter;
+
+    if(currentCharacter == ' ' || currentCharacter == '\t' || currentCharacter == '\n')
+    {
+      minX = std::min(minX, x);
+      minY = std::min(minY, y);
+      
+      switch(currentCharacter)
+      {
+      case ' ': x += horizontalSpace; break;
+      case '\t': x += horizontalSpace * 4; break;
+      case '\n': y += verticalSpace; x = 0; break;
+      }
+
+      maxX = std::max(maxX, x);
+      maxY = std::max(maxY, y);
+      continue;
+    }
+
+    const sf::Glyph& glyph = font->getGlyph(currentCharacter, characterSize, false);
+    
+    float left = glyph.bounds.left;
+    float top = glyph.bounds.top;
+    float right = glyph.bounds.left + glyph.bounds.width;
+    float bottom = glyph.bounds.top + glyph.bounds.height;
+
+    float u1 = (float)glyph.textureRect.left;
+    float v1 = (float)glyph.textureRect.top;
+    float u2 = (float)(glyph.textureRect.left + glyph.textureRect.width);
+    float v2 = (float)(glyph.textureRect.top + glyph.textureRect.height);
+
+    textLayout.vertices.push_back(sf::Vertex(sf::Vector2f(x + left, y + top), sf::Color::White, sf::Vector2f(u1, v1)));
+    textLayout.vertices.push_back(sf::Vertex(sf::Vector2f(x + right, y + top), sf::Color::White, sf::Vector2f(u2, v1)));
+    textLayout.vertices.push_back(sf::Vertex(sf::Vector2f(x + right, y + bottom), sf::Color::White, sf::Vector2f(u2, v2)));
+    textLayout.vertices.push_back(sf::Vertex(sf::Vector2f(x + left, y + bottom), sf::Color::White, sf::Vector2f(u1, v2)));
+
+    minX = std::min(minX, x + left);
+    maxX = std::max(maxX, x + right);
+    minY = std::min(minY, y + top);
+    maxY = std::max(maxY, y + bottom);
+
+    x += glyph.advance;
+  }
+
+  textLayout.localBounds = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include <jpb\Vector.h>
+#include "Types.h"
+
+// Glyph quads of a string relative to the text origin, colored white
+struct TextLayout {
+  std::vector<sf::Vertex> vertices;
+  sf::FloatRect localBounds;
+  uint64 lastUsedFrame;
+};
+
+typedef std::unordered_map<std::string, TextLayout> TextLayoutMap;
+
+class TextCache {
+public:
+  TextCache() : font(NULL), currentFrame(0) {}
+  
+  void setFont(sf::Font* font);
+  
+  // Layouts unused for a while are dropped once per frame
+  void nextFrame();
+
+  // Returns prepared layout, glyphs are laid out only on the first use
+  const TextLayout& getLayout(const std::string& text, uint32 characterSize);
+
+  // Puts text into the batch of its font texture, drawn on flush
+  void queueText(const TextLayout& textLayout, uint32 characterSize,
+		 const Vec2f& position, const sf::Color& color);
+
+  // Copies text quads into external vertex array (retained geometry)
+  void appendText(sf::VertexArray& vertexArray, const TextLayout& textLayout,
+		  const Vec2f& position, const sf::Color& color) const;
+
+  // Draws every queued text with one draw call per font texture
+  void flush(sf::RenderTarget& renderTarget);
+
+  const sf::Texture& getTexture(uint32 characterSize) const { return font->getTexture(characterSize); }
+  
+private:
+  sf::Font* font;
+  uint64 currentFrame;
+
+  // Every character size has its own font texture
+  std::unordered_map<uint32, TextLayoutMap> layoutMap;
+  std::unordered_map<uint32, sf::VertexArray> batchMap;
+
+  void layoutText(TextLayout& textLayout, const std::string& text, uint32 characterSize) const;
+};
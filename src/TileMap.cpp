@@ -2,7 +2,8 @@
 
 #include "TileMap.h"
 
-TileChunk::TileChunk(const uint32 width, const uint32 height)
+TileChunk::TileChunk(const uint32 width, const uint32 height) :
+  wallRectsDirty(false)
 {
   tileChunkData.resize(height);
   for(int i=0; i<height; i++)
@@ -21,7 +22,70 @@ void
 TileChunk::setTileType(const Vec2i& tilePosition,
 			    const TILE_TYPE tileValue)
 {
-  tileChunkData[tilePosition.y][tilePosition.x] = tileValue;
+  TILE_TYPE& tile = tileChunkData[tilePosition.y][tilePosition.x];
+  if(tile != tileValue && (tile == TILE_TYPE_WALL || tileValue == TILE_TYPE_WALL))
+  {
+    wallRectsDirty = true;
+  }
+  tile = tileValue;
+}
+
+void
+TileChunk::updateWallRects()
+{
+  if(!wallRectsDirty) return;
+
+  wallRects.clear();
+
+  int32 height = (int32)tileChunkData.size();
+  int32 width = height ? (int32)tileChunkData[0].size() : 0;
+  std::vector<bool> merged(width * height, false);
+
+  // Greedy meshing, each rect grows right first and then down as long as whole rows are walls
+  for(int32 y = 0; y < height; y++)
+  {
+    for(int32 x = 0; x < width; x++)
+    {
+      if(tileChunkData[y][x] != TILE_TYPE_WALL || merged[y * width + x]) continue;
+
+      int32 rectWidth = 1;
+      while(x + rectWidth < width &&
+	    tileChunkData[y][x + rectWidth] == TILE_TYPE_WALL &&
+	    !merged[y * width + x + rectWidth])
+      {
+	rectWidth++;
+      }
+
+      int32 rectHeight = 1;
+      while(y + rectHeight < height)
+      {
+	bool isWallRow = true;
+	for(int32 rowX = x; rowX < x + rectWidth; rowX++)
+	{
+	  if(tileChunkData[y + rectHeight][rowX] != TILE_TYPE_WALL ||
+	     merged[(y + rectHeight) * width + rowX])
+	  {
+	    isWallRow = false;
+	    break;
+	  }
+	}
+	if(!isWallRow) break;
+	rectHeight++;
+      }
+
+      for(int32 rectY = y; rectY < y + rectHeight; rectY++)
+      {
+	for(int32 rectX = x; rectX < x + rectWidth; rectX++)
+	{
+	  merged[rectY * width + rectX] = true;
+	}
+      }
+
+      wallRects.push_back(IntRect(x, y, rectWidth, rectHeight));
+    }
+  }
+
+  wallRectsDirty = false;
 }
 
 void
@@ -40,22 +104,32 @@ TileMap::setTileType(WorldPosition& tileWorldPosition, const TILE_TYPE tileType)
 }
 
 TILE_TYPE
-TileMap::getTileType(WorldPosition& tileWorldPosition) 
+TileMap::getTileType(WorldPosition& tileWorldPosition) const
 {
   tileWorldPosition.recanonicalize(tileChunkSize);
   
   // If The Chunk Doesn't exist we return void tile type  
-  if(!tileChunkMap.count(tileWorldPosition.tileChunkPosition))
+  auto tileChunkIt = tileChunkMap.find(tileWorldPosition.tileChunkPosition);
+  if(tileChunkIt == tileChunkMap.end())
   {
     return TILE_TYPE_VOID;
   }
   else
   {
-    return tileChunkMap[tileWorldPosition.tileChunkPosition]->getTileType(tileWorldPosition.tilePosition);
+    return tileChunkIt->second->getTileType(tileWorldPosition.tilePosition);
   }
   
 }
 
+void
+TileMap::updateWallRects()
+{
+  for(auto tileChunkIt = tileChunkMap.begin(); tileChunkIt != tileChunkMap.end(); tileChunkIt++)
+  {
+    tileChunkIt->second->updateWallRects();
+  }
+}
+
 void
 TileMap::recanonicalize(EntityPosition& entityPosition) const
 {
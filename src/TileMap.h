@@ -3,7 +3,9 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <assert.h>
 
+#include <jpb/Rect.h>
 #include "EntityPosition.h"
 
 enum TILE_TYPE{
@@ -17,9 +19,16 @@ enum TILE_TYPE{
 // TileChunkData[y][x] accessor order
 typedef std::vector<std::vector<TILE_TYPE>> TileChunkData;
 
+// Rects in tile coordinates of the chunk
+typedef std::vector<IntRect> TileRectList;
+
 class TileChunk{
  private:
   TileChunkData tileChunkData;
+
+  // Wall tiles greedily merged into as few rects as possible, used by collision
+  TileRectList wallRects;
+  bool wallRectsDirty;
   
 public:
   TileChunk(const uint32 width, const uint32 height);
@@ -28,6 +37,10 @@ public:
   void setTileType(const Vec2i& tilePosition, const TILE_TYPE tileType);
   
   const TileChunkData& getTileChunkData() const { return tileChunkData; } 
+
+  // Only rebuilds after wall tiles changed
+  void updateWallRects();
+  const TileRectList& getWallRects() const { assert(!wallRectsDirty); return wallRects; }
 };
 
 typedef std::shared_ptr<TileChunk> TileChunkPtr;
@@ -44,13 +57,16 @@ public:
   void setTileType(WorldPosition& tileWorldPosition, const TILE_TYPE tileType);
   bool isRectangleOfTileType(WorldPosition startPosition, Vec2i dimensions, TILE_TYPE tileType); 
   
-  // Can't Be const because of hashmap,
-  TILE_TYPE getTileType(WorldPosition& tileWorldPosition);
+  // Only reads the hashmap, so it's safe to call from render jobs
+  TILE_TYPE getTileType(WorldPosition& tileWorldPosition) const;
   const TileChunkMap& getTileChunkMap() const { return tileChunkMap; }
   
   void recanonicalize(EntityPosition& entityPosition) const;
   
   const Vec2i& getTileChunkSize() const { return tileChunkSize; }
+
+  // Has to be called after tiles change and before collision checks read wall rects
+  void updateWallRects();
   
 private:
   Vec2i tileChunkSize;
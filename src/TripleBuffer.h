@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include "Types.h"
+
+// Lock free handoff between one writer and one reader thread, writer never waits
+// and reader always gets the newest complete buffer
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : writeIndex(0), readIndex(1), readyState(2) {}
+
+  T& getWriteBuffer() { return buffers[writeIndex]; }
+  const T& getReadBuffer() const { return buffers[readIndex]; }
+
+  // Hands written buffer to the reader, writer continues with the one it replaced
+  void publish()
+  {
+    uint32 previousState = readyState.exchange(writeIndex | newDataFlag);
+    writeIndex = previousState & indexMask;
+  }
+
+  // Takes newest published buffer, returns false if nothing new was published
+  bool acquire()
+  {
+    if(!(readyState.load() & newDataFlag)) return false;
+
+    uint32 previousState = readyState.exchange(readIndex);
+    readIndex = previousState & indexMask;
+    return true;
+  }
+
+private:
+  static const uint32 indexMask = 3;
+  static const uint32 newDataFlag = 4;
+
+  T buffers[3];
+
+  uint32 writeIndex;
+  uint32 readIndex;
+
+  // Index of the ready buffer with newDataFlag if reader didn't take it yet
+  std::atomic<uint32> readyState;
+};
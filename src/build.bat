@@ -44,23 +44,66 @@ set FilesToCompile= ^
     ..\src\TileMap.cpp ^
     ..\src\LevelGenerator.cpp ^
     ..\src\Level.cpp ^
+    ..\src\SweptCollision.cpp ^
+    ..\src\FlowField.cpp ^
+    ..\src\RoomGraph.cpp ^
+    ..\src\AIScheduler.cpp ^
+    ..\src\Behaviour.cpp ^
+    ..\src\CollisionSnapshot.cpp ^
+    ..\src\ProjectileManager.cpp ^
     ..\src\Input.cpp ^
+    ..\src\JobSystem.cpp ^
     ..\src\Entity.cpp ^
     ..\src\LevelRenderer.cpp ^
+    ..\src\RenderSnapshot.cpp ^
     ..\src\SpriteManager.cpp ^
+    ..\src\TextCache.cpp ^
     ..\src\MiscFunctions.cpp ^
     ..\src\Mobs.cpp ^
     ..\src\main.cpp
 )
 
+REM Tests have their own main, so they're built from the files they need
+set TestFilesToCompile= ^
+    ..\src\test.cpp ^
+    ..\src\Event.cpp ^
+    ..\src\EventManager.cpp ^
+    ..\src\EntityPosition.cpp ^
+    ..\src\TileMap.cpp ^
+    ..\src\Level.cpp ^
+    ..\src\SweptCollision.cpp ^
+    ..\src\FlowField.cpp ^
+    ..\src\RoomGraph.cpp ^
+    ..\src\AIScheduler.cpp ^
+    ..\src\Behaviour.cpp ^
+    ..\src\CollisionSnapshot.cpp ^
+    ..\src\ProjectileManager.cpp ^
+    ..\src\JobSystem.cpp ^
+    ..\src\Entity.cpp ^
+    ..\src\Mobs.cpp
+
 REM Zi(Generate Debug information), FC(Full Path To Source), O2(Fast Code)
 
 set CompilerOptions=%Defines% /FC /Zi /EHsc /MD /MP /wd4503 /nologo /FeRoqueLike.exe /I%IncludeDirectory% /I..\libs\jpb
+set TestCompilerOptions=%Defines% /FC /Zi /EHsc /MD /MP /wd4503 /nologo /FeRoqueLikeTest.exe /I%IncludeDirectory% /I..\libs\jpb
 set LinkerOptions=/link /LIBPATH:%LibraryDirectory% /LIBPATH:..\libs\jpb\lib
 
 REM /SUBSYSTEM:windows
 cl %CompilerOptions% %FilesToCompile% %Libraries% %LinkerOptions%
 
+echo.
+echo compilingTest
+cl %TestCompilerOptions% %TestFilesToCompile% %Libraries% %LinkerOptions%
+
+echo.
+echo runningTest
+RoqueLikeTest.exe
+if errorlevel 1 (
+echo Tests failed
+popd
+exit /b 1
+)
+
 REM cd ../code
 REM start "" nmake
 
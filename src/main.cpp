@@ -8,12 +8,22 @@
 #include "Entity.cpp"
 #include "PlayerHud.cpp"
 #include "Input.cpp"
+#include "JobSystem.cpp"
 #include "Event.cpp"
 #include "EventManager.cpp"
 #include "Level.cpp"
+#include "SweptCollision.cpp"
+#include "FlowField.cpp"
+#include "RoomGraph.cpp"
+#include "AIScheduler.cpp"
+#include "Behaviour.cpp"
+#include "CollisionSnapshot.cpp"
+#include "ProjectileManager.cpp"
 #include "LevelRenderer.cpp"
+#include "RenderSnapshot.cpp"
 #include "LevelGenerator.cpp"
 #include "SpriteManager.cpp"
+#include "TextCache.cpp"
 
 #endif
 
@@ -0,0 +1,262 @@
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "RoomGraph.h"
+#include "TileMap.h"
+#include "Level.h"
+#include "Mobs.h"
+#include "EventManager.h"
+#include "JobSystem.h"
+
+// Walls around the floor, like the level generator places rooms
+static void
+placeRoom(TileMap& tileMap, const Vec2i& topLeftCorner, const Vec2i& dimensions)
+{
+  for(int32 y = 0; y < dimensions.y; y++)
+  {
+    for(int32 x = 0; x < dimensions.x; x++)
+    {
+      bool isWall = x == 0 || y == 0 || x == dimensions.x - 1 || y == dimensions.y - 1;
+      WorldPosition tile(Vec3i(0, 0, 0), topLeftCorner + Vec2i(x, y));
+      tileMap.setTileType(tile, isWall ? TILE_TYPE_WALL : TILE_TYPE_STONE_GROUND);
+    }
+  }
+}
+
+static void
+setTile(TileMap& tileMap, const Vec2i& absoluteTile, TILE_TYPE tileType)
+{
+  WorldPosition tile(Vec3i(0, 0, 0), absoluteTile);
+  tileMap.setTileType(tile, tileType);
+}
+
+static Vec2i
+toAbsoluteTile(const WorldPosition& tile, const Vec2i& tileChunkSize)
+{
+  return Vec2i(tile.tileChunkPosition.x * tileChunkSize.x + tile.tilePosition.x,
+	       tile.tileChunkPosition.y * tileChunkSize.y + tile.tilePosition.y);
+}
+
+// Two rooms sharing a wall with an opening in it, a pillar in the first one is walked around
+bool roomGraphTest()
+{
+  Vec2i tileChunkSize(16, 16);
+  TileMap tileMap(tileChunkSize);
+  RoomGraph roomGraph(tileChunkSize);
+
+  // Floor of the first room is x 1..4, y 1..3, the second one shares its wall at x 5
+  placeRoom(tileMap, Vec2i(0, 0), Vec2i(6, 5));
+  placeRoom(tileMap, Vec2i(5, 0), Vec2i(6, 5));
+  setTile(tileMap, Vec2i(5, 2), TILE_TYPE_STONE_GROUND);
+  setTile(tileMap, Vec2i(3, 1), TILE_TYPE_WALL);
+  setTile(tileMap, Vec2i(3, 2), TILE_TYPE_WALL);
+
+  int32 roomIndex1 = roomGraph.addRoom(WorldPosition(Vec3i(0, 0, 0), Vec2i(0, 0)), Vec2i(6, 5));
+  int32 roomIndex2 = roomGraph.addRoom(WorldPosition(Vec3i(0, 0, 0), Vec2i(5, 0)), Vec2i(6, 5));
+  roomGraph.addPortal(roomIndex1, roomIndex2, WorldPosition(Vec3i(0, 0, 0), Vec2i(5, 2)));
+
+  WorldPosition start(Vec3i(0, 0, 0), Vec2i(1, 1));
+  WorldPosition goal(Vec3i(0, 0, 0), Vec2i(8, 2));
+
+  TilePath path;
+  bool correct = roomGraph.findPath(tileMap, start, goal, path);
+
+  // Down to the gap under the pillar, back up to the opening and straight to the goal
+  correct = correct && path.size() == 11;
+  correct = correct && path.front() == start && path.back() == goal;
+
+  bool isThroughPortal = false;
+  for(size_t i = 0; correct && i < path.size(); i++)
+  {
+    WorldPosition tile = path[i];
+    correct = tileMap.getTileType(tile) != TILE_TYPE_WALL;
+
+    Vec2i absoluteTile = toAbsoluteTile(path[i], tileChunkSize);
+    if(absoluteTile == Vec2i(5, 2)) isThroughPortal = true;
+
+    if(i > 0)
+    {
+      Vec2i step = absoluteTile - toAbsoluteTile(path[i - 1], tileChunkSize);
+      correct = correct && abs(step.x) + abs(step.y) == 1;
+    }
+  }
+  correct = correct && isThroughPortal;
+
+  // Nothing leads out of the rooms
+  WorldPosition outside(Vec3i(0, 0, 0), Vec2i(14, 2));
+  correct = correct && !roomGraph.findPath(tileMap, start, outside, path);
+
+  std::cout << "Room graph test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Runs the level like the game does with a fixed step
+static void
+runLevel(Level& level, EventManager& eventManager, float seconds)
+{
+  const float lastDelta = 1.0f / 60.0f;
+  for(float time = 0; time < seconds; time += lastDelta)
+  {
+    level.registerPendingEntities(eventManager);
+    level.update(lastDelta);
+    level.removeDeadEntities();
+  }
+}
+
+// Tiles from the corner of the map, for positions in the first chunks
+static float
+getTileX(const EntityPosition& position, const Vec2i& tileChunkSize)
+{
+  return position.worldPosition.tileChunkPosition.x * tileChunkSize.x +
+    position.worldPosition.tilePosition.x + position.tileOffset.x;
+}
+
+// Rat sniffing into a wall has to turn around instead of pushing against it
+bool ratWallTest()
+{
+  Level level;
+  EventManager eventManager;
+  const Vec2i& tileChunkSize = level.getTileMap()->getTileChunkSize();
+
+  // Floor is x 1..10, y 1..3
+  placeRoom(*level.getTileMap(), Vec2i(0, 0), Vec2i(12, 5));
+
+  // Wandering right for longer than the test runs
+  WorldPosition ratTile(Vec3i(0, 0, 0), Vec2i(6, 1));
+  Rat* rat = new Rat(EntityPosition(ratTile), 1, Vec2f(1.0f, 0), 100.0f);
+  EntityPtr ratPtr(rat);
+  bool correct = level.addEntity(ratPtr);
+
+  // Hits the wall within the first second, then has a second to walk away from it
+  float maxTileX = 0;
+  for(int32 i = 0; i < 8; i++)
+  {
+    runLevel(level, eventManager, 0.25f);
+    maxTileX = std::max(maxTileX, getTileX(rat->getPosition(), tileChunkSize));
+  }
+
+  float tileX = getTileX(rat->getPosition(), tileChunkSize);
+  correct = correct && rat->isAlive() && maxTileX > 9.0f && tileX < maxTileX - 1.0f;
+
+  std::cout << "Rat wall test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Projectile slowing below the minimum speed still makes its last move, a rat just within
+// that move's reach gets hit
+bool slowProjectileTest()
+{
+  Level level;
+  EventManager eventManager;
+
+  placeRoom(*level.getTileMap(), Vec2i(0, 0), Vec2i(12, 5));
+
+  // Standing still, collision rect spans x 8.1 .. 8.9 and y 2.7 .. 3.0
+  WorldPosition ratTile(Vec3i(0, 0, 0), Vec2i(8, 2));
+  Rat* rat = new Rat(EntityPosition(ratTile), 1, Vec2f(), 100.0f);
+  EntityPtr ratPtr(rat);
+  bool correct = level.addEntity(ratPtr);
+  level.registerPendingEntities(eventManager);
+
+  // 0.01 tiles in front of the rat, slows below the minimum on its first move of 1/60 tiles
+  WorldPosition projectileTile(Vec3i(0, 0, 0), Vec2i(7, 2));
+  Vec2f projectileOffset(0.89f, 0.75f);
+  Projectile projectile(EntityPosition(projectileTile, projectileOffset),
+			Vec2f(minProjectileSpeed + 0.00001f, 0), Vec2f(0.2f, 0.2f), 1.0f);
+  correct = correct && level.spawnProjectile(projectile);
+
+  float health = rat->getHealth();
+  runLevel(level, eventManager, 1.0f / 60.0f);
+
+  correct = correct && rat->getHealth() < health;
+  correct = correct && level.getProjectileManager().getCount() == 0;
+
+  std::cout << "Slow projectile test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Projectile flying across the room hits the rat in its way and leaves the one behind it alone
+bool projectileHitTest()
+{
+  Level level;
+  EventManager eventManager;
+
+  placeRoom(*level.getTileMap(), Vec2i(0, 0), Vec2i(12, 5));
+
+  // Standing still, collision rects span y 2.7 .. 3.0
+  WorldPosition ratTile(Vec3i(0, 0, 0), Vec2i(8, 2));
+  Rat* rat = new Rat(EntityPosition(ratTile), 1, Vec2f(), 100.0f);
+  EntityPtr ratPtr(rat);
+  bool correct = level.addEntity(ratPtr);
+
+  WorldPosition behindRatTile(Vec3i(0, 0, 0), Vec2i(2, 2));
+  Rat* behindRat = new Rat(EntityPosition(behindRatTile), 1, Vec2f(), 100.0f);
+  EntityPtr behindRatPtr(behindRat);
+  correct = correct && level.addEntity(behindRatPtr);
+  level.registerPendingEntities(eventManager);
+
+  // Needs about half a second to reach the rat
+  WorldPosition projectileTile(Vec3i(0, 0, 0), Vec2i(3, 2));
+  Projectile projectile(EntityPosition(projectileTile, Vec2f(0.5f, 0.75f)),
+			Vec2f(10.0f, 0), Vec2f(0.2f, 0.2f), 1.0f);
+  correct = correct && level.spawnProjectile(projectile);
+
+  float health = rat->getHealth();
+  float behindRatHealth = behindRat->getHealth();
+  runLevel(level, eventManager, 1.0f);
+
+  correct = correct && rat->getHealth() < health;
+  correct = correct && behindRat->getHealth() == behindRatHealth;
+  correct = correct && level.getProjectileManager().getCount() == 0;
+
+  std::cout << "Projectile hit test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+// Spawner charges only from its behaviour, the first mob comes once the spawn period passed
+bool spawnerTest()
+{
+  Level level;
+  EventManager eventManager;
+
+  placeRoom(*level.getTileMap(), Vec2i(0, 0), Vec2i(16, 9));
+
+  WorldPosition playerTile(Vec3i(0, 0, 0), Vec2i(2, 2));
+  Player* player = new Player(EntityPosition(playerTile));
+  EntityPtr playerPtr(player);
+  bool correct = level.addEntity(playerPtr);
+  level.setPlayer(player);
+
+  // Level 1 spawns every 9.5 seconds
+  WorldPosition spawnerTile(Vec3i(0, 0, 0), Vec2i(8, 4));
+  EntityPtr spawnerPtr(new MobSpawner(EntityPosition(spawnerTile), 1, MT_RAT, 0));
+  correct = correct && level.addEntity(spawnerPtr);
+
+  runLevel(level, eventManager, 9.0f);
+  correct = correct && level.getEntityList().size() == 2;
+
+  runLevel(level, eventManager, 1.0f);
+  level.registerPendingEntities(eventManager);
+  correct = correct && level.getEntityList().size() == 3;
+
+  std::cout << "Spawner test: " << (correct ? "Passed" : "Failed") << std::endl;
+  return correct;
+}
+
+int main()
+{
+  JobSystem::create();
+
+  // Non-zero exit code when any test fails so the build notices
+  int32 failedCount = 0;
+  if(!roomGraphTest()) failedCount++;
+  if(!ratWallTest()) failedCount++;
+  if(!slowProjectileTest()) failedCount++;
+  if(!projectileHitTest()) failedCount++;
+  if(!spawnerTest()) failedCount++;
+
+  JobSystem::destroy();
+
+  return failedCount;
+}